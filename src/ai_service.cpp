@@ -0,0 +1,652 @@
+#include "ai_service.h"
+#include "timing.h"
+#include "games/tictactoe.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define AI_MAX_EVENTS 256
+#define AI_READ_BUFFER_SIZE 16384
+#define AI_BATCH_CAPACITY 4096
+#define AI_BOARD_POSITIONS 19683   // 3^9
+#define AI_CLIENT_WINDOW 512       // Requests in flight per benchmark client
+#define AI_CLIENT_POSITIONS 4096
+#define AI_OUTPUT_LIMIT (1 << 20)   // Unsent answer bytes before reading stops
+
+typedef struct AIConnection {
+    int fd;
+    unsigned char in[AI_READ_BUFFER_SIZE];
+    size_t in_length;
+    unsigned char* out;
+    size_t out_length;
+    size_t out_capacity;
+    bool dirty;       // On the server's dirty list this round
+    struct AIConnection* next_dirty;
+    bool closing;     // Peer hung up; close once its answers are flushed
+    bool want_write;  // Registered for EPOLLOUT after a short write
+    bool paused;      // EPOLLIN dropped until the client reads its answers
+    bool close_queued;
+    struct AIConnection* next_close;
+} AIConnection;
+
+typedef struct {
+    AIConnection* connection;
+    uint32_t request_id;
+    uint32_t board;
+    uint8_t ai_player;
+    uint8_t difficulty;
+    double received_time;
+} AIQuery;
+
+typedef struct {
+    int epoll_fd;
+    AIQuery batch[AI_BATCH_CAPACITY];
+    int batch_count;
+    AIConnection* dirty_head;   // Connections to flush (or close) this round
+    AIConnection* close_head;   // Freed once the round's parsing is done
+
+    // Stats for the current reporting interval
+    unsigned long queries;
+    unsigned long cached;
+    unsigned long batches;
+    double latency_sum;
+    double latency_max;
+    double interval_start;
+} AIServer;
+
+static volatile sig_atomic_t server_stopping = 0;
+
+// Best hard-difficulty move per position and side; -2 = not solved yet.
+// Hard play is deterministic, so each position is searched at most once.
+static int8_t solved_moves[2][AI_BOARD_POSITIONS];
+static bool solved_moves_ready = false;
+
+static void handle_stop_signal(int signal_number) {
+    (void)signal_number;
+    server_stopping = 1;
+}
+
+static void write_u32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value & 0xff);
+    out[1] = (unsigned char)((value >> 8) & 0xff);
+    out[2] = (unsigned char)((value >> 16) & 0xff);
+    out[3] = (unsigned char)((value >> 24) & 0xff);
+}
+
+static uint32_t read_u32(const unsigned char* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Address parsing shared by server and client
+static int open_socket_for_address(const char* address, struct sockaddr_storage* storage, socklen_t* length) {
+    memset(storage, 0, sizeof(*storage));
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un* un = (struct sockaddr_un*)storage;
+        const char* path = address + 5;
+        if (strlen(path) == 0 || strlen(path) >= sizeof(un->sun_path)) {
+            return -1;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, path);
+        *length = sizeof(struct sockaddr_un);
+        return socket(AF_UNIX, SOCK_STREAM, 0);
+    }
+
+    if (strncmp(address, "tcp:", 4) == 0) {
+        int port = atoi(address + 4);
+        if (port <= 0 || port > 65535) {
+            return -1;
+        }
+        struct sockaddr_in* in = (struct sockaddr_in*)storage;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        *length = sizeof(struct sockaddr_in);
+        return socket(AF_INET, SOCK_STREAM, 0);
+    }
+
+    return -1;
+}
+
+static void set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void set_nodelay(int fd, const struct sockaddr_storage* storage) {
+    if (storage->ss_family == AF_INET) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+}
+
+// Position decoding and answering
+static bool decode_board(uint32_t board, TicTacToeGameState* game, int* position_index) {
+    memset(game, 0, sizeof(*game));
+    *position_index = 0;
+
+    if (board >> 18) return false;
+
+    for (int cell = 8; cell >= 0; cell--) {
+        int value = (int)((board >> (cell * 2)) & 3);
+        if (value > 2) return false;
+        game->board[cell / 3][cell % 3] = (TicTacToeCellState)value;
+        *position_index = *position_index * 3 + value;
+    }
+    return true;
+}
+
+static int answer_query(const AIQuery* query, uint8_t* status) {
+    TicTacToeGameState game;
+    int position_index;
+
+    if ((query->ai_player != TICTACTOE_CELL_X && query->ai_player != TICTACTOE_CELL_O) ||
+        query->difficulty > TICTACTOE_DIFFICULTY_HARD ||
+        !decode_board(query->board, &game, &position_index)) {
+        *status = AI_STATUS_BAD_REQUEST;
+        return -1;
+    }
+
+    TicTacToeCellState ai_player = (TicTacToeCellState)query->ai_player;
+    game.current_player = ai_player;
+    game.game_active = true;
+
+    if (query->difficulty != TICTACTOE_DIFFICULTY_HARD) {
+        *status = AI_STATUS_OK;
+        return tictactoe_get_ai_move(&game, ai_player, (TicTacToeAIDifficulty)query->difficulty);
+    }
+
+    int8_t* solved = &solved_moves[ai_player - 1][position_index];
+    if (*solved != -2) {
+        *status = AI_STATUS_CACHED;
+        return *solved;
+    }
+
+    *solved = (int8_t)tictactoe_get_ai_move(&game, ai_player, TICTACTOE_DIFFICULTY_HARD);
+    *status = AI_STATUS_OK;
+    return *solved;
+}
+
+// Connections
+static AIConnection* create_connection(int fd) {
+    AIConnection* connection = (AIConnection*)calloc(1, sizeof(AIConnection));
+    if (!connection) return NULL;
+    connection->fd = fd;
+    return connection;
+}
+
+static void close_connection(AIServer* server, AIConnection* connection) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    free(connection->out);
+    free(connection);
+}
+
+// A batch can fill, and be flushed, while a connection is still being
+// parsed, and a connection may have more events later in the round, so
+// connections are only freed by close_queued_connections
+static void queue_close(AIServer* server, AIConnection* connection) {
+    if (!connection->close_queued) {
+        connection->close_queued = true;
+        connection->next_close = server->close_head;
+        server->close_head = connection;
+    }
+}
+
+static void close_queued_connections(AIServer* server) {
+    while (server->close_head) {
+        AIConnection* connection = server->close_head;
+        server->close_head = connection->next_close;
+        close_connection(server, connection);
+    }
+}
+
+static void mark_dirty(AIServer* server, AIConnection* connection) {
+    if (!connection->dirty) {
+        connection->dirty = true;
+        connection->next_dirty = server->dirty_head;
+        server->dirty_head = connection;
+    }
+}
+
+static bool append_output(AIConnection* connection, const unsigned char* data, size_t length) {
+    if (connection->out_length + length > connection->out_capacity) {
+        size_t capacity = connection->out_capacity ? connection->out_capacity * 2 : 4096;
+        while (capacity < connection->out_length + length) capacity *= 2;
+        unsigned char* out = (unsigned char*)realloc(connection->out, capacity);
+        if (!out) return false;
+        connection->out = out;
+        connection->out_capacity = capacity;
+    }
+    memcpy(connection->out + connection->out_length, data, length);
+    connection->out_length += length;
+    return true;
+}
+
+// Waits for EPOLLOUT while answers are pending, and stops reading a
+// client that leaves AI_OUTPUT_LIMIT bytes of them unread
+static void update_connection_events(AIServer* server, AIConnection* connection) {
+    bool want_write = connection->out_length > 0;
+    bool paused = connection->out_length >= AI_OUTPUT_LIMIT;
+    if (want_write == connection->want_write && paused == connection->paused) {
+        return;
+    }
+
+    struct epoll_event event;
+    event.events = (paused ? 0u : (uint32_t)EPOLLIN) | (want_write ? (uint32_t)EPOLLOUT : 0u);
+    event.data.ptr = connection;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->want_write = want_write;
+    connection->paused = paused;
+}
+
+// Writes what the socket takes; waits for EPOLLOUT if anything is left
+static bool flush_connection(AIServer* server, AIConnection* connection) {
+    size_t written = 0;
+    while (written < connection->out_length) {
+        ssize_t result = send(connection->fd, connection->out + written,
+                              connection->out_length - written, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        written += (size_t)result;
+    }
+
+    memmove(connection->out, connection->out + written, connection->out_length - written);
+    connection->out_length -= written;
+
+    update_connection_events(server, connection);
+    return true;
+}
+
+// Answers every query gathered this round, then writes once per connection
+static void process_batch(AIServer* server) {
+    for (int i = 0; i < server->batch_count; i++) {
+        const AIQuery* query = &server->batch[i];
+        if (query->connection->close_queued) {
+            continue;
+        }
+
+        uint8_t status;
+        int move = answer_query(query, &status);
+
+        double latency = get_monotonic_time() - query->received_time;
+        server->latency_sum += latency;
+        if (latency > server->latency_max) server->latency_max = latency;
+        server->queries++;
+        if (status == AI_STATUS_CACHED) server->cached++;
+
+        unsigned char response[AI_RESPONSE_SIZE];
+        write_u32(response, query->request_id);
+        response[4] = (unsigned char)(int8_t)move;
+        response[5] = status;
+        write_u32(response + 6, (uint32_t)(latency * 1e9));
+
+        // Out of memory for this client's answers: drop it rather than
+        // leave it waiting on replies that never come
+        if (!append_output(query->connection, response, sizeof(response))) {
+            queue_close(server, query->connection);
+            continue;
+        }
+        mark_dirty(server, query->connection);
+    }
+
+    if (server->batch_count > 0) {
+        server->batches++;
+    }
+    server->batch_count = 0;
+
+    while (server->dirty_head) {
+        AIConnection* connection = server->dirty_head;
+        server->dirty_head = connection->next_dirty;
+        connection->dirty = false;
+        if (connection->close_queued) {
+            continue;
+        }
+        if (!flush_connection(server, connection)) {
+            connection->closing = true;
+            connection->out_length = 0;
+        }
+        if (connection->closing && connection->out_length == 0) {
+            queue_close(server, connection);
+        }
+    }
+}
+
+// Splits buffered bytes into queries; a full batch is answered on the spot
+static void parse_requests(AIServer* server, AIConnection* connection, double received_time) {
+    size_t offset = 0;
+
+    while (connection->in_length - offset >= AI_REQUEST_SIZE) {
+        if (server->batch_count == AI_BATCH_CAPACITY) {
+            process_batch(server);
+        }
+
+        const unsigned char* frame = connection->in + offset;
+        AIQuery* query = &server->batch[server->batch_count++];
+        query->connection = connection;
+        query->request_id = read_u32(frame);
+        query->board = read_u32(frame + 4);
+        query->ai_player = frame[8];
+        query->difficulty = frame[9];
+        query->received_time = received_time;
+        offset += AI_REQUEST_SIZE;
+    }
+
+    memmove(connection->in, connection->in + offset, connection->in_length - offset);
+    connection->in_length -= offset;
+}
+
+static void read_connection(AIServer* server, AIConnection* connection) {
+    for (;;) {
+        ssize_t result = read(connection->fd, connection->in + connection->in_length,
+                              sizeof(connection->in) - connection->in_length);
+        if (result > 0) {
+            connection->in_length += (size_t)result;
+            parse_requests(server, connection, get_monotonic_time());
+            // A full batch may have been answered, and the client dropped
+            // or paused, while parsing
+            if (connection->close_queued || connection->paused) return;
+            continue;
+        }
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        // EOF or error; queries already batched still get answered
+        connection->closing = true;
+        mark_dirty(server, connection);
+        return;
+    }
+}
+
+static void accept_connections(AIServer* server, int listen_fd, const struct sockaddr_storage* storage) {
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) return;
+
+        set_nonblocking(fd);
+        set_nodelay(fd, storage);
+
+        AIConnection* connection = create_connection(fd);
+        if (!connection) {
+            close(fd);
+            continue;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(connection);
+        }
+    }
+}
+
+static void report_server_stats(AIServer* server, double now) {
+    double elapsed = now - server->interval_start;
+    if (server->queries > 0) {
+        fprintf(stderr, "%9.0f queries/s  avg %7.2f us  max %8.2f us  %5.1f%% cached  %6.1f queries/batch\n",
+                server->queries / elapsed,
+                server->latency_sum * 1e6 / server->queries,
+                server->latency_max * 1e6,
+                100.0 * server->cached / server->queries,
+                (double)server->queries / (server->batches ? server->batches : 1));
+    }
+
+    server->queries = 0;
+    server->cached = 0;
+    server->batches = 0;
+    server->latency_sum = 0.0;
+    server->latency_max = 0.0;
+    server->interval_start = now;
+}
+
+int run_ai_server(const char* address) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    int listen_fd = open_socket_for_address(address, &storage, &length);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Invalid address '%s' (use unix:PATH or tcp:PORT)\n", address);
+        return 2;
+    }
+
+    if (storage.ss_family == AF_UNIX) {
+        unlink(((struct sockaddr_un*)&storage)->sun_path);
+    } else {
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+
+    if (bind(listen_fd, (struct sockaddr*)&storage, length) != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+        perror("ai server");
+        close(listen_fd);
+        return 1;
+    }
+    set_nonblocking(listen_fd);
+
+    if (!solved_moves_ready) {
+        memset(solved_moves, -2, sizeof(solved_moves));
+        solved_moves_ready = true;
+    }
+
+    AIServer* server = (AIServer*)calloc(1, sizeof(AIServer));
+    if (!server) {
+        close(listen_fd);
+        return 1;
+    }
+    server->epoll_fd = epoll_create1(0);
+    server->interval_start = get_monotonic_time();
+
+    struct epoll_event listen_event;
+    listen_event.events = EPOLLIN;
+    listen_event.data.ptr = NULL;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "AI service listening on %s\n", address);
+
+    struct epoll_event events[AI_MAX_EVENTS];
+    while (!server_stopping) {
+        int count = epoll_wait(server->epoll_fd, events, AI_MAX_EVENTS, 1000);
+        if (count < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        // Gather from every ready connection first, then answer in one batch
+        for (int i = 0; i < count; i++) {
+            AIConnection* connection = (AIConnection*)events[i].data.ptr;
+            if (!connection) {
+                accept_connections(server, listen_fd, &storage);
+                continue;
+            }
+            if (connection->close_queued) {
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                mark_dirty(server, connection);
+            }
+            if (connection->paused) {
+                // Not reading; a hang-up shows up as a failed flush
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    mark_dirty(server, connection);
+                }
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                read_connection(server, connection);
+            }
+        }
+        process_batch(server);
+        close_queued_connections(server);
+
+        double now = get_monotonic_time();
+        if (now - server->interval_start >= 1.0) {
+            report_server_stats(server, now);
+        }
+    }
+
+    report_server_stats(server, get_monotonic_time());
+
+    // Remaining connections are reclaimed by process exit
+    close(server->epoll_fd);
+    close(listen_fd);
+    if (storage.ss_family == AF_UNIX) {
+        unlink(((struct sockaddr_un*)&storage)->sun_path);
+    }
+    free(server);
+    return 0;
+}
+
+// Benchmark client
+static uint32_t encode_random_position(unsigned int* seed, uint8_t* ai_player) {
+    int board[9] = {0};
+    int player = TICTACTOE_CELL_X;
+    int move_count = (int)(rand_r(seed) % 8);
+
+    for (int i = 0; i < move_count; i++) {
+        int cell;
+        do {
+            cell = (int)(rand_r(seed) % 9);
+        } while (board[cell] != 0);
+        board[cell] = player;
+        player = (player == TICTACTOE_CELL_X) ? TICTACTOE_CELL_O : TICTACTOE_CELL_X;
+    }
+
+    uint32_t encoded = 0;
+    for (int cell = 0; cell < 9; cell++) {
+        encoded |= (uint32_t)board[cell] << (cell * 2);
+    }
+    *ai_player = (uint8_t)player;
+    return encoded;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int run_ai_client_benchmark(const char* address, int query_count) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    int fd = open_socket_for_address(address, &storage, &length);
+    if (fd < 0) {
+        fprintf(stderr, "Invalid address '%s' (use unix:PATH or tcp:PORT)\n", address);
+        return 2;
+    }
+    if (connect(fd, (struct sockaddr*)&storage, length) != 0) {
+        perror("connect");
+        close(fd);
+        return 1;
+    }
+    set_nodelay(fd, &storage);
+
+    uint32_t positions[AI_CLIENT_POSITIONS];
+    uint8_t players[AI_CLIENT_POSITIONS];
+    unsigned int seed = 2024;
+    for (int i = 0; i < AI_CLIENT_POSITIONS; i++) {
+        positions[i] = encode_random_position(&seed, &players[i]);
+    }
+
+    double* send_times = (double*)malloc(sizeof(double) * query_count);
+    double* round_trips = (double*)malloc(sizeof(double) * query_count);
+    if (!send_times || !round_trips) {
+        free(send_times);
+        free(round_trips);
+        close(fd);
+        return 1;
+    }
+
+    unsigned char out[AI_CLIENT_WINDOW * AI_REQUEST_SIZE];
+    unsigned char in[AI_CLIENT_WINDOW * AI_RESPONSE_SIZE];
+    size_t in_length = 0;
+    int sent = 0;
+    int received = 0;
+    int failed = 0;
+    bool connected = true;
+    double start = get_monotonic_time();
+
+    while (connected && received < query_count) {
+        // Top the pipeline up to the window
+        size_t out_length = 0;
+        double now = get_monotonic_time();
+        while (sent < query_count && sent - received < AI_CLIENT_WINDOW) {
+            unsigned char* frame = out + out_length;
+            write_u32(frame, (uint32_t)sent);
+            write_u32(frame + 4, positions[sent % AI_CLIENT_POSITIONS]);
+            frame[8] = players[sent % AI_CLIENT_POSITIONS];
+            frame[9] = TICTACTOE_DIFFICULTY_HARD;
+            send_times[sent] = now;
+            out_length += AI_REQUEST_SIZE;
+            sent++;
+        }
+
+        size_t written = 0;
+        while (connected && written < out_length) {
+            ssize_t result = write(fd, out + written, out_length - written);
+            if (result <= 0) {
+                connected = false;
+            } else {
+                written += (size_t)result;
+            }
+        }
+
+        ssize_t result = connected ? read(fd, in + in_length, sizeof(in) - in_length) : -1;
+        if (result <= 0) {
+            fprintf(stderr, "Lost connection to the server\n");
+            connected = false;
+            break;
+        }
+        in_length += (size_t)result;
+        now = get_monotonic_time();
+
+        size_t offset = 0;
+        while (in_length - offset >= AI_RESPONSE_SIZE) {
+            uint32_t request_id = read_u32(in + offset);
+            if (request_id < (uint32_t)query_count) {
+                round_trips[received] = now - send_times[request_id];
+            }
+            if (in[offset + 5] == AI_STATUS_BAD_REQUEST) failed++;
+            received++;
+            offset += AI_RESPONSE_SIZE;
+        }
+        memmove(in, in + offset, in_length - offset);
+        in_length -= offset;
+    }
+
+    double elapsed = get_monotonic_time() - start;
+    if (received > 0) {
+        qsort(round_trips, (size_t)received, sizeof(double), compare_doubles);
+        printf("AI service benchmark: %d queries over %s\n", received, address);
+        printf("  %10.0f queries/s\n", received / elapsed);
+        printf("  %10.2f us p50 round trip\n", round_trips[received / 2] * 1e6);
+        printf("  %10.2f us p99 round trip\n", round_trips[(int)(received * 0.99)] * 1e6);
+        printf("  %10d rejected\n", failed);
+    }
+
+    free(send_times);
+    free(round_trips);
+    close(fd);
+    return received == query_count ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+#ifndef AI_SERVICE_H
+#define AI_SERVICE_H
+
+#include <stdint.h>
+
+// Wire format, all integers little-endian, frames back to back on a stream.
+//
+// Request (10 bytes):
+//   u32 request_id   echoed in the response
+//   u32 board        2 bits per cell, cell (row * 3 + col) at bit 2 * cell;
+//                    0 = empty, 1 = X, 2 = O
+//   u8  ai_player    1 = X, 2 = O
+//   u8  difficulty   0 = easy, 1 = medium, 2 = hard
+//
+// Response (10 bytes):
+//   u32 request_id
+//   i8  move         row * 3 + col, or -1 if the board is full
+//   u8  status       AI_STATUS_*
+//   u32 latency_ns   time from reading the request to queueing the answer
+#define AI_REQUEST_SIZE 10
+#define AI_RESPONSE_SIZE 10
+
+#define AI_STATUS_OK 0
+#define AI_STATUS_CACHED 1      // Answered from the solved-position cache
+#define AI_STATUS_BAD_REQUEST 2
+
+// Addresses: "unix:/path/to.sock" or "tcp:PORT" (loopback only)
+
+// Serves queries until SIGINT/SIGTERM; prints throughput and latency
+// once per second to stderr
+int run_ai_server(const char* address);
+
+// Pipelines query_count random positions to a running server and
+// reports throughput and round-trip latency
+int run_ai_client_benchmark(const char* address, int query_count);
+
+#endif
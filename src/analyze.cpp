@@ -0,0 +1,504 @@
+#include "analyze.h"
+#include "hints.h"
+#include "timing.h"
+#include "trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef enum {
+    BLOCK_FREE,
+    BLOCK_READ,         // Whole lines, waiting for a worker
+    BLOCK_CLAIMED,
+    BLOCK_EVALUATED     // Output ready, waiting for the writer
+} BlockState;
+
+typedef struct {
+    BlockState state;
+    char* input;                // ANALYZE_BLOCK_SIZE bytes
+    size_t input_start;         // Lines are [input_start, input_length)
+    size_t input_length;
+    char* output;
+    size_t output_length;
+    unsigned long long positions;
+} AnalysisBlock;
+
+// Block n of the input lives in blocks[n % block_count]; the counters
+// only grow, so each thread knows which block comes next
+typedef struct {
+    AnalysisBlock* blocks;
+    int block_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t block_read;          // Workers wait for input
+    pthread_cond_t block_evaluated;     // The writer waits for output
+    pthread_cond_t block_free;          // The reader waits for room
+    unsigned long long read_count;
+    unsigned long long claim_count;
+    unsigned long long write_count;
+    bool input_done;
+    bool output_failed;
+
+    int output_fd;
+    unsigned long long input_bytes;     // Reader only
+    unsigned long long positions;       // Written so far; writer only
+} PositionAnalysis;
+
+// 3^9 boards; each may name the side to move, or leave it implied
+#define ANALYZE_BOARDS 19683
+#define SIDE_IMPLIED 0
+
+// Finished output line for one (board, side) input
+typedef struct {
+    char text[7];
+    uint8_t length;
+} AnalysisAnswer;
+
+static AnalysisAnswer answers[ANALYZE_BOARDS][3];
+
+// Input characters: cells, row separators, and everything else
+#define CHAR_SEPARATOR 3
+#define CHAR_OTHER 4
+static uint8_t char_classes[256];
+
+static char* put_small_int(char* out, int value) {
+    if (value < 0) {
+        *out++ = '-';
+        value = -value;
+    }
+    if (value >= 10) *out++ = (char)('0' + value / 10);
+    *out++ = (char)('0' + value % 10);
+    return out;
+}
+
+// Who moves in a board given as named_side (SIDE_IMPLIED, 1 or 2), or 0
+// if it is not a legal position
+static int get_side_to_move(const uint8_t cells[9], int named_side) {
+    int counts[3] = {0, 0, 0};
+    for (int cell = 0; cell < 9; cell++) {
+        counts[cells[cell]]++;
+    }
+
+    // Whoever has more marks moved last; with equal counts either side
+    // may have started, and X is assumed
+    int lead = counts[1] - counts[2];
+    if (lead < -1 || lead > 1) return 0;
+
+    int side = named_side;
+    if (lead != 0) {
+        int next = (lead > 0) ? 2 : 1;
+        if (side != SIDE_IMPLIED && side != next) return 0;
+        side = next;
+    } else if (side == SIDE_IMPLIED) {
+        side = 1;
+    }
+
+    // The side to move cannot already have won
+    return has_winning_line(cells, side) ? 0 : side;
+}
+
+// Every input a line can hold is answered up front, so evaluating a line
+// is parsing it and copying a few bytes
+static void build_answers(void) {
+    solve_all_hint_positions();
+
+    for (int i = 0; i < 256; i++) {
+        char_classes[i] = CHAR_OTHER;
+    }
+    char_classes[(unsigned char)'.'] = 0;
+    char_classes[(unsigned char)'-'] = 0;
+    char_classes[(unsigned char)'x'] = char_classes[(unsigned char)'X'] = 1;
+    char_classes[(unsigned char)'o'] = char_classes[(unsigned char)'O'] = 2;
+    char_classes[(unsigned char)'/'] = CHAR_SEPARATOR;
+
+    for (int board = 0; board < ANALYZE_BOARDS; board++) {
+        uint8_t cells[9];
+        for (int cell = 0, rest = board; cell < 9; cell++, rest /= 3) {
+            cells[cell] = (uint8_t)(rest % 3);
+        }
+
+        for (int named_side = 0; named_side < 3; named_side++) {
+            AnalysisAnswer* answer = &answers[board][named_side];
+            char* out = answer->text;
+            int to_move = get_side_to_move(cells, named_side);
+            if (to_move == 0) {
+                memcpy(out, "? ?\n", 4);
+                answer->length = 4;
+                continue;
+            }
+
+            int8_t value = 0;
+            int move = get_best_hint_move(cells, to_move, &value);
+            out = put_small_int(out, value);
+            *out++ = ' ';
+            out = put_small_int(out, move);
+            *out++ = '\n';
+            answer->length = (uint8_t)(out - answer->text);
+        }
+    }
+}
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Appends the answer for one line (without its newline)
+static char* evaluate_line(const char* p, const char* end, char* out) {
+    // Base-3 board index, matching the cell order of the notation
+    int board = 0;
+    int scale = 1;
+    int cell = 0;
+    while (p < end && cell < 9) {
+        int char_class = char_classes[(unsigned char)*p++];
+        if (char_class == CHAR_SEPARATOR) continue;
+        if (char_class == CHAR_OTHER) goto invalid;
+        board += char_class * scale;
+        scale *= 3;
+        cell++;
+    }
+    if (cell < 9) goto invalid;
+
+    {
+        int named_side = SIDE_IMPLIED;
+        while (p < end && is_blank(*p)) p++;
+        if (p < end) {
+            int char_class = char_classes[(unsigned char)*p];
+            if (char_class == 1 || char_class == 2) {
+                named_side = char_class;
+                p++;
+            }
+        }
+        while (p < end && is_blank(*p)) p++;
+        if (p != end) goto invalid;
+
+        // Copied whole; only the answer's own length is kept
+        const AnalysisAnswer* answer = &answers[board][named_side];
+        memcpy(out, answer->text, sizeof(answer->text));
+        return out + answer->length;
+    }
+
+invalid:
+    memcpy(out, "? ?\n", 4);
+    return out + 4;
+}
+
+static void evaluate_block(AnalysisBlock* block) {
+    TRACE_SCOPE("analyze_block");
+
+    const char* p = block->input + block->input_start;
+    const char* end = block->input + block->input_length;
+    char* out = block->output;
+    unsigned long long positions = 0;
+
+    while (p < end) {
+        const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = newline ? newline : end;
+        out = evaluate_line(p, line_end, out);
+        positions++;
+        p = line_end + 1;
+    }
+
+    block->output_length = (size_t)(out - block->output);
+    block->positions = positions;
+}
+
+// Threads
+static void* analysis_worker_main(void* arg) {
+    PositionAnalysis* analysis = (PositionAnalysis*)arg;
+    TRACE_THREAD_NAME("analysis worker");
+
+    pthread_mutex_lock(&analysis->lock);
+    for (;;) {
+        while (analysis->claim_count == analysis->read_count &&
+               !analysis->input_done && !analysis->output_failed) {
+            pthread_cond_wait(&analysis->block_read, &analysis->lock);
+        }
+        if (analysis->claim_count == analysis->read_count || analysis->output_failed) {
+            break;
+        }
+
+        AnalysisBlock* block = &analysis->blocks[analysis->claim_count++ % analysis->block_count];
+        block->state = BLOCK_CLAIMED;
+        pthread_mutex_unlock(&analysis->lock);
+
+        evaluate_block(block);
+
+        pthread_mutex_lock(&analysis->lock);
+        block->state = BLOCK_EVALUATED;
+        pthread_cond_signal(&analysis->block_evaluated);
+    }
+    pthread_mutex_unlock(&analysis->lock);
+    return NULL;
+}
+
+static bool write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static void* analysis_writer_main(void* arg) {
+    PositionAnalysis* analysis = (PositionAnalysis*)arg;
+    TRACE_THREAD_NAME("analysis writer");
+
+    pthread_mutex_lock(&analysis->lock);
+    for (;;) {
+        AnalysisBlock* block = &analysis->blocks[analysis->write_count % analysis->block_count];
+        while (block->state != BLOCK_EVALUATED &&
+               !(analysis->input_done && analysis->write_count == analysis->read_count)) {
+            pthread_cond_wait(&analysis->block_evaluated, &analysis->lock);
+        }
+        if (block->state != BLOCK_EVALUATED) {
+            break;
+        }
+        pthread_mutex_unlock(&analysis->lock);
+
+        bool written;
+        {
+            TRACE_SCOPE("analyze_write");
+            written = write_all(analysis->output_fd, block->output, block->output_length);
+        }
+
+        pthread_mutex_lock(&analysis->lock);
+        if (!written) {
+            analysis->output_failed = true;
+            pthread_cond_broadcast(&analysis->block_read);
+            pthread_cond_broadcast(&analysis->block_free);
+            break;
+        }
+        analysis->positions += block->positions;
+        block->state = BLOCK_FREE;
+        analysis->write_count++;
+        pthread_cond_signal(&analysis->block_free);
+    }
+    pthread_mutex_unlock(&analysis->lock);
+    return NULL;
+}
+
+// Reading, on the calling thread
+static bool read_full(int fd, char* buffer, size_t capacity, size_t* length, bool* eof) {
+    while (*length < capacity) {
+        ssize_t bytes = read(fd, buffer + *length, capacity - *length);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (bytes == 0) {
+            *eof = true;
+            break;
+        }
+        *length += (size_t)bytes;
+    }
+    return true;
+}
+
+// Hands the workers every line of the input, a block at a time. The
+// partial line at the end of a block is carried into the next one; a line
+// longer than a whole block is evaluated (as invalid) from its first
+// block and the rest of it skipped.
+static bool read_positions(PositionAnalysis* analysis, int input_fd) {
+    char* carry = (char*)malloc(ANALYZE_BLOCK_SIZE);
+    if (!carry) return false;
+
+    // Read pages are dropped from the page cache behind us, so a huge file
+    // does not push everything else out of memory
+    struct stat input_stat;
+    bool regular_file = fstat(input_fd, &input_stat) == 0 && S_ISREG(input_stat.st_mode);
+    if (regular_file) {
+        posix_fadvise(input_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    off_t file_offset = 0;
+
+    size_t carry_length = 0;
+    bool skipping_line = false;
+    bool eof = false;
+    bool ok = true;
+    while (!eof) {
+        AnalysisBlock* block = &analysis->blocks[analysis->read_count % analysis->block_count];
+
+        pthread_mutex_lock(&analysis->lock);
+        while (block->state != BLOCK_FREE && !analysis->output_failed) {
+            pthread_cond_wait(&analysis->block_free, &analysis->lock);
+        }
+        bool stop = analysis->output_failed;
+        pthread_mutex_unlock(&analysis->lock);
+        if (stop) break;
+
+        size_t carried = carry_length;
+        memcpy(block->input, carry, carried);
+        size_t length = carried;
+        carry_length = 0;
+        {
+            TRACE_SCOPE("analyze_read");
+            if (!read_full(input_fd, block->input, ANALYZE_BLOCK_SIZE, &length, &eof)) {
+                perror("analyze: read");
+                ok = false;
+                eof = true;
+            }
+        }
+
+        analysis->input_bytes += length - carried;
+        if (regular_file && length > carried) {
+            off_t new_bytes = (off_t)(length - carried);
+            posix_fadvise(input_fd, file_offset, new_bytes, POSIX_FADV_DONTNEED);
+            file_offset += new_bytes;
+        }
+
+        size_t start = 0;
+        if (skipping_line) {
+            const char* newline = (const char*)memchr(block->input, '\n', length);
+            if (!newline) continue;
+            start = (size_t)(newline - block->input) + 1;
+            skipping_line = false;
+        }
+
+        size_t end = length;
+        if (!eof) {
+            const char* last = (const char*)memrchr(block->input + start, '\n', length - start);
+            if (last) {
+                end = (size_t)(last - block->input) + 1;
+            } else {
+                skipping_line = true;
+            }
+        }
+
+        carry_length = length - end;
+        memcpy(carry, block->input + end, carry_length);
+        if (end == start) continue;
+
+        block->input_start = start;
+        block->input_length = end;
+
+        pthread_mutex_lock(&analysis->lock);
+        block->state = BLOCK_READ;
+        analysis->read_count++;
+        pthread_cond_signal(&analysis->block_read);
+        pthread_mutex_unlock(&analysis->lock);
+    }
+
+    pthread_mutex_lock(&analysis->lock);
+    analysis->input_done = true;
+    pthread_cond_broadcast(&analysis->block_read);
+    pthread_cond_broadcast(&analysis->block_evaluated);
+    pthread_mutex_unlock(&analysis->lock);
+
+    free(carry);
+    return ok;
+}
+
+int run_position_analysis(const char* path, int worker_count) {
+    bool use_stdin = (path == NULL || strcmp(path, "-") == 0);
+    int input_fd = use_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (input_fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    if (worker_count <= 0) worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (worker_count <= 0) worker_count = 1;
+    if (worker_count > ANALYZE_MAX_WORKERS) worker_count = ANALYZE_MAX_WORKERS;
+
+    // The workers only read the answer table
+    build_answers();
+
+    PositionAnalysis analysis;
+    memset(&analysis, 0, sizeof(analysis));
+    analysis.output_fd = STDOUT_FILENO;
+
+    // One block being read and one being written besides the workers' own
+    analysis.block_count = worker_count * ANALYZE_BLOCKS_PER_WORKER + 2;
+    analysis.blocks = (AnalysisBlock*)calloc((size_t)analysis.block_count, sizeof(AnalysisBlock));
+    bool allocated = analysis.blocks != NULL;
+    for (int i = 0; allocated && i < analysis.block_count; i++) {
+        AnalysisBlock* block = &analysis.blocks[i];
+        block->state = BLOCK_FREE;
+        block->input = (char*)malloc(ANALYZE_BLOCK_SIZE);
+        block->output = (char*)malloc((size_t)ANALYZE_OUTPUT_PER_LINE * (ANALYZE_BLOCK_SIZE + 1));
+        allocated = block->input && block->output;
+    }
+
+    int result = 1;
+    pthread_t workers[ANALYZE_MAX_WORKERS];
+    pthread_t writer;
+    int started_workers = 0;
+    bool writer_started = false;
+
+    if (!allocated) {
+        fprintf(stderr, "analyze: out of memory\n");
+        goto cleanup;
+    }
+
+    pthread_mutex_init(&analysis.lock, NULL);
+    pthread_cond_init(&analysis.block_read, NULL);
+    pthread_cond_init(&analysis.block_evaluated, NULL);
+    pthread_cond_init(&analysis.block_free, NULL);
+
+    {
+        double start = get_monotonic_time();
+
+        writer_started = pthread_create(&writer, NULL, analysis_writer_main, &analysis) == 0;
+        for (int i = 0; writer_started && i < worker_count; i++) {
+            if (pthread_create(&workers[i], NULL, analysis_worker_main, &analysis) != 0) break;
+            started_workers++;
+        }
+
+        bool read_ok = false;
+        if (started_workers > 0) {
+            read_ok = read_positions(&analysis, input_fd);
+        } else {
+            fprintf(stderr, "analyze: failed to start threads\n");
+        }
+
+        // Ends the threads if reading never started
+        pthread_mutex_lock(&analysis.lock);
+        analysis.input_done = true;
+        pthread_cond_broadcast(&analysis.block_read);
+        pthread_cond_broadcast(&analysis.block_evaluated);
+        pthread_mutex_unlock(&analysis.lock);
+
+        for (int i = 0; i < started_workers; i++) {
+            pthread_join(workers[i], NULL);
+        }
+        if (writer_started) {
+            pthread_join(writer, NULL);
+        }
+
+        double elapsed = get_monotonic_time() - start;
+        if (elapsed <= 0.0) elapsed = 1e-9;
+        if (analysis.output_failed) {
+            perror("analyze: write");
+        } else if (read_ok) {
+            double megabytes = (double)analysis.input_bytes / 1e6;
+            fprintf(stderr, "Analyzed %llu positions (%.1f MB) in %.3f s with %d workers: %.0f positions/s, %.1f MB/s\n",
+                    analysis.positions, megabytes, elapsed, started_workers,
+                    (double)analysis.positions / elapsed, megabytes / elapsed);
+            result = 0;
+        }
+    }
+
+    pthread_cond_destroy(&analysis.block_free);
+    pthread_cond_destroy(&analysis.block_evaluated);
+    pthread_cond_destroy(&analysis.block_read);
+    pthread_mutex_destroy(&analysis.lock);
+
+cleanup:
+    for (int i = 0; analysis.blocks && i < analysis.block_count; i++) {
+        free(analysis.blocks[i].input);
+        free(analysis.blocks[i].output);
+    }
+    free(analysis.blocks);
+    if (!use_stdin) close(input_fd);
+    return result;
+}
@@ -0,0 +1,32 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+// Input is read and evaluated in blocks of this size; a position line may
+// not be longer than one block
+#define ANALYZE_BLOCK_SIZE (256 * 1024)
+
+// Blocks in flight per worker: one being evaluated, one queued
+#define ANALYZE_BLOCKS_PER_WORKER 2
+#define ANALYZE_MAX_WORKERS 32
+
+// Longest output line, "-16 -1\n", plus slack
+#define ANALYZE_OUTPUT_PER_LINE 8
+
+// Input: one position per line. Nine cells row-major, x/X, o/O, or . / -
+// for empty, with optional '/' between rows; then optionally whitespace
+// and the side to move (x or o). Without it, X moves when the counts are
+// equal. Examples: "x.o.x...o", "xo./.x./..o o".
+//
+// Output: one line per input line, in input order:
+//   SCORE MOVE   SCORE is 16 - n for a win in n plies by the side to move,
+//                -(16 - n) for a loss in n, 0 for a draw; MOVE is the best
+//                cell (row * 3 + col), or -1 if the game is already over
+//   ? ?          the line is not a legal position
+//
+// Blocks are read sequentially into a fixed ring, evaluated by a pool of
+// worker_count threads (0 = one per CPU) and written back in order by a
+// writer thread, so memory stays constant however large the input is.
+// path NULL or "-" reads stdin. Prints throughput to stderr.
+int run_position_analysis(const char* path, int worker_count);
+
+#endif
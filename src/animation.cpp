@@ -0,0 +1,102 @@
+#include "animation.h"
+#include <math.h>
+
+void init_animation_timeline(AnimationTimeline* timeline) {
+    for (int i = 0; i < ANIMATION_TRACK_COUNT; i++) {
+        timeline->tracks[i].active = false;
+        timeline->tracks[i].loop = false;
+        timeline->tracks[i].start_time = 0.0;
+        timeline->tracks[i].duration = 0.0;
+        timeline->tracks[i].steps = 1;
+        timeline->tracks[i].target = -1;
+    }
+    timeline->now = 0.0;
+}
+
+void start_animation(AnimationTimeline* timeline, AnimationTrackId id, double now,
+                     double duration, int steps, bool loop, int target) {
+    AnimationTrack* track = &timeline->tracks[id];
+    track->active = duration > 0.0;
+    track->loop = loop;
+    track->start_time = now;
+    track->duration = duration;
+    track->steps = (steps > 0) ? steps : 1;
+    track->target = target;
+}
+
+void stop_animation(AnimationTimeline* timeline, AnimationTrackId id) {
+    timeline->tracks[id].active = false;
+}
+
+void advance_animation_timeline(AnimationTimeline* timeline, double now) {
+    timeline->now = now;
+
+    for (int i = 0; i < ANIMATION_TRACK_COUNT; i++) {
+        AnimationTrack* track = &timeline->tracks[i];
+        if (track->active && !track->loop && now >= track->start_time + track->duration) {
+            track->active = false;
+        }
+    }
+}
+
+bool is_animation_active(const AnimationTimeline* timeline, AnimationTrackId id) {
+    return timeline->tracks[id].active;
+}
+
+// Elapsed time within the current cycle
+static double cycle_time(const AnimationTrack* track, double now) {
+    double elapsed = now - track->start_time;
+    if (elapsed < 0.0) return 0.0;
+    if (track->loop) return fmod(elapsed, track->duration);
+    return (elapsed < track->duration) ? elapsed : track->duration;
+}
+
+int animation_step(const AnimationTimeline* timeline, AnimationTrackId id) {
+    const AnimationTrack* track = &timeline->tracks[id];
+    if (!track->active) return 0;
+
+    int step = (int)(cycle_time(track, timeline->now) * track->steps / track->duration);
+    return (step < track->steps) ? step : track->steps - 1;
+}
+
+double animation_progress(const AnimationTimeline* timeline, AnimationTrackId id) {
+    const AnimationTrack* track = &timeline->tracks[id];
+    if (!track->active) return 1.0;
+
+    // Quantized to the step grid so the output only changes at deadlines
+    return (track->steps > 1)
+        ? (double)animation_step(timeline, id) / (double)(track->steps - 1)
+        : 0.0;
+}
+
+int animation_target(const AnimationTimeline* timeline, AnimationTrackId id) {
+    return timeline->tracks[id].active ? timeline->tracks[id].target : -1;
+}
+
+double animation_next_deadline(const AnimationTimeline* timeline, double now) {
+    double deadline = -1.0;
+
+    for (int i = 0; i < ANIMATION_TRACK_COUNT; i++) {
+        const AnimationTrack* track = &timeline->tracks[i];
+        if (!track->active) continue;
+
+        double step_length = track->duration / track->steps;
+        double elapsed = now - track->start_time;
+        double next;
+
+        if (elapsed < 0.0) {
+            next = track->start_time;
+        } else if (!track->loop && elapsed >= track->duration) {
+            next = now;  // Finished; retire it on the next frame
+        } else {
+            // Start of the next step (for one-shots, the last one is the end)
+            next = track->start_time + (floor(elapsed / step_length) + 1.0) * step_length;
+        }
+
+        if (deadline < 0.0 || next < deadline) {
+            deadline = next;
+        }
+    }
+
+    return deadline;
+}
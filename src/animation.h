@@ -0,0 +1,49 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdbool.h>
+
+// One track per animated element
+typedef enum {
+    ANIMATION_AI_THINKING,     // Looping "AI is thinking..." spinner
+    ANIMATION_AI_MOVE_FLASH,   // Blink on the cell the AI just took
+    ANIMATION_MOVE_HIGHLIGHT,  // Short highlight on the cell the player just took
+    ANIMATION_TRACK_COUNT
+} AnimationTrackId;
+
+// Time-based track. The visible output only changes at step boundaries
+// (duration / steps apart), which is what lets the main loop sleep until
+// the next one instead of redrawing every frame.
+typedef struct {
+    bool active;
+    bool loop;
+    double start_time;
+    double duration;   // Seconds per cycle
+    int steps;         // Visible states per cycle
+    int target;        // Caller data, e.g. the animated board cell
+} AnimationTrack;
+
+typedef struct {
+    AnimationTrack tracks[ANIMATION_TRACK_COUNT];
+    double now;        // Frame time that rendering samples at
+} AnimationTimeline;
+
+void init_animation_timeline(AnimationTimeline* timeline);
+
+void start_animation(AnimationTimeline* timeline, AnimationTrackId id, double now,
+                     double duration, int steps, bool loop, int target);
+void stop_animation(AnimationTimeline* timeline, AnimationTrackId id);
+
+// Sets the frame time and retires finished one-shot tracks
+void advance_animation_timeline(AnimationTimeline* timeline, double now);
+
+// Sampling at the current frame time
+bool is_animation_active(const AnimationTimeline* timeline, AnimationTrackId id);
+int animation_step(const AnimationTimeline* timeline, AnimationTrackId id);
+double animation_progress(const AnimationTimeline* timeline, AnimationTrackId id);
+int animation_target(const AnimationTimeline* timeline, AnimationTrackId id);
+
+// Earliest time any track changes what is on screen; negative when idle
+double animation_next_deadline(const AnimationTimeline* timeline, double now);
+
+#endif
@@ -0,0 +1,385 @@
+#include "asciicast.h"
+#include "timing.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One presented frame: the rows that changed since the previous one
+typedef struct {
+    double time;
+    int width;
+    int height;
+    int row_count;
+    int* rows;
+    struct tb_cell* cells;     // row_count rows of width cells
+    size_t row_capacity;       // Rows the arrays above can hold at this width
+    int capacity_width;
+} AsciicastChunk;
+
+struct AsciicastRecorder {
+    // Single producer (the frame loop), single consumer (the writer)
+    AsciicastChunk chunks[ASCIICAST_RING_CHUNKS];
+    uint32_t head;              // Next chunk to fill; producer only
+    uint32_t tail;              // Next chunk to write; writer only
+
+    // Producer: the last recorded frame
+    struct tb_cell* previous;
+    int previous_width;
+    int previous_height;
+    bool send_all_rows;         // After a resize or a skipped frame
+    double start_time;
+    unsigned long skipped_frames;
+
+    // Writer: the screen as the recording shows it so far
+    FILE* file;
+    char* file_buffer;
+    struct tb_cell* screen;
+    int screen_width;
+    int screen_height;
+    int cursor_x;               // -1 when unknown
+    int cursor_y;
+    uintattr_t current_fg;
+    uintattr_t current_bg;
+    char* output;
+    size_t output_length;
+    size_t output_capacity;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+};
+
+static const struct tb_cell blank_cell = {' ', TB_DEFAULT, TB_DEFAULT};
+
+// Writer: escape sequences
+
+// Output for one chunk; a chunk that cannot grow it is written short
+static bool reserve_output(AsciicastRecorder* recorder, size_t extra) {
+    if (recorder->output_length + extra <= recorder->output_capacity) return true;
+
+    size_t capacity = recorder->output_capacity ? recorder->output_capacity * 2 : 16384;
+    while (capacity < recorder->output_length + extra) capacity *= 2;
+    char* output = (char*)realloc(recorder->output, capacity);
+    if (!output) return false;
+    recorder->output = output;
+    recorder->output_capacity = capacity;
+    return true;
+}
+
+static void append_text(AsciicastRecorder* recorder, const char* text) {
+    size_t length = strlen(text);
+    if (!reserve_output(recorder, length)) return;
+    memcpy(recorder->output + recorder->output_length, text, length);
+    recorder->output_length += length;
+}
+
+static void append_number(AsciicastRecorder* recorder, const char* prefix, int value) {
+    char text[16];
+    snprintf(text, sizeof(text), "%s%d", prefix, value);
+    append_text(recorder, text);
+}
+
+static void append_color(AsciicastRecorder* recorder, uintattr_t color, int base) {
+    int index = (int)(color & 0xff);
+    append_number(recorder, ";", (index >= 1 && index <= 8) ? base + index - 1 : base + 9);
+}
+
+static void append_attributes(AsciicastRecorder* recorder, uintattr_t fg, uintattr_t bg) {
+    append_text(recorder, "\x1b[0");
+    if (fg & TB_BOLD) append_text(recorder, ";1");
+    if (fg & TB_ITALIC) append_text(recorder, ";3");
+    if (fg & TB_UNDERLINE) append_text(recorder, ";4");
+    if ((fg | bg) & TB_REVERSE) append_text(recorder, ";7");
+    append_color(recorder, fg, 30);
+    append_color(recorder, bg, 40);
+    append_text(recorder, "m");
+
+    recorder->current_fg = fg;
+    recorder->current_bg = bg;
+}
+
+static void append_utf8(AsciicastRecorder* recorder, uint32_t ch) {
+    if (ch < 0x20 || ch == 0x7f) ch = ' ';
+
+    if (!reserve_output(recorder, 4)) return;
+    char* out = recorder->output + recorder->output_length;
+    if (ch < 0x80) {
+        out[0] = (char)ch;
+        recorder->output_length += 1;
+    } else if (ch < 0x800) {
+        out[0] = (char)(0xc0 | (ch >> 6));
+        out[1] = (char)(0x80 | (ch & 0x3f));
+        recorder->output_length += 2;
+    } else if (ch < 0x10000) {
+        out[0] = (char)(0xe0 | (ch >> 12));
+        out[1] = (char)(0x80 | ((ch >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (ch & 0x3f));
+        recorder->output_length += 3;
+    } else {
+        out[0] = (char)(0xf0 | (ch >> 18));
+        out[1] = (char)(0x80 | ((ch >> 12) & 0x3f));
+        out[2] = (char)(0x80 | ((ch >> 6) & 0x3f));
+        out[3] = (char)(0x80 | (ch & 0x3f));
+        recorder->output_length += 4;
+    }
+}
+
+static bool reset_screen(AsciicastRecorder* recorder, int width, int height) {
+    size_t cell_count = (size_t)width * (size_t)height;
+    struct tb_cell* screen = (struct tb_cell*)realloc(recorder->screen, sizeof(struct tb_cell) * (cell_count ? cell_count : 1));
+    if (!screen) return false;
+    for (size_t i = 0; i < cell_count; i++) screen[i] = blank_cell;
+
+    recorder->screen = screen;
+    recorder->screen_width = width;
+    recorder->screen_height = height;
+    recorder->cursor_x = -1;
+    recorder->current_fg = TB_DEFAULT;
+    recorder->current_bg = TB_DEFAULT;
+    return true;
+}
+
+// Escape sequences for the cells of one changed row that really differ
+static void encode_row(AsciicastRecorder* recorder, int y, const struct tb_cell* row) {
+    struct tb_cell* screen_row = recorder->screen + (size_t)y * recorder->screen_width;
+
+    for (int x = 0; x < recorder->screen_width; x++) {
+        const struct tb_cell* cell = &row[x];
+        if (cell->ch == screen_row[x].ch && cell->fg == screen_row[x].fg && cell->bg == screen_row[x].bg) {
+            continue;
+        }
+
+        if (recorder->cursor_x != x || recorder->cursor_y != y) {
+            append_number(recorder, "\x1b[", y + 1);
+            append_number(recorder, ";", x + 1);
+            append_text(recorder, "H");
+        }
+        if (cell->fg != recorder->current_fg || cell->bg != recorder->current_bg) {
+            append_attributes(recorder, cell->fg, cell->bg);
+        }
+        append_utf8(recorder, cell->ch);
+
+        screen_row[x] = *cell;
+        recorder->cursor_x = (x + 1 < recorder->screen_width) ? x + 1 : -1;
+        recorder->cursor_y = y;
+    }
+}
+
+static void write_json_string(FILE* file, const char* data, size_t length) {
+    fputc('"', file);
+
+    // Plain stretches go out in one fwrite; only quotes, backslashes and
+    // control bytes (ESC, mostly) need escaping
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char byte = (unsigned char)data[i];
+        if (byte >= 0x20 && byte != '"' && byte != '\\') continue;
+
+        fwrite(data + start, 1, i - start, file);
+        if (byte < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            char escaped[6] = {'\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xf]};
+            fwrite(escaped, 1, sizeof(escaped), file);
+        } else {
+            fputc('\\', file);
+            fputc(byte, file);
+        }
+        start = i + 1;
+    }
+    fwrite(data + start, 1, length - start, file);
+    fputc('"', file);
+}
+
+static void write_chunk(AsciicastRecorder* recorder, const AsciicastChunk* chunk) {
+    if (chunk->width != recorder->screen_width || chunk->height != recorder->screen_height) {
+        if (!reset_screen(recorder, chunk->width, chunk->height)) return;
+        fprintf(recorder->file, "[%.6f, \"r\", \"%dx%d\"]\n", chunk->time, chunk->width, chunk->height);
+        recorder->output_length = 0;
+        append_text(recorder, "\x1b[0m\x1b[2J");
+    } else {
+        recorder->output_length = 0;
+    }
+
+    for (int i = 0; i < chunk->row_count; i++) {
+        encode_row(recorder, chunk->rows[i], chunk->cells + (size_t)i * chunk->width);
+    }
+
+    if (recorder->output_length > 0) {
+        fprintf(recorder->file, "[%.6f, \"o\", ", chunk->time);
+        write_json_string(recorder->file, recorder->output, recorder->output_length);
+        fputs("]\n", recorder->file);
+    }
+}
+
+static void drain_chunks(AsciicastRecorder* recorder) {
+    TRACE_SCOPE("asciicast_write");
+    uint32_t head = __atomic_load_n(&recorder->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = recorder->tail;
+
+    for (; tail != head; tail++) {
+        write_chunk(recorder, &recorder->chunks[tail % ASCIICAST_RING_CHUNKS]);
+        __atomic_store_n(&recorder->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    fflush(recorder->file);
+}
+
+static void* asciicast_writer_main(void* argument) {
+    AsciicastRecorder* recorder = (AsciicastRecorder*)argument;
+    TRACE_THREAD_NAME("asciicast writer");
+
+    pthread_mutex_lock(&recorder->lock);
+    while (!recorder->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += ASCIICAST_FLUSH_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&recorder->wake, &recorder->lock, &deadline);
+
+        pthread_mutex_unlock(&recorder->lock);
+        drain_chunks(recorder);
+        pthread_mutex_lock(&recorder->lock);
+    }
+    pthread_mutex_unlock(&recorder->lock);
+
+    drain_chunks(recorder);
+    return NULL;
+}
+
+// Producer
+static bool reserve_chunk(AsciicastChunk* chunk, int width, int height) {
+    if (chunk->capacity_width == width && chunk->row_capacity >= (size_t)height) return true;
+
+    int* rows = (int*)realloc(chunk->rows, sizeof(int) * (size_t)height);
+    if (rows) chunk->rows = rows;
+    struct tb_cell* cells = (struct tb_cell*)realloc(chunk->cells, sizeof(struct tb_cell) * (size_t)width * (size_t)height);
+    if (cells) chunk->cells = cells;
+    if (!rows || !cells) return false;
+
+    chunk->row_capacity = (size_t)height;
+    chunk->capacity_width = width;
+    return true;
+}
+
+void record_asciicast_frame(AsciicastRecorder* recorder, const struct tb_cell* cells, int width, int height,
+                            double present_time) {
+    TRACE_SCOPE("record_asciicast_frame");
+    if (!recorder || !cells || width <= 0 || height <= 0) return;
+
+    size_t row_size = sizeof(struct tb_cell) * (size_t)width;
+    if (width != recorder->previous_width || height != recorder->previous_height) {
+        struct tb_cell* previous = (struct tb_cell*)realloc(recorder->previous, row_size * (size_t)height);
+        if (!previous) return;
+        recorder->previous = previous;
+        recorder->previous_width = width;
+        recorder->previous_height = height;
+        recorder->send_all_rows = true;
+    }
+
+    uint32_t head = recorder->head;
+    uint32_t tail = __atomic_load_n(&recorder->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= ASCIICAST_RING_CHUNKS) {
+        // The writer fell behind; the next frame that fits brings it up to date
+        recorder->skipped_frames++;
+        recorder->send_all_rows = true;
+        return;
+    }
+
+    AsciicastChunk* chunk = &recorder->chunks[head % ASCIICAST_RING_CHUNKS];
+    if (!reserve_chunk(chunk, width, height)) return;
+
+    chunk->time = present_time - recorder->start_time;
+    chunk->width = width;
+    chunk->height = height;
+    chunk->row_count = 0;
+    for (int y = 0; y < height; y++) {
+        const struct tb_cell* row = cells + (size_t)y * width;
+        struct tb_cell* previous_row = recorder->previous + (size_t)y * width;
+        if (!recorder->send_all_rows && memcmp(row, previous_row, row_size) == 0) {
+            continue;
+        }
+        memcpy(previous_row, row, row_size);
+        memcpy(chunk->cells + (size_t)chunk->row_count * width, row, row_size);
+        chunk->rows[chunk->row_count++] = y;
+    }
+    recorder->send_all_rows = false;
+
+    if (chunk->row_count == 0) return;
+    __atomic_store_n(&recorder->head, head + 1, __ATOMIC_RELEASE);
+
+    // Busy frame loop: write early rather than wait out the interval
+    if (head - tail == ASCIICAST_RING_CHUNKS / 2) {
+        pthread_cond_signal(&recorder->wake);
+    }
+}
+
+AsciicastRecorder* start_asciicast_recording(const char* path, int width, int height) {
+    AsciicastRecorder* recorder = (AsciicastRecorder*)calloc(1, sizeof(AsciicastRecorder));
+    if (!recorder) return NULL;
+
+    recorder->file = fopen(path, "w");
+    if (!recorder->file) {
+        free(recorder);
+        return NULL;
+    }
+    recorder->file_buffer = (char*)malloc(ASCIICAST_WRITE_BUFFER_SIZE);
+    if (recorder->file_buffer) {
+        setvbuf(recorder->file, recorder->file_buffer, _IOFBF, ASCIICAST_WRITE_BUFFER_SIZE);
+    }
+
+    const char* term = getenv("TERM");
+    fprintf(recorder->file, "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %ld, "
+            "\"title\": \"tictactoe\", \"env\": {\"TERM\": ", width, height, (long)time(NULL));
+    write_json_string(recorder->file, term ? term : "", term ? strlen(term) : 0);
+    fputs("}}\n", recorder->file);
+
+    reset_screen(recorder, width, height);
+    recorder->start_time = get_monotonic_time();
+    pthread_mutex_init(&recorder->lock, NULL);
+    pthread_cond_init(&recorder->wake, NULL);
+
+    if (pthread_create(&recorder->thread, NULL, asciicast_writer_main, recorder) != 0) {
+        pthread_mutex_destroy(&recorder->lock);
+        pthread_cond_destroy(&recorder->wake);
+        fclose(recorder->file);
+        free(recorder->file_buffer);
+        free(recorder->screen);
+        free(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+void stop_asciicast_recording(AsciicastRecorder* recorder) {
+    if (!recorder) return;
+
+    pthread_mutex_lock(&recorder->lock);
+    recorder->stopping = true;
+    pthread_cond_signal(&recorder->wake);
+    pthread_mutex_unlock(&recorder->lock);
+    pthread_join(recorder->thread, NULL);
+
+    fclose(recorder->file);
+    if (recorder->skipped_frames > 0) {
+        fprintf(stderr, "asciicast: %lu frames skipped while the writer caught up\n", recorder->skipped_frames);
+    }
+
+    pthread_mutex_destroy(&recorder->lock);
+    pthread_cond_destroy(&recorder->wake);
+    for (int i = 0; i < ASCIICAST_RING_CHUNKS; i++) {
+        free(recorder->chunks[i].rows);
+        free(recorder->chunks[i].cells);
+    }
+    free(recorder->previous);
+    free(recorder->screen);
+    free(recorder->output);
+    free(recorder->file_buffer);
+    free(recorder);
+}
@@ -0,0 +1,32 @@
+#ifndef ASCIICAST_H
+#define ASCIICAST_H
+
+#include "../lib/termbox2/termbox2.h"
+
+// asciinema v2 recording (https://docs.asciinema.org/manual/asciicast/v2/)
+// of what the game presents. The output is rebuilt from the cell buffer
+// after each present: cursor moves, SGR attributes and UTF-8 text for the
+// cells that changed, plus "r" events when the terminal is resized.
+//
+// The frame loop only copies the rows that changed into a slot of a
+// single-producer ring; a background thread diffs them, encodes the
+// escape sequences and writes the file in large buffered chunks. If the
+// ring is full a frame is skipped, and the next one carries every row so
+// the recording catches up.
+#define ASCIICAST_RING_CHUNKS 64
+#define ASCIICAST_FLUSH_INTERVAL_MS 50
+#define ASCIICAST_WRITE_BUFFER_SIZE (256 * 1024)
+
+typedef struct AsciicastRecorder AsciicastRecorder;
+
+// Writes the header; returns NULL if the file cannot be created
+AsciicastRecorder* start_asciicast_recording(const char* path, int width, int height);
+
+// Once per presented frame, with the time it was presented
+void record_asciicast_frame(AsciicastRecorder* recorder, const struct tb_cell* cells, int width, int height,
+                            double present_time);
+
+// Writes everything still queued and closes the file
+void stop_asciicast_recording(AsciicastRecorder* recorder);
+
+#endif
@@ -0,0 +1,280 @@
+#include "events.h"
+#include "input.h"
+#include "input_thread.h"
+#include "render_target.h"
+#include "timing.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+
+// Mouse events that only reposition the cursor (motion, release, wheel)
+static bool is_mouse_position_event(const struct tb_event* event) {
+    if (event->type != TB_EVENT_MOUSE) return false;
+    return (event->mod & TB_MOD_MOTION) || event->key != TB_KEY_MOUSE_LEFT;
+}
+
+static int clamp_int(int value, int min_value, int max_value) {
+    if (value < min_value) return min_value;
+    if (value > max_value) return max_value;
+    return value;
+}
+
+void init_input_batch(InputBatch* batch) {
+    batch->count = 0;
+    batch->raw_event_count = 0;
+    batch->first_arrival_time = 0.0;
+}
+
+void append_input_event(InputBatch* batch, const struct tb_event* event) {
+    if (batch->raw_event_count < INPUT_RAW_CAPACITY) {
+        batch->raw_events[batch->raw_event_count] = *event;
+    }
+    batch->raw_event_count++;
+
+    int dx, dy;
+    bool is_key_move = is_movement_key(event, &dx, &dy);
+    bool is_mouse_move = is_mouse_position_event(event);
+
+    if (is_key_move || is_mouse_move) {
+        InputEntry* last = (batch->count > 0) ? &batch->entries[batch->count - 1] : NULL;
+
+        // Start a new cursor run if the previous entry was not one
+        if (!last || last->kind != INPUT_CURSOR) {
+            if (batch->count >= INPUT_BATCH_CAPACITY) return;
+            last = &batch->entries[batch->count++];
+            last->kind = INPUT_CURSOR;
+            last->has_position = false;
+            last->x = 0;
+            last->y = 0;
+            last->dx = 0;
+            last->dy = 0;
+            last->key_moves = 0;
+        }
+
+        if (is_mouse_move) {
+            // An absolute position overrides every earlier move in the run
+            last->has_position = true;
+            last->x = event->x;
+            last->y = event->y;
+            last->dx = 0;
+            last->dy = 0;
+            last->key_moves = 0;
+        } else {
+            last->dx += dx;
+            last->dy += dy;
+            last->key_moves++;
+        }
+        return;
+    }
+
+    if (batch->count >= INPUT_BATCH_CAPACITY) return;
+
+    InputEntry* entry = &batch->entries[batch->count++];
+    entry->kind = INPUT_EVENT;
+    entry->event = *event;
+}
+
+// Waits for terminal input or watch_fd. Returns TB_OK with an event,
+// TB_ERR_NO_EVENT on timeout or when watch_fd is readable.
+static int wait_for_event_or_fd(struct tb_event* event, double wake_deadline, int watch_fd) {
+    int tty_fd = -1;
+    int resize_fd = -1;
+    tb_get_fds(&tty_fd, &resize_fd);
+
+    for (;;) {
+        // Termbox may already hold decoded input
+        int result = tb_peek_event(event, 0);
+        if (result != TB_ERR_NO_EVENT) {
+            return result;
+        }
+
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(watch_fd, &read_fds);
+        int max_fd = watch_fd;
+        if (tty_fd >= 0) {
+            FD_SET(tty_fd, &read_fds);
+            if (tty_fd > max_fd) max_fd = tty_fd;
+        }
+        if (resize_fd >= 0) {
+            FD_SET(resize_fd, &read_fds);
+            if (resize_fd > max_fd) max_fd = resize_fd;
+        }
+
+        struct timeval timeout;
+        struct timeval* timeout_ptr = NULL;
+        if (wake_deadline >= 0.0) {
+            double remaining = wake_deadline - get_monotonic_time();
+            if (remaining < 0.0) remaining = 0.0;
+            timeout.tv_sec = (time_t)remaining;
+            timeout.tv_usec = (suseconds_t)((remaining - (double)timeout.tv_sec) * 1e6);
+            timeout_ptr = &timeout;
+        }
+
+        int ready = select(max_fd + 1, &read_fds, NULL, NULL, timeout_ptr);
+        if (ready < 0 && errno != EINTR) {
+            return TB_ERR_POLL;
+        }
+        if (ready == 0 || (ready > 0 && FD_ISSET(watch_fd, &read_fds))) {
+            return TB_ERR_NO_EVENT;
+        }
+    }
+}
+
+// Same waits as below, over events the input thread already decoded and
+// timestamped
+static bool collect_queued_input(InputBatch* batch, double last_present_time, double wake_deadline, int watch_fd) {
+    int result = wait_for_input_event(wake_deadline, watch_fd);
+    if (result == TB_ERR_NO_EVENT) {
+        return true;
+    }
+    if (result != TB_OK) {
+        return false;
+    }
+
+    TimedInputEvent queued;
+    while (batch->count < INPUT_BATCH_CAPACITY && batch->raw_event_count < INPUT_RAW_CAPACITY) {
+        if (!pop_input_event(&queued)) {
+            if (wait_for_input_event(last_present_time + FRAME_INTERVAL_SECONDS, -1) != TB_OK) {
+                break;
+            }
+            continue;
+        }
+
+        if (batch->raw_event_count == 0) {
+            batch->first_arrival_time = queued.arrival_time;
+        }
+        append_input_event(batch, &queued.event);
+    }
+
+    return true;
+}
+
+bool collect_input_batch(InputBatch* batch, double last_present_time, double wake_deadline, int watch_fd) {
+    init_input_batch(batch);
+
+    if (is_input_thread_running()) {
+        return collect_queued_input(batch, last_present_time, wake_deadline, watch_fd);
+    }
+
+    struct tb_event event;
+    if (watch_fd >= 0) {
+        int result = wait_for_event_or_fd(&event, wake_deadline, watch_fd);
+        if (result == TB_ERR_NO_EVENT) {
+            return true;
+        }
+        if (result != TB_OK) {
+            return false;
+        }
+    } else if (wake_deadline < 0.0) {
+        // Nothing is animating: sleep until there is input
+        if (tb_poll_event(&event) != TB_OK) {
+            return false;
+        }
+    } else {
+        // Sleep exactly until the next visible animation change
+        double remaining = wake_deadline - get_monotonic_time();
+        int timeout_ms = (remaining > 0.0) ? (int)(remaining * 1000.0 + 0.999) : 0;
+
+        int result = tb_peek_event(&event, timeout_ms);
+        if (result == TB_ERR_NO_EVENT) {
+            return true;
+        }
+        if (result != TB_OK) {
+            return false;
+        }
+    }
+    batch->first_arrival_time = get_system_monotonic_time();
+    append_input_event(batch, &event);
+
+    // Drain whatever is pending, waiting at most until the next frame is due.
+    // The capacity check keeps room for one more entry before reading.
+    while (batch->count < INPUT_BATCH_CAPACITY && batch->raw_event_count < INPUT_RAW_CAPACITY) {
+        double remaining = last_present_time + FRAME_INTERVAL_SECONDS - get_monotonic_time();
+        int timeout_ms = (remaining > 0.0) ? (int)(remaining * 1000.0) : 0;
+
+        if (tb_peek_event(&event, timeout_ms) != TB_OK) {
+            break;
+        }
+        append_input_event(batch, &event);
+    }
+
+    return true;
+}
+
+static int sign_of(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// Movement keys steer a running game from the game list rather than the
+// cursor; the run is reduced to its net direction
+static bool steer_running_game(ApplicationState* app, const InputEntry* entry) {
+    if (entry->key_moves == 0 || !is_game_session_running(app)) return false;
+    if (entry->dx == 0 && entry->dy == 0) return true;
+
+    struct tb_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = TB_EVENT_KEY;
+    if (abs(entry->dx) >= abs(entry->dy)) {
+        event.key = entry->dx < 0 ? TB_KEY_ARROW_LEFT : TB_KEY_ARROW_RIGHT;
+    } else {
+        event.key = entry->dy < 0 ? TB_KEY_ARROW_UP : TB_KEY_ARROW_DOWN;
+    }
+    return handle_current_game_input(&app->game_manager, &event, &app->cursor);
+}
+
+static void apply_cursor_entry(ApplicationState* app, const InputEntry* entry) {
+    if (steer_running_game(app, entry)) {
+        if (entry->has_position) {
+            set_cursor_position(app, entry->x, entry->y);
+        }
+        return;
+    }
+
+    int x = entry->has_position ? entry->x : app->cursor.screen_x;
+    int y = entry->has_position ? entry->y : app->cursor.screen_y;
+    int dx = entry->dx;
+    int dy = entry->dy;
+
+    // A run of presses all in one direction continues (or starts) a held
+    // key streak and moves further the longer the key is held
+    bool one_direction = (dx == 0) != (dy == 0) && abs(dx + dy) == entry->key_moves;
+    if (!entry->has_position && one_direction) {
+        int cells = accelerate_cursor_moves(&app->cursor, sign_of(dx), sign_of(dy), entry->key_moves,
+                                            get_monotonic_time());
+        dx = sign_of(dx) * cells;
+        dy = sign_of(dy) * cells;
+    } else {
+        app->cursor.move_streak = 0;
+    }
+
+    x = clamp_int(x + dx, 0, render_target_width() - 1);
+    y = clamp_int(y + dy, 0, render_target_height() - 1);
+
+    set_cursor_position(app, x, y);
+}
+
+void apply_input_batch(ApplicationState* app, const InputBatch* batch) {
+    for (int i = 0; i < batch->count && app->current_state != STATE_QUIT; i++) {
+        const InputEntry* entry = &batch->entries[i];
+
+        if (entry->kind == INPUT_CURSOR) {
+            apply_cursor_entry(app, entry);
+            continue;
+        }
+
+        const struct tb_event* event = &entry->event;
+        if (event->type == TB_EVENT_MOUSE) {
+            // Left click: move the cursor there, then activate
+            set_cursor_position(app, event->x, event->y);
+            handle_cursor_click(app);
+        } else if (event->type == TB_EVENT_KEY) {
+            handle_application_input(app, event);
+        }
+
+        // The event may have changed screens; later entries must hit-test
+        // against what will be drawn next
+        update_hover_state(app);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "game.h"
+#include "../lib/termbox2/termbox2.h"
+
+// Upper bound on coalesced entries gathered per frame
+#define INPUT_BATCH_CAPACITY 128
+
+// Raw events kept per batch for replay recording; a batch ends early
+// rather than drop one
+#define INPUT_RAW_CAPACITY 512
+
+// Minimum time between two presented frames
+#define FRAME_INTERVAL_SECONDS (1.0 / 60.0)
+
+typedef enum {
+    INPUT_CURSOR,   // Collapsed run of cursor-movement keys and mouse motion
+    INPUT_EVENT     // Click, key press or resize, delivered unchanged
+} InputKind;
+
+typedef struct {
+    InputKind kind;
+
+    // INPUT_EVENT
+    struct tb_event event;
+
+    // INPUT_CURSOR: last absolute (mouse) position in the run, if any,
+    // followed by the relative key moves that came after it
+    bool has_position;
+    int x;
+    int y;
+    int dx;
+    int dy;
+    int key_moves;  // Key presses summed into dx/dy
+} InputEntry;
+
+typedef struct {
+    InputEntry entries[INPUT_BATCH_CAPACITY];
+    int count;
+    int raw_event_count;  // Events read from termbox before coalescing
+    double first_arrival_time;  // Real clock when the oldest event arrived, 0 if empty
+    struct tb_event raw_events[INPUT_RAW_CAPACITY];  // Same events, uncoalesced
+} InputBatch;
+
+// Waits for the first event, then drains every pending event until the
+// next frame is due. With wake_deadline >= 0 (an animation is running) the
+// wait ends at that time and the batch may come back empty; otherwise it
+// blocks until input arrives. If watch_fd >= 0 the wait also ends, with an
+// empty batch, when that descriptor becomes readable (e.g. a network peer).
+// Events come from the input thread's queue while it runs, otherwise
+// straight from termbox. Returns false if polling failed.
+bool collect_input_batch(InputBatch* batch, double last_present_time, double wake_deadline, int watch_fd);
+
+// Applies entries in order; stops early if the application quits
+void apply_input_batch(ApplicationState* app, const InputBatch* batch);
+
+// Coalescing helpers
+void init_input_batch(InputBatch* batch);
+void append_input_event(InputBatch* batch, const struct tb_event* event);
+
+#endif
@@ -1,11 +1,21 @@
 #include "game.h"
 #include "menu.h"
 #include "game_manager.h"
+#include "render_target.h"
+#include "timing.h"
+#include "netplay.h"
+#include "simulation.h"
+#include "trace.h"
 #include "games/tictactoe.h"
 #include "../lib/termbox2/termbox2.h"
 #include <stdlib.h>
 #include <time.h>
 
+// Animation lengths in seconds
+#define AI_THINKING_CYCLE_SECONDS 1.0
+#define AI_MOVE_FLASH_SECONDS 0.6
+#define MOVE_HIGHLIGHT_SECONDS 0.4
+
 // Register TicTacToe game when module loads
 static void __attribute__((constructor)) register_tictactoe() {
     register_game_interface(GAME_TYPE_TICTACTOE, get_tictactoe_interface());
@@ -121,13 +131,18 @@ void move_cursor(GameState* game, int dx, int dy) {
 
 // Global cursor functions
 void init_global_cursor(GlobalCursor* cursor) {
-    cursor->screen_x = tb_width() / 2;
-    cursor->screen_y = tb_height() / 2;
+    cursor->screen_x = render_target_width() / 2;
+    cursor->screen_y = render_target_height() / 2;
     cursor->hovered_menu_item = -1;
     cursor->hovered_game_cell_x = -1;
     cursor->hovered_game_cell_y = -1;
     cursor->hovered_game_over_option = false;
     cursor->game_over_option_index = -1;
+    cursor->hovered_game_selection = -1;
+    cursor->move_streak = 0;
+    cursor->last_move_dx = 0;
+    cursor->last_move_dy = 0;
+    cursor->last_move_time = 0.0;
 }
 
 void move_global_cursor(ApplicationState* app, int dx, int dy) {
@@ -135,10 +150,10 @@ void move_global_cursor(ApplicationState* app, int dx, int dy) {
     int new_y = app->cursor.screen_y + dy;
     
     // Keep cursor within screen bounds
-    if (new_x >= 0 && new_x < tb_width()) {
+    if (new_x >= 0 && new_x < render_target_width()) {
         app->cursor.screen_x = new_x;
     }
-    if (new_y >= 0 && new_y < tb_height()) {
+    if (new_y >= 0 && new_y < render_target_height()) {
         app->cursor.screen_y = new_y;
     }
     
@@ -148,10 +163,10 @@ void move_global_cursor(ApplicationState* app, int dx, int dy) {
 
 void set_cursor_position(ApplicationState* app, int x, int y) {
     // Set cursor to absolute position (for mouse input)
-    if (x >= 0 && x < tb_width()) {
+    if (x >= 0 && x < render_target_width()) {
         app->cursor.screen_x = x;
     }
-    if (y >= 0 && y < tb_height()) {
+    if (y >= 0 && y < render_target_height()) {
         app->cursor.screen_y = y;
     }
     
@@ -168,90 +183,51 @@ void update_hover_state(ApplicationState* app) {
     app->cursor.game_over_option_index = -1;
     app->cursor.hovered_mode_selection = -1;
     app->cursor.hovered_difficulty_selection = -1;
+    app->cursor.hovered_game_selection = -1;
     
-    int x = app->cursor.screen_x;
-    int y = app->cursor.screen_y;
+    // Layout is rebuilt only when the screen or its contents change
+    refresh_layout(&app->layout, app->current_state, app->has_active_game, render_target_width(), render_target_height());
     
-    if (app->current_state == STATE_MAIN_MENU) {
-        // Check menu items (positioned at center of screen)
-        int x_center = tb_width() / 2;
-        int menu_start_y = 9; // Adjusted for menu position
-        
-        // Menu item areas (approximate)
-        if (x >= x_center - 10 && x <= x_center + 10) {
-            if (y == menu_start_y) {
-                app->cursor.hovered_menu_item = 0; // New Game
-            } else if (app->has_active_game && y == menu_start_y + 1) {
-                app->cursor.hovered_menu_item = 1; // Continue
-            } else if (y == menu_start_y + (app->has_active_game ? 2 : 1)) {
-                app->cursor.hovered_menu_item = app->has_active_game ? 2 : 1; // Quit
-            }
-        }
-    } else if (app->current_state == STATE_MODE_SELECTION) {
-        // Check mode selection items
-        int x_center = tb_width() / 2;
-        int menu_start_y = 7; // Adjusted for mode selection position
-        
-        if (x >= x_center - 15 && x <= x_center + 15) {
-            if (y == menu_start_y) {
-                app->cursor.hovered_mode_selection = 0; // Two Player
-            } else if (y == menu_start_y + 1) {
-                app->cursor.hovered_mode_selection = 1; // Single Player
-            } else if (y == menu_start_y + 2) {
-                app->cursor.hovered_mode_selection = 2; // Back
-            }
-        }
-    } else if (app->current_state == STATE_DIFFICULTY_SELECTION) {
-        // Check difficulty selection items
-        int x_center = tb_width() / 2;
-        int menu_start_y = 7; // Adjusted for difficulty selection position
-        
-        if (x >= x_center - 15 && x <= x_center + 15) {
-            if (y == menu_start_y) {
-                app->cursor.hovered_difficulty_selection = 0; // Easy
-            } else if (y == menu_start_y + 1) {
-                app->cursor.hovered_difficulty_selection = 1; // Medium
-            } else if (y == menu_start_y + 2) {
-                app->cursor.hovered_difficulty_selection = 2; // Hard
-            } else if (y == menu_start_y + 3) {
-                app->cursor.hovered_difficulty_selection = 3; // Back
-            }
-        }
-    } else if (app->current_state == STATE_PLAYING) {
-        // Check game board cells
-        int start_x = tb_width() / 2 - 6;
-        int start_y = 8;
-        
-        for (int row = 0; row < 3; row++) {
-            for (int col = 0; col < 3; col++) {
-                int cell_x = start_x + 2 + col * 4;
-                int cell_y = start_y + 1 + row * 2;
-                
-                // Check if cursor is over this cell (with some tolerance)
-                if (x >= cell_x - 1 && x <= cell_x + 1 && y == cell_y) {
-                    app->cursor.hovered_game_cell_x = col;
-                    app->cursor.hovered_game_cell_y = row;
-                    break;
-                }
-            }
-        }
-    } else if (app->current_state == STATE_GAME_OVER) {
-        // Check game over options
-        int x_center = tb_width() / 2;
-        int options_start_y = 19; // Approximate position of game over options
-        
-        if (x >= x_center - 10 && x <= x_center + 10) {
-            if (y == options_start_y) {
-                app->cursor.hovered_game_over_option = true;
-                app->cursor.game_over_option_index = 0; // Restart
-            } else if (y == options_start_y + 1) {
-                app->cursor.hovered_game_over_option = true;
-                app->cursor.game_over_option_index = 1; // Main Menu
-            } else if (y == options_start_y + 2) {
-                app->cursor.hovered_game_over_option = true;
-                app->cursor.game_over_option_index = 2; // Quit
-            }
-        }
+    const Widget* widget = layout_hit_test(&app->layout, app->cursor.screen_x, app->cursor.screen_y);
+    if (!widget) {
+        return;
+    }
+    
+    switch (widget->kind) {
+        case WIDGET_MENU_ITEM:
+            app->cursor.hovered_menu_item = widget->index;
+            break;
+            
+        case WIDGET_GAME_OPTION:
+            app->cursor.hovered_game_selection = widget->index;
+            break;
+            
+        case WIDGET_MODE_OPTION:
+            app->cursor.hovered_mode_selection = widget->index;
+            break;
+            
+        case WIDGET_DIFFICULTY_OPTION:
+            app->cursor.hovered_difficulty_selection = widget->index;
+            break;
+            
+        case WIDGET_BOARD_CELL:
+            app->cursor.hovered_game_cell_x = widget->index % 3;
+            app->cursor.hovered_game_cell_y = widget->index / 3;
+            break;
+            
+        case WIDGET_GAME_OVER_OPTION:
+            app->cursor.hovered_game_over_option = true;
+            app->cursor.game_over_option_index = widget->index;
+            break;
+    }
+}
+
+void move_cursor_to_next_widget(ApplicationState* app, int direction) {
+    refresh_layout(&app->layout, app->current_state, app->has_active_game, render_target_width(), render_target_height());
+    
+    const Widget* widget = layout_next_widget(&app->layout, app->cursor.screen_x, app->cursor.screen_y, direction);
+    if (widget) {
+        set_cursor_position(app, widget->x + widget->width / 2, widget->y + widget->height / 2);
     }
 }
 
@@ -521,6 +497,8 @@ void trigger_ai_move(ApplicationState* app) {
     
     app->ai_thinking = true;
     app->ai_state.ai_move_in_progress = true;
+    start_animation(&app->animations, ANIMATION_AI_THINKING, get_monotonic_time(),
+                    AI_THINKING_CYCLE_SECONDS, 4, true, -1);
 }
 
 void process_ai_turn(ApplicationState* app) {
@@ -528,8 +506,15 @@ void process_ai_turn(ApplicationState* app) {
         return;
     }
     
+    double search_begin = perf_hud_begin(&app->perf_hud);
     int move_index = get_ai_move(&app->game, app->ai_player, app->ai_difficulty);
+    perf_hud_record_ai_search(&app->perf_hud, search_begin);
     
+    apply_ai_move(app, move_index);
+}
+
+// Plays the AI's chosen move (-1 if it has none) and ends its turn
+void apply_ai_move(ApplicationState* app, int move_index) {
     if (move_index >= 0) {
         int x = move_index % 3;
         int y = move_index / 3;
@@ -537,6 +522,8 @@ void process_ai_turn(ApplicationState* app) {
         if (make_move(&app->game, x, y)) {
             app->ai_state.ai_last_move_x = x;
             app->ai_state.ai_last_move_y = y;
+            start_animation(&app->animations, ANIMATION_AI_MOVE_FLASH, get_monotonic_time(),
+                            AI_MOVE_FLASH_SECONDS, 6, false, move_index);
             
             if (!app->game.game_active) {
                 app->winner = check_winner(&app->game);
@@ -548,45 +535,110 @@ void process_ai_turn(ApplicationState* app) {
     
     app->ai_thinking = false;
     app->ai_state.ai_move_in_progress = false;
+    stop_animation(&app->animations, ANIMATION_AI_THINKING);
+}
+
+// Board history
+static void save_board_snapshot(const ApplicationState* app, BoardSnapshot* snapshot) {
+    snapshot->game = app->game;
+    snapshot->winner = app->winner;
+    snapshot->is_draw = app->is_draw;
+    snapshot->current_state = app->current_state;
+}
+
+static void load_board_snapshot(ApplicationState* app, const BoardSnapshot* snapshot) {
+    app->game = snapshot->game;
+    app->winner = snapshot->winner;
+    app->is_draw = snapshot->is_draw;
+    app->current_state = snapshot->current_state;
+    
+    // A search started for the replaced position is dropped; the AI is
+    // asked again if the restored position has it to move
+    app->ai_thinking = false;
+    app->ai_state.ai_move_in_progress = false;
+    stop_animation(&app->animations, ANIMATION_AI_THINKING);
+}
+
+static void record_board_move(ApplicationState* app) {
+    if (app->netplay) return;
+    
+    BoardSnapshot* snapshot = (BoardSnapshot*)acquire_state_block(&app->board_pool);
+    if (!snapshot) return;
+    
+    save_board_snapshot(app, snapshot);
+    push_snapshot(&app->board_history, &app->board_pool, snapshot);
+}
+
+void clear_board_history(ApplicationState* app) {
+    clear_snapshot_ring(&app->board_history, &app->board_pool);
+}
+
+// Swaps the live board with the snapshot undo or redo hands back
+static bool swap_board_snapshot(ApplicationState* app, bool undo) {
+    SnapshotRing* history = &app->board_history;
+    if (app->netplay || !(undo ? can_undo_snapshot(history) : can_redo_snapshot(history))) {
+        return false;
+    }
+    
+    BoardSnapshot* live = (BoardSnapshot*)acquire_state_block(&app->board_pool);
+    if (!live) return false;
+    
+    save_board_snapshot(app, live);
+    BoardSnapshot* restored = (BoardSnapshot*)(undo ? swap_undo_snapshot(history, live)
+                                                    : swap_redo_snapshot(history, live));
+    load_board_snapshot(app, restored);
+    release_state_block(&app->board_pool, restored);
+    return true;
+}
+
+bool undo_board_move(ApplicationState* app) {
+    return swap_board_snapshot(app, true);
+}
+
+bool redo_board_move(ApplicationState* app) {
+    return swap_board_snapshot(app, false);
 }
 
 void handle_cursor_click(ApplicationState* app) {
     if (app->current_state == STATE_MAIN_MENU && app->cursor.hovered_menu_item >= 0) {
         app->menu_selection = app->cursor.hovered_menu_item;
-        // Navigate to mode selection for New Game
-        if (app->has_active_game) {
-            switch (app->cursor.hovered_menu_item) {
-                case 0: // New Game
-                    app->current_state = STATE_MODE_SELECTION;
-                    app->mode_selection = 0;
-                    break;
-                case 1: // Continue
-                    if (!app->game.game_active && (app->winner != CELL_EMPTY || app->is_draw)) {
-                        app->current_state = STATE_GAME_OVER;
-                    } else {
-                        app->current_state = STATE_PLAYING;
-                    }
-                    break;
-                case 2: // Quit
-                    app->current_state = STATE_QUIT;
-                    break;
-            }
+        // Without a game to continue, items after New Game move up one
+        int item = app->cursor.hovered_menu_item;
+        if (!app->has_active_game && item > 0) {
+            item++;
+        }
+        switch (item) {
+            case 0: // New Game
+                open_board_game_setup(app);
+                break;
+            case 1: // Continue
+                if (!has_active_game_session(app) && !app->game.game_active &&
+                    (app->winner != CELL_EMPTY || app->is_draw)) {
+                    app->current_state = STATE_GAME_OVER;
+                } else {
+                    app->current_state = STATE_PLAYING;
+                }
+                break;
+            case 2: // More Games
+                transition_to_game_selection(app);
+                break;
+            case 3: // Quit
+                app->current_state = STATE_QUIT;
+                break;
+        }
+    } else if (app->current_state == STATE_GAME_SELECTION && app->cursor.hovered_game_selection >= 0) {
+        if (app->cursor.hovered_game_selection < GAME_TYPE_COUNT) {
+            app->game_selection = app->cursor.hovered_game_selection;
+            setup_game_from_selection(app);
         } else {
-            switch (app->cursor.hovered_menu_item) {
-                case 0: // New Game
-                    app->current_state = STATE_MODE_SELECTION;
-                    app->mode_selection = 0;
-                    break;
-                case 1: // Quit
-                    app->current_state = STATE_QUIT;
-                    break;
-            }
+            transition_to_main_menu(app);
         }
     } else if (app->current_state == STATE_MODE_SELECTION && app->cursor.hovered_mode_selection >= 0) {
         switch (app->cursor.hovered_mode_selection) {
             case 0: // Two Player
                 app->game_mode = MODE_TWO_PLAYER;
                 reset_board(&app->game);
+                clear_board_history(app);
                 app->game.game_active = true;
                 app->current_state = STATE_PLAYING;
                 app->has_active_game = true;
@@ -622,6 +674,9 @@ void handle_cursor_click(ApplicationState* app) {
                 app->mode_selection = 0;
                 break;
         }
+    } else if (app->current_state == STATE_PLAYING && has_active_game_session(app)) {
+        // Loaded games record each move so it can be undone
+        handle_current_game_click(&app->game_manager, app->cursor.screen_x, app->cursor.screen_y);
     } else if (app->current_state == STATE_PLAYING && 
                app->cursor.hovered_game_cell_x >= 0 && 
                app->cursor.hovered_game_cell_y >= 0) {
@@ -631,9 +686,28 @@ void handle_cursor_click(ApplicationState* app) {
             return;
         }
         
+        // Online, only the local side's marks are placed from here
+        if (app->netplay && app->game.current_player != app->netplay->local_player) {
+            return;
+        }
+        
         // Try to make a move
         if (app->game.game_active) {
+            double input_time = get_monotonic_time();
+            GameState before = app->game;
+            
+            if (is_valid_move(&app->game, app->cursor.hovered_game_cell_x, app->cursor.hovered_game_cell_y)) {
+                record_board_move(app);
+            }
             if (make_move(&app->game, app->cursor.hovered_game_cell_x, app->cursor.hovered_game_cell_y)) {
+                if (app->netplay) {
+                    netplay_send_move(app->netplay, &before,
+                                      app->cursor.hovered_game_cell_y * 3 + app->cursor.hovered_game_cell_x,
+                                      input_time);
+                }
+                start_animation(&app->animations, ANIMATION_MOVE_HIGHLIGHT, get_monotonic_time(),
+                                MOVE_HIGHLIGHT_SECONDS, 1, false,
+                                app->cursor.hovered_game_cell_y * 3 + app->cursor.hovered_game_cell_x);
                 if (!app->game.game_active) {
                     app->winner = check_winner(&app->game);
                     app->is_draw = (app->winner == CELL_EMPTY);
@@ -648,11 +722,13 @@ void handle_cursor_click(ApplicationState* app) {
                     start_single_player_game(app);
                 } else {
                     reset_board(&app->game);
+                    clear_board_history(app);
                     app->game.game_active = true;
                     app->current_state = STATE_PLAYING;
                     app->winner = CELL_EMPTY;
                     app->is_draw = false;
                     app->has_active_game = true;
+                    if (app->netplay) netplay_send_reset(app->netplay);
                 }
                 break;
             case 1: // Main Menu
@@ -685,23 +761,47 @@ void init_application_state(ApplicationState* app) {
     // UI state
     app->menu_selection = 0;
     app->game_selection = 0;
+    app->game_selection_error = NULL;
     app->mode_selection = 0;
     app->difficulty_selection = 0;
     app->winner = CELL_EMPTY;
     app->is_draw = false;
     app->has_active_game = false;
     
-    // Initialize cursor
+    // Initialize cursor and layout
     init_global_cursor(&app->cursor);
+    init_layout(&app->layout);
+    init_animation_timeline(&app->animations);
+    init_perf_hud(&app->perf_hud);
+    init_move_hints(&app->move_hints);
+    init_state_pool(&app->board_pool, sizeof(BoardSnapshot));
+    init_snapshot_ring(&app->board_history);
     
     // Legacy AI state
     init_ai_state(&app->ai_state);
+    app->netplay = NULL;
+    app->simulation = NULL;
+    
+    // Seed the AI's randomness; replays overwrite it with the recorded seed
+    app->random_seed = (unsigned int)time(NULL);
+    srand(app->random_seed);
     
     // Timing
     app->last_update_time = 0.0;
     app->frame_delta = 0.0;
 }
 
+// Releases what init_application_state allocated
+void cleanup_application_state(ApplicationState* app) {
+    if (!app) return;
+    
+    cleanup_game_manager(&app->game_manager);
+    clear_board_history(app);
+    cleanup_state_pool(&app->board_pool);
+    cleanup_layout(&app->layout);
+    app->has_active_game = false;
+}
+
 bool load_selected_game(ApplicationState* app, GameType game_type) {
     if (!app) return false;
     
@@ -719,6 +819,10 @@ bool load_selected_game(ApplicationState* app, GameType game_type) {
 void unload_current_game(ApplicationState* app) {
     if (!app) return;
     
+    // The game's code may be unloaded next
+    if (app->simulation) {
+        release_simulation_game(app->simulation);
+    }
     unload_current_game(&app->game_manager);
     app->has_active_game = false;
 }
@@ -727,13 +831,81 @@ bool has_active_game_session(const ApplicationState* app) {
     return app && app->has_active_game && is_game_loaded(&app->game_manager);
 }
 
+bool is_game_session_running(const ApplicationState* app) {
+    return has_active_game_session(app) && app->current_state == STATE_PLAYING;
+}
+
 void update_game_state(ApplicationState* app, double delta_time) {
     if (!app || !has_active_game_session(app)) return;
     
+    // Idle and not-yet-due games are skipped
+    double now = get_monotonic_time();
+    double deadline = get_current_game_deadline(&app->game_manager, now);
+    if (deadline < 0.0 || deadline > now) return;
+    
     app->frame_delta = delta_time;
     update_current_game(&app->game_manager, delta_time);
 }
 
+void update_frame(ApplicationState* app, double frame_time) {
+    // Latest simulated state first, since hover is recomputed on top of it
+    if (app->simulation) {
+        adopt_simulation_frame(app);
+    }
+    
+    // Update hover state before rendering
+    {
+        TRACE_SCOPE("update_hover_state");
+        double begin = perf_hud_begin(&app->perf_hud);
+        update_hover_state(app);
+        perf_hud_end(&app->perf_hud, PERF_PHASE_HOVER, begin);
+    }
+    
+    // Sample every animation at this frame's time
+    advance_animation_timeline(&app->animations, frame_time);
+    
+    // Cell values change only with the board, never with the hover
+    if (app->move_hints.visible && app->current_state == STATE_PLAYING) {
+        uint8_t cells[9];
+        for (int i = 0; i < 9; i++) {
+            cells[i] = (uint8_t)app->game.board[i / 3][i % 3];
+        }
+        update_move_hints(&app->move_hints, cells, app->game.current_player);
+    }
+    
+    // Update game state if there's a running game the simulation thread
+    // is not already stepping
+    if (is_game_session_running(app) && !is_simulated_game(app)) {
+        TRACE_SCOPE("update_game_state");
+        double begin = perf_hud_begin(&app->perf_hud);
+        update_game_state(app, 0.016); // Assume 60fps for timing
+        perf_hud_end(&app->perf_hud, PERF_PHASE_UPDATE, begin);
+    }
+}
+
+void process_pending_ai_turn(ApplicationState* app) {
+    if (app->current_state == STATE_PLAYING && app->game_mode == MODE_SINGLE_PLAYER) {
+        if (app->game.current_player == app->ai_player && app->game.game_active && !app->ai_thinking) {
+            trigger_ai_move(app);
+        }
+        
+        // With a simulation thread the search runs there and the move is
+        // played once a later frame adopts its answer, or right away if
+        // pondering found it during the human's turn
+        if (app->ai_thinking && app->simulation) {
+            play_pondered_ai_move(app);
+        } else if (app->ai_thinking) {
+            TRACE_SCOPE("process_ai_turn");
+            process_ai_turn(app);
+        }
+    }
+    
+    // Hand this frame's moves and any AI turn to the simulation thread
+    if (app->simulation) {
+        submit_simulation_work(app);
+    }
+}
+
 // State transition helpers
 void transition_to_game_selection(ApplicationState* app) {
     if (!app) return;
@@ -741,6 +913,7 @@ void transition_to_game_selection(ApplicationState* app) {
     app->previous_state = app->current_state;
     app->current_state = STATE_GAME_SELECTION;
     app->game_selection = 0;
+    app->game_selection_error = NULL;
 }
 
 void transition_to_playing(ApplicationState* app) {
@@ -3,6 +3,13 @@
 
 #include <stdbool.h>
 #include "game_manager.h"
+#include "layout.h"
+#include "animation.h"
+#include "perf_hud.h"
+#include "hints.h"
+
+struct NetplaySession;
+struct SimulationThread;
 
 // Legacy types for backward compatibility (will be removed gradually)
 typedef enum {
@@ -53,6 +60,12 @@ typedef struct {
     int hovered_mode_selection;    // For mode selection screen
     int hovered_difficulty_selection; // For difficulty selection screen
     int hovered_game_selection;    // For game selection screen
+    
+    // Held-key acceleration, see accelerate_cursor_moves
+    int move_streak;               // Same-direction moves in a row
+    int last_move_dx;
+    int last_move_dy;
+    double last_move_time;
 } GlobalCursor;
 
 // AI state tracking
@@ -64,6 +77,14 @@ typedef struct {
     int ai_evaluation_calls;
 } AIState;
 
+// The board's part of the application state, as saved for undo
+typedef struct {
+    GameState game;
+    CellState winner;
+    bool is_draw;
+    AppState current_state;
+} BoardSnapshot;
+
 typedef struct {
     AppState current_state;
     AppState previous_state;  // For returning from pause/options
@@ -82,6 +103,7 @@ typedef struct {
     // UI state
     int menu_selection;
     int game_selection;        // Which game is selected in game selection menu
+    const char* game_selection_error;  // Why the selected game did not start, or NULL
     int mode_selection;
     int difficulty_selection;
     CellState winner;
@@ -91,9 +113,35 @@ typedef struct {
     // Global cursor system (unchanged)
     GlobalCursor cursor;
     
+    // Widget rectangles and hit-test grid for the current screen
+    Layout layout;
+    
+    // Spinner, move highlight and AI-move flash tracks
+    AnimationTimeline animations;
+    
+    // F2 frame-time overlay
+    PerfHud perf_hud;
+    
+    // Solved value of every empty cell, shown on the board with H
+    MoveHints move_hints;
+    
+    // Undo/redo of the board (U / Y); BoardSnapshot blocks
+    StatePool board_pool;
+    SnapshotRing board_history;
+    
     // Legacy AI state (for compatibility)
     AIState ai_state;
     
+    // Remote opponent for networked two-player games, NULL when local
+    struct NetplaySession* netplay;
+    
+    // Runs game updates and AI searches off the frame loop; NULL runs
+    // them inline (replay, recording, network play)
+    struct SimulationThread* simulation;
+    
+    // Seed given to srand(), kept so replays can reproduce AI choices
+    unsigned int random_seed;
+    
     // Timing for games that need it
     double last_update_time;
     double frame_delta;
@@ -114,6 +162,7 @@ void init_global_cursor(GlobalCursor* cursor);
 void move_global_cursor(ApplicationState* app, int dx, int dy);
 void set_cursor_position(ApplicationState* app, int x, int y);
 void update_hover_state(ApplicationState* app);
+void move_cursor_to_next_widget(ApplicationState* app, int direction);
 void handle_cursor_click(ApplicationState* app);
 
 // Legacy AI functions (for backward compatibility)
@@ -131,14 +180,31 @@ int apply_positional_bonus(int x, int y);
 void trigger_ai_move(ApplicationState* app);
 void init_ai_state(AIState* ai_state);
 void process_ai_turn(ApplicationState* app);
+void apply_ai_move(ApplicationState* app, int move_index);
+
+// Board undo/redo. A snapshot is taken before each human move, so in
+// single-player an undo also takes back the AI's reply. Not available in
+// network games.
+void clear_board_history(ApplicationState* app);
+bool undo_board_move(ApplicationState* app);
+bool redo_board_move(ApplicationState* app);
 
 // New game manager integration functions
 void init_application_state(ApplicationState* app);
+void cleanup_application_state(ApplicationState* app);
 bool load_selected_game(ApplicationState* app, GameType game_type);
 void unload_current_game(ApplicationState* app);
 bool has_active_game_session(const ApplicationState* app);
+
+// A loaded game only advances, and only takes keys, while it is on screen
+bool is_game_session_running(const ApplicationState* app);
 void update_game_state(ApplicationState* app, double delta_time);
 
+// Main loop steps shared by the terminal and replay playback: everything
+// before rendering, and the AI turn after input
+void update_frame(ApplicationState* app, double frame_time);
+void process_pending_ai_turn(ApplicationState* app);
+
 // State transition helpers
 void transition_to_game_selection(ApplicationState* app);
 void transition_to_playing(ApplicationState* app);
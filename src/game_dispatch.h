@@ -0,0 +1,58 @@
+#ifndef GAME_DISPATCH_H
+#define GAME_DISPATCH_H
+
+#include "session_table.h"
+
+// Statically dispatched game calls for batched and headless loops.
+//
+// GameInterface stays the ABI: plugins, the UI and mixed tables go through
+// its function pointers. Hot loops that know the game at compile time use
+// StaticGame instead, so each per-session call can be inlined. A game opts
+// in with a CRTP traits type:
+//
+//   struct MyGameStatic : StaticGame<MyGameStatic> {
+//       typedef MyGameState State;
+//       static const GameType type = GAME_TYPE_...;
+//       static void update(State* state, double delta_time);
+//       static double next_update(const State* state, double now);  // -1: idle
+//   };
+template <typename Game>
+struct StaticGame {
+    // Drop-in for update_all_sessions. Sessions of other games in the same
+    // table still update through their interface.
+    static void update_sessions(SessionTable* table, double delta_time) {
+        run_session_update(table, update_range, delta_time);
+    }
+
+private:
+    static void update_range(SessionTable* table, int begin, int end, void* context) {
+        SessionUpdatePass* pass = static_cast<SessionUpdatePass*>(context);
+        double earliest = -1.0;
+
+        for (int i = begin; i < end; i++) {
+            SessionSlot* slot = &table->slots[i];
+            if (!slot->in_use || slot->wake_time < 0.0) continue;
+
+            if (slot->wake_time <= pass->now) {
+                if (slot->game_type == Game::type) {
+                    typename Game::State* state = static_cast<typename Game::State*>(slot->state);
+                    Game::update(state, pass->delta_time);
+                    slot->wake_time = Game::next_update(state, pass->now);
+                } else {
+                    if (slot->interface->update_game) {
+                        slot->interface->update_game(slot->state, pass->delta_time);
+                    }
+                    slot->wake_time = get_game_update_deadline(slot->interface, slot->state, pass->now);
+                }
+            }
+
+            if (slot->wake_time >= 0.0 && (earliest < 0.0 || slot->wake_time < earliest)) {
+                earliest = slot->wake_time;
+            }
+        }
+
+        note_session_wake(pass, earliest);
+    }
+};
+
+#endif
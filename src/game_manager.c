@@ -7,17 +7,39 @@
 // Global registry for game interfaces
 static const GameInterface* game_registry[GAME_TYPE_COUNT] = {NULL};
 
-// Initialize game manager
-void init_game_manager(GameManager* manager) {
-    if (!manager) return;
-    
+static void reset_manager_fields(GameManager* manager) {
     manager->current_game_type = GAME_TYPE_COUNT; // Invalid type initially
     manager->current_game_interface = NULL;
     manager->current_game_state = NULL;
     manager->game_loaded = false;
     manager->game_initialized = false;
+    manager->pending_snapshot = NULL;
+    manager->state_generation = 0;
     manager->last_update_time = 0.0;
     manager->frame_delta = 0.0;
+    init_snapshot_ring(&manager->history);
+}
+
+// Largest state among the registered games
+static size_t get_max_game_state_size(void) {
+    size_t max_size = 0;
+    for (int i = 0; i < GAME_TYPE_COUNT; i++) {
+        if (game_registry[i] && game_registry[i]->game_state_size > max_size) {
+            max_size = game_registry[i]->game_state_size;
+        }
+    }
+    return max_size;
+}
+
+// Initialize game manager
+void init_game_manager(GameManager* manager) {
+    if (!manager) return;
+    
+    reset_manager_fields(manager);
+    
+    // One pool sized for every registered game, so switching games reuses it.
+    // On failure the arena stays NULL and load_game retries.
+    init_state_pool(&manager->state_pool, get_max_game_state_size());
 }
 
 // Load a game by type
@@ -35,11 +57,19 @@ bool load_game(GameManager* manager, GameType game_type) {
         return false;
     }
     
-    // Allocate memory for game state
-    void* game_state = malloc(interface->game_state_size);
+    // Only a game registered after the pool was sized can outgrow it
+    if (!manager->state_pool.arena || interface->game_state_size > manager->state_pool.block_size) {
+        cleanup_state_pool(&manager->state_pool);
+        if (!init_state_pool(&manager->state_pool, interface->game_state_size)) {
+            return false;
+        }
+    }
+    
+    void* game_state = acquire_state_block(&manager->state_pool);
     if (!game_state) {
         return false;
     }
+    memset(game_state, 0, interface->game_state_size);
     
     // Set up the manager
     manager->current_game_type = game_type;
@@ -47,6 +77,7 @@ bool load_game(GameManager* manager, GameType game_type) {
     manager->current_game_state = game_state;
     manager->game_loaded = true;
     manager->game_initialized = false;
+    manager->state_generation++;
     
     return true;
 }
@@ -64,17 +95,19 @@ void unload_current_game(GameManager* manager) {
         manager->current_game_interface->cleanup_game(manager->current_game_state);
     }
     
-    // Free game state memory
-    if (manager->current_game_state) {
-        free(manager->current_game_state);
-        manager->current_game_state = NULL;
-    }
+    // Return the state and its history to the pool
+    clear_snapshot_ring(&manager->history, &manager->state_pool);
+    release_state_block(&manager->state_pool, manager->pending_snapshot);
+    release_state_block(&manager->state_pool, manager->current_game_state);
+    manager->pending_snapshot = NULL;
+    manager->current_game_state = NULL;
     
     // Reset manager state
     manager->current_game_type = GAME_TYPE_COUNT;
     manager->current_game_interface = NULL;
     manager->game_loaded = false;
     manager->game_initialized = false;
+    manager->state_generation++;
 }
 
 // Cleanup game manager
@@ -82,7 +115,8 @@ void cleanup_game_manager(GameManager* manager) {
     if (!manager) return;
     
     unload_current_game(manager);
-    init_game_manager(manager);
+    cleanup_state_pool(&manager->state_pool);
+    reset_manager_fields(manager);
 }
 
 // Game state queries
@@ -117,6 +151,7 @@ bool init_current_game(GameManager* manager) {
     if (manager->current_game_interface->init_game) {
         manager->current_game_interface->init_game(manager->current_game_state);
         manager->game_initialized = true;
+        manager->state_generation++;
         return true;
     }
     
@@ -133,6 +168,10 @@ void reset_current_game(GameManager* manager) {
     if (manager->current_game_interface->reset_game) {
         manager->current_game_interface->reset_game(manager->current_game_state);
     }
+    
+    // A fresh game has nothing to undo
+    clear_snapshot_ring(&manager->history, &manager->state_pool);
+    manager->state_generation++;
 }
 
 void update_current_game(GameManager* manager, double delta_time) {
@@ -149,6 +188,121 @@ void update_current_game(GameManager* manager, double delta_time) {
     }
 }
 
+double get_current_game_deadline(const GameManager* manager, double now) {
+    if (!manager || !manager->game_loaded || 
+        !manager->current_game_interface || 
+        !manager->current_game_state) {
+        return -1.0;
+    }
+    
+    return get_game_update_deadline(manager->current_game_interface, manager->current_game_state, now);
+}
+
+// Move history
+bool begin_current_game_move(GameManager* manager) {
+    if (!manager || !manager->game_loaded || !manager->current_game_state) {
+        return false;
+    }
+    
+    if (!manager->pending_snapshot) {
+        manager->pending_snapshot = acquire_state_block(&manager->state_pool);
+        if (!manager->pending_snapshot) {
+            return false;
+        }
+    }
+    
+    memcpy(manager->pending_snapshot, manager->current_game_state,
+           manager->current_game_interface->game_state_size);
+    return true;
+}
+
+void commit_current_game_move(GameManager* manager) {
+    if (!manager || !manager->pending_snapshot) {
+        return;
+    }
+    
+    push_snapshot(&manager->history, &manager->state_pool, manager->pending_snapshot);
+    manager->pending_snapshot = NULL;
+}
+
+void cancel_current_game_move(GameManager* manager) {
+    if (!manager || !manager->pending_snapshot) {
+        return;
+    }
+    
+    release_state_block(&manager->state_pool, manager->pending_snapshot);
+    manager->pending_snapshot = NULL;
+}
+
+// Each click that lands is a move and is recorded
+bool handle_current_game_click(GameManager* manager, int x, int y) {
+    if (!manager || !manager->game_loaded || 
+        !manager->current_game_interface ||
+        !manager->current_game_interface->handle_cursor_click) {
+        return false;
+    }
+    
+    bool recording = begin_current_game_move(manager);
+    bool moved = manager->current_game_interface->handle_cursor_click(manager->current_game_state, x, y);
+    
+    if (recording) {
+        if (moved) {
+            commit_current_game_move(manager);
+        } else {
+            cancel_current_game_move(manager);
+        }
+    }
+    if (moved) {
+        manager->state_generation++;
+    }
+    
+    return moved;
+}
+
+// Keys steer real-time games; they are not moves and are not recorded
+bool handle_current_game_input(GameManager* manager, const struct tb_event* event, const void* cursor) {
+    if (!manager || !manager->game_loaded || 
+        !manager->current_game_interface ||
+        !manager->current_game_interface->handle_input) {
+        return false;
+    }
+    
+    bool handled = manager->current_game_interface->handle_input(manager->current_game_state, event, cursor);
+    if (handled) {
+        manager->state_generation++;
+    }
+    
+    return handled;
+}
+
+bool can_undo_current_game(const GameManager* manager) {
+    return manager && manager->game_loaded && can_undo_snapshot(&manager->history);
+}
+
+bool can_redo_current_game(const GameManager* manager) {
+    return manager && manager->game_loaded && can_redo_snapshot(&manager->history);
+}
+
+bool undo_current_game_move(GameManager* manager) {
+    if (!can_undo_current_game(manager)) {
+        return false;
+    }
+    
+    manager->current_game_state = swap_undo_snapshot(&manager->history, manager->current_game_state);
+    manager->state_generation++;
+    return true;
+}
+
+bool redo_current_game_move(GameManager* manager) {
+    if (!can_redo_current_game(manager)) {
+        return false;
+    }
+    
+    manager->current_game_state = swap_redo_snapshot(&manager->history, manager->current_game_state);
+    manager->state_generation++;
+    return true;
+}
+
 // Utility functions
 const char* get_game_name(GameType game_type) {
     const GameInterface* interface = get_game_interface(game_type);
@@ -164,6 +318,25 @@ bool is_valid_game_type(GameType game_type) {
     return (game_type >= 0 && game_type < GAME_TYPE_COUNT);
 }
 
+double get_game_update_deadline(const GameInterface* interface, const void* game_state, double now) {
+    if (!interface->update_game) {
+        return -1.0;
+    }
+    if (!interface->next_update) {
+        return now;
+    }
+    
+    GameUpdateSchedule schedule = interface->next_update(game_state, now);
+    switch (schedule.kind) {
+        case GAME_UPDATE_IDLE:
+            return -1.0;
+        case GAME_UPDATE_AT:
+            return schedule.deadline;
+        default:
+            return now;
+    }
+}
+
 // Game interface registration and retrieval
 void register_game_interface(GameType game_type, const GameInterface* interface) {
     if (is_valid_game_type(game_type) && interface) {
@@ -171,6 +344,12 @@ void register_game_interface(GameType game_type, const GameInterface* interface)
     }
 }
 
+void unregister_game_interface(GameType game_type) {
+    if (is_valid_game_type(game_type)) {
+        game_registry[game_type] = NULL;
+    }
+}
+
 const GameInterface* get_game_interface(GameType game_type) {
     if (is_valid_game_type(game_type)) {
         return game_registry[game_type];
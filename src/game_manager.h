@@ -2,8 +2,10 @@
 #define GAME_MANAGER_H
 
 #include "games/game_interface.h"
+#include "state_history.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Game manager structure
 typedef struct {
@@ -13,6 +15,15 @@ typedef struct {
     bool game_loaded;
     bool game_initialized;
     
+    // Game states live in pooled blocks; the pool outlives game reloads
+    StatePool state_pool;
+    SnapshotRing history;
+    void* pending_snapshot;   // Copy taken before a move, until it commits
+    
+    // Bumped by every change made outside update_game (load, moves,
+    // undo), so copies stepped elsewhere can tell they are out of date
+    uint64_t state_generation;
+    
     // Timing for games that need it
     double last_update_time;
     double frame_delta;
@@ -36,6 +47,20 @@ bool init_current_game(GameManager* manager);
 void reset_current_game(GameManager* manager);
 void update_current_game(GameManager* manager, double delta_time);
 
+// When the current game next needs an update; -1 while it is idle
+double get_current_game_deadline(const GameManager* manager, double now);
+
+// Move history (snapshots come from the state pool, never the heap)
+bool begin_current_game_move(GameManager* manager);
+void commit_current_game_move(GameManager* manager);
+void cancel_current_game_move(GameManager* manager);
+bool handle_current_game_click(GameManager* manager, int x, int y);
+bool handle_current_game_input(GameManager* manager, const struct tb_event* event, const void* cursor);
+bool can_undo_current_game(const GameManager* manager);
+bool can_redo_current_game(const GameManager* manager);
+bool undo_current_game_move(GameManager* manager);
+bool redo_current_game_move(GameManager* manager);
+
 // Utility functions
 const char* get_game_name(GameType game_type);
 const char* get_game_description(GameType game_type);
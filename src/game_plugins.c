@@ -0,0 +1,170 @@
+#include "game_plugins.h"
+#include <dirent.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    bool available;
+    char path[PATH_MAX];
+    void* handle;
+    const GameInterface* interface;
+} GamePlugin;
+
+static GamePlugin game_plugins[GAME_TYPE_COUNT];
+
+// Why the last load_game_plugin failed, for the game selection screen
+static char game_plugin_error[PATH_MAX + 256];
+
+static const char* const game_plugin_names[GAME_TYPE_COUNT] = {
+    "tictactoe",
+    "tetris",
+    "snake"
+};
+
+const char* get_game_plugin_name(GameType game_type) {
+    return (game_type >= 0 && game_type < GAME_TYPE_COUNT) ? game_plugin_names[game_type] : NULL;
+}
+
+// $TICTACTOE_GAME_DIR, or the default directory beside the executable
+static void get_default_plugin_directory(char* buffer, size_t size) {
+    const char* from_env = getenv(GAME_PLUGIN_DIR_ENV);
+    if (from_env && *from_env) {
+        snprintf(buffer, size, "%s", from_env);
+        return;
+    }
+
+    char executable[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length > 0) {
+        executable[length] = '\0';
+        char* slash = strrchr(executable, '/');
+        if (slash) {
+            *slash = '\0';
+            snprintf(buffer, size, "%s/%s", executable, GAME_PLUGIN_DEFAULT_DIR);
+            return;
+        }
+    }
+
+    snprintf(buffer, size, "%s", GAME_PLUGIN_DEFAULT_DIR);
+}
+
+int discover_game_plugins(const char* directory) {
+    char default_directory[PATH_MAX];
+    if (!directory) {
+        get_default_plugin_directory(default_directory, sizeof(default_directory));
+        directory = default_directory;
+    }
+
+    DIR* dir = opendir(directory);
+    if (!dir) {
+        return 0;
+    }
+
+    int found = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length <= 3 || strcmp(entry->d_name + length - 3, ".so") != 0) {
+            continue;
+        }
+
+        for (int i = 0; i < GAME_TYPE_COUNT; i++) {
+            size_t name_length = strlen(game_plugin_names[i]);
+            if (name_length != length - 3 || strncmp(entry->d_name, game_plugin_names[i], name_length) != 0 ||
+                game_plugins[i].handle) {
+                continue;
+            }
+
+            int written = snprintf(game_plugins[i].path, sizeof(game_plugins[i].path), "%s/%s",
+                                   directory, entry->d_name);
+            if (written > 0 && (size_t)written < sizeof(game_plugins[i].path)) {
+                game_plugins[i].available = true;
+                found++;
+            }
+        }
+    }
+
+    closedir(dir);
+    return found;
+}
+
+bool is_game_plugin_available(GameType game_type) {
+    return get_game_plugin_name(game_type) && game_plugins[game_type].available;
+}
+
+bool is_game_plugin_loaded(GameType game_type) {
+    return get_game_plugin_name(game_type) && game_plugins[game_type].handle != NULL;
+}
+
+const char* get_game_plugin_error(void) {
+    return game_plugin_error[0] ? game_plugin_error : NULL;
+}
+
+bool load_game_plugin(GameType game_type) {
+    game_plugin_error[0] = '\0';
+    if (!get_game_plugin_name(game_type)) {
+        return false;
+    }
+
+    GamePlugin* plugin = &game_plugins[game_type];
+    if (plugin->handle) {
+        return true;
+    }
+
+    // Built-in games need no plugin
+    if (get_game_interface(game_type)) {
+        return true;
+    }
+
+    if (!plugin->available) {
+        snprintf(game_plugin_error, sizeof(game_plugin_error), "Not installed: no %s.so in the games directory",
+                 game_plugin_names[game_type]);
+        return false;
+    }
+
+    void* handle = dlopen(plugin->path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        snprintf(game_plugin_error, sizeof(game_plugin_error), "Cannot load %s: %s", plugin->path, dlerror());
+        return false;
+    }
+
+    typedef const GameInterface* (*PluginEntry)(void);
+    PluginEntry entry = (PluginEntry)dlsym(handle, GAME_PLUGIN_ENTRY_SYMBOL);
+    const GameInterface* interface = entry ? entry() : NULL;
+    if (!interface) {
+        snprintf(game_plugin_error, sizeof(game_plugin_error), "%s does not export %s",
+                 plugin->path, GAME_PLUGIN_ENTRY_SYMBOL);
+        dlclose(handle);
+        return false;
+    }
+
+    plugin->handle = handle;
+    plugin->interface = interface;
+    register_game_interface(game_type, interface);
+    return true;
+}
+
+void unload_game_plugin(GameType game_type) {
+    if (!is_game_plugin_loaded(game_type)) {
+        return;
+    }
+
+    GamePlugin* plugin = &game_plugins[game_type];
+    if (get_game_interface(game_type) == plugin->interface) {
+        unregister_game_interface(game_type);
+    }
+
+    dlclose(plugin->handle);
+    plugin->handle = NULL;
+    plugin->interface = NULL;
+}
+
+void unload_all_game_plugins(void) {
+    for (int i = 0; i < GAME_TYPE_COUNT; i++) {
+        unload_game_plugin((GameType)i);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef GAME_PLUGINS_H
+#define GAME_PLUGINS_H
+
+#include "games/game_interface.h"
+#include <stdbool.h>
+
+// Plugin directory: $TICTACTOE_GAME_DIR, else "games" next to the executable.
+// A plugin is <name>.so, where <name> is the game's file name below
+// (e.g. games/tetris.so), and exports GAME_PLUGIN_ENTRY_SYMBOL.
+#define GAME_PLUGIN_DIR_ENV "TICTACTOE_GAME_DIR"
+#define GAME_PLUGIN_DEFAULT_DIR "games"
+
+// File name stem used for a game type's plugin
+const char* get_game_plugin_name(GameType game_type);
+
+// Records which plugins exist without opening any of them
+int discover_game_plugins(const char* directory);
+bool is_game_plugin_available(GameType game_type);
+bool is_game_plugin_loaded(GameType game_type);
+
+// dlopen/dlclose; loading registers the plugin's interface. Built-in games
+// are left alone. Unload only after every state of that game is gone.
+// A failed load leaves a message for the UI in get_game_plugin_error(),
+// NULL after a successful one.
+bool load_game_plugin(GameType game_type);
+void unload_game_plugin(GameType game_type);
+void unload_all_game_plugins(void);
+const char* get_game_plugin_error(void);
+
+#endif
@@ -7,6 +7,18 @@
 // Forward declarations
 struct tb_event;
 
+// When a game next needs update_game
+typedef enum {
+    GAME_UPDATE_IDLE,         // Nothing to do until input changes the state
+    GAME_UPDATE_AT,           // At deadline (monotonic seconds)
+    GAME_UPDATE_CONTINUOUS    // Every frame
+} GameUpdateKind;
+
+typedef struct {
+    GameUpdateKind kind;
+    double deadline;
+} GameUpdateSchedule;
+
 // Core game interface structure
 typedef struct GameInterface {
     // Game identification
@@ -17,6 +29,7 @@ typedef struct GameInterface {
     void (*init_game)(void* game_state);
     void (*reset_game)(void* game_state);
     void (*update_game)(void* game_state, double delta_time);
+    GameUpdateSchedule (*next_update)(const void* game_state, double now);  // NULL: continuous
     bool (*is_game_active)(const void* game_state);
     bool (*is_game_over)(const void* game_state);
     
@@ -38,7 +51,8 @@ typedef struct GameInterface {
     const char* (*get_status_text)(const void* game_state);
     const char* (*get_winner_text)(const void* game_state);
     
-    // Memory management
+    // Memory management. States are copied byte-wise for undo snapshots,
+    // so they must not own heap memory.
     size_t game_state_size;
     void (*cleanup_game)(void* game_state);
 } GameInterface;
@@ -54,7 +68,20 @@ typedef enum {
 // Function to get game interface by type
 const GameInterface* get_game_interface(GameType game_type);
 
+// next_update as a deadline: -1 when idle, now when continuous
+double get_game_update_deadline(const GameInterface* interface, const void* game_state, double now);
+
 // Game registration function (to be called by each game module)
 void register_game_interface(GameType game_type, const GameInterface* interface);
+void unregister_game_interface(GameType game_type);
+
+// Games built as shared objects export this instead of registering:
+//   GAME_PLUGIN_EXPORT const GameInterface* game_plugin_interface(void);
+#define GAME_PLUGIN_ENTRY_SYMBOL "game_plugin_interface"
+#ifdef __cplusplus
+#define GAME_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#else
+#define GAME_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,269 @@
+// Snake, built as games/snake.so and loaded when picked under More Games
+#include "../game_interface.h"
+#include "../../render_target.h"
+#include "../../timing.h"
+#include "../../../lib/termbox2/termbox2.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Playfield in cells, inside a one-cell frame
+#define SNAKE_WIDTH 30
+#define SNAKE_HEIGHT 12
+#define SNAKE_CELLS (SNAKE_WIDTH * SNAKE_HEIGHT)
+#define SNAKE_START_LENGTH 3
+#define SNAKE_STEP_SECONDS 0.12
+#define SNAKE_FIELD_TOP 6
+
+// Fixed-size arrays only: the host copies states byte-wise
+typedef struct {
+    uint16_t body[SNAKE_CELLS];    // Ring of cell indices, head at body[head]
+    uint8_t occupied[SNAKE_CELLS];
+    int head;
+    int length;
+    int dx;
+    int dy;
+    int next_dx;                   // Direction taken on the next step
+    int next_dy;
+    int food;
+    int score;
+    bool alive;
+    bool won;
+    double next_step_time;         // Monotonic seconds
+} SnakeState;
+
+static char status_buffer[64];
+
+static void place_food(SnakeState* snake) {
+    int free_cells = SNAKE_CELLS - snake->length;
+    if (free_cells <= 0) {
+        snake->food = -1;
+        return;
+    }
+
+    int pick = rand() % free_cells;
+    for (int cell = 0; cell < SNAKE_CELLS; cell++) {
+        if (!snake->occupied[cell] && pick-- == 0) {
+            snake->food = cell;
+            return;
+        }
+    }
+}
+
+static void snake_init(void* state) {
+    SnakeState* snake = (SnakeState*)state;
+    memset(snake, 0, sizeof(*snake));
+
+    // Heading right from the middle of the field, tail first in the ring
+    int y = SNAKE_HEIGHT / 2;
+    for (int i = 0; i < SNAKE_START_LENGTH; i++) {
+        int cell = y * SNAKE_WIDTH + SNAKE_WIDTH / 4 + i;
+        snake->body[i] = (uint16_t)cell;
+        snake->occupied[cell] = 1;
+    }
+    snake->head = SNAKE_START_LENGTH - 1;
+    snake->length = SNAKE_START_LENGTH;
+    snake->dx = snake->next_dx = 1;
+    snake->dy = snake->next_dy = 0;
+    snake->alive = true;
+    snake->next_step_time = get_monotonic_time() + SNAKE_STEP_SECONDS;
+    place_food(snake);
+}
+
+static void snake_step(SnakeState* snake) {
+    snake->dx = snake->next_dx;
+    snake->dy = snake->next_dy;
+
+    int cell = snake->body[snake->head];
+    int x = cell % SNAKE_WIDTH + snake->dx;
+    int y = cell / SNAKE_WIDTH + snake->dy;
+    if (x < 0 || x >= SNAKE_WIDTH || y < 0 || y >= SNAKE_HEIGHT) {
+        snake->alive = false;
+        return;
+    }
+
+    // The tail moves out of the way first, unless the snake grows
+    int next = y * SNAKE_WIDTH + x;
+    bool eating = (next == snake->food);
+    if (!eating) {
+        int tail = snake->body[(snake->head - snake->length + 1 + SNAKE_CELLS) % SNAKE_CELLS];
+        snake->occupied[tail] = 0;
+    }
+    if (snake->occupied[next]) {
+        snake->alive = false;
+        return;
+    }
+
+    snake->head = (snake->head + 1) % SNAKE_CELLS;
+    snake->body[snake->head] = (uint16_t)next;
+    snake->occupied[next] = 1;
+
+    if (eating) {
+        snake->length++;
+        snake->score++;
+        if (snake->length == SNAKE_CELLS) {
+            snake->won = true;
+            snake->alive = false;
+        }
+        place_food(snake);
+    }
+}
+
+// Steps on the clock rather than delta_time, so inline and threaded
+// updates move at the same speed; after a pause it resumes one step later
+static void snake_update(void* state, double delta_time) {
+    SnakeState* snake = (SnakeState*)state;
+    (void)delta_time;
+
+    double now = get_monotonic_time();
+    if (!snake->alive || now < snake->next_step_time) {
+        return;
+    }
+
+    snake_step(snake);
+    snake->next_step_time += SNAKE_STEP_SECONDS;
+    if (snake->next_step_time <= now) {
+        snake->next_step_time = now + SNAKE_STEP_SECONDS;
+    }
+}
+
+static GameUpdateSchedule snake_next_update(const void* state, double now) {
+    const SnakeState* snake = (const SnakeState*)state;
+    (void)now;
+
+    GameUpdateSchedule schedule = {GAME_UPDATE_IDLE, 0.0};
+    if (snake->alive) {
+        schedule.kind = GAME_UPDATE_AT;
+        schedule.deadline = snake->next_step_time;
+    }
+    return schedule;
+}
+
+static bool snake_is_active(const void* state) {
+    return ((const SnakeState*)state)->alive;
+}
+
+static bool snake_is_over(const void* state) {
+    return !((const SnakeState*)state)->alive;
+}
+
+// Arrows and WASD turn the snake; turning back onto itself is ignored
+static bool snake_handle_input(void* state, const struct tb_event* event, const void* cursor) {
+    SnakeState* snake = (SnakeState*)state;
+    (void)cursor;
+
+    if (!snake->alive || event->type != TB_EVENT_KEY) {
+        return false;
+    }
+
+    int dx = 0, dy = 0;
+    if (event->key == TB_KEY_ARROW_UP || event->ch == 'w' || event->ch == 'W') {
+        dy = -1;
+    } else if (event->key == TB_KEY_ARROW_DOWN || event->ch == 's' || event->ch == 'S') {
+        dy = 1;
+    } else if (event->key == TB_KEY_ARROW_LEFT || event->ch == 'a' || event->ch == 'A') {
+        dx = -1;
+    } else if (event->key == TB_KEY_ARROW_RIGHT || event->ch == 'd' || event->ch == 'D') {
+        dx = 1;
+    } else {
+        return false;
+    }
+
+    if (dx != -snake->dx || dy != -snake->dy) {
+        snake->next_dx = dx;
+        snake->next_dy = dy;
+    }
+    return true;
+}
+
+static void snake_render(const void* state, int screen_width, int screen_height) {
+    const SnakeState* snake = (const SnakeState*)state;
+    (void)screen_height;
+
+    int left = screen_width / 2 - (SNAKE_WIDTH + 2) / 2;
+    int top = SNAKE_FIELD_TOP;
+
+    // Frame
+    render_target_set_cell(left, top, 0x250C, TB_DEFAULT, TB_DEFAULT);
+    render_target_set_cell(left + SNAKE_WIDTH + 1, top, 0x2510, TB_DEFAULT, TB_DEFAULT);
+    render_target_set_cell(left, top + SNAKE_HEIGHT + 1, 0x2514, TB_DEFAULT, TB_DEFAULT);
+    render_target_set_cell(left + SNAKE_WIDTH + 1, top + SNAKE_HEIGHT + 1, 0x2518, TB_DEFAULT, TB_DEFAULT);
+    for (int x = 1; x <= SNAKE_WIDTH; x++) {
+        render_target_set_cell(left + x, top, 0x2500, TB_DEFAULT, TB_DEFAULT);
+        render_target_set_cell(left + x, top + SNAKE_HEIGHT + 1, 0x2500, TB_DEFAULT, TB_DEFAULT);
+    }
+    for (int y = 1; y <= SNAKE_HEIGHT; y++) {
+        render_target_set_cell(left, top + y, 0x2502, TB_DEFAULT, TB_DEFAULT);
+        render_target_set_cell(left + SNAKE_WIDTH + 1, top + y, 0x2502, TB_DEFAULT, TB_DEFAULT);
+    }
+
+    if (snake->food >= 0) {
+        render_target_set_cell(left + 1 + snake->food % SNAKE_WIDTH, top + 1 + snake->food / SNAKE_WIDTH,
+                               '*', TB_RED | TB_BOLD, TB_DEFAULT);
+    }
+
+    uintattr_t body_color = snake->alive ? TB_GREEN : TB_RED;
+    for (int i = 0; i < snake->length; i++) {
+        int cell = snake->body[(snake->head - i + SNAKE_CELLS) % SNAKE_CELLS];
+        render_target_set_cell(left + 1 + cell % SNAKE_WIDTH, top + 1 + cell / SNAKE_WIDTH,
+                               i == 0 ? '@' : 'o', body_color | (i == 0 ? TB_BOLD : 0), TB_DEFAULT);
+    }
+}
+
+static const char* snake_get_status_text(const void* state) {
+    const SnakeState* snake = (const SnakeState*)state;
+
+    if (snake->won) {
+        snprintf(status_buffer, sizeof(status_buffer), "SNAKE  The field is full! Score %d", snake->score);
+    } else if (!snake->alive) {
+        snprintf(status_buffer, sizeof(status_buffer), "SNAKE  Game over, score %d  [R] Restart", snake->score);
+    } else {
+        snprintf(status_buffer, sizeof(status_buffer), "SNAKE  Score %d", snake->score);
+    }
+    return status_buffer;
+}
+
+static void snake_render_ui(const void* state) {
+    int x_center = render_target_width() / 2;
+    render_target_print(x_center - 8, 5, TB_DEFAULT, TB_DEFAULT, snake_get_status_text(state));
+}
+
+static bool snake_has_winner(const void* state) {
+    return ((const SnakeState*)state)->won;
+}
+
+static bool snake_is_draw(const void* state) {
+    (void)state;
+    return false;
+}
+
+static const char* snake_get_winner_text(const void* state) {
+    return ((const SnakeState*)state)->won ? "You" : "None";
+}
+
+static const GameInterface snake_interface = {
+    .game_name = "Snake",
+    .game_description = "Steer the snake to the food without hitting a wall or itself",
+    .init_game = snake_init,
+    .reset_game = snake_init,
+    .update_game = snake_update,
+    .next_update = snake_next_update,
+    .is_game_active = snake_is_active,
+    .is_game_over = snake_is_over,
+    .handle_input = snake_handle_input,
+    .handle_cursor_click = NULL,
+    .render_game = snake_render,
+    .render_game_ui = snake_render_ui,
+    .update_hover_state = NULL,
+    .has_winner = snake_has_winner,
+    .is_draw = snake_is_draw,
+    .get_status_text = snake_get_status_text,
+    .get_winner_text = snake_get_winner_text,
+    .game_state_size = sizeof(SnakeState),
+    .cleanup_game = NULL
+};
+
+GAME_PLUGIN_EXPORT const GameInterface* game_plugin_interface(void) {
+    return &snake_interface;
+}
@@ -1,12 +1,65 @@
 #include "tictactoe.h"
 #include "../game.h"
+#include "../render_target.h"
 #include "../../lib/termbox2/termbox2.h"
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 
-// Static buffer for status text
+// Static buffers for status text; status is re-formatted only when its inputs change
 static char status_buffer[256];
+static int status_buffer_key = -1;
+static char winner_buffer[32];
+
+// Board geometry
+void tictactoe_get_board_origin(int screen_width, int* board_x, int* board_y) {
+    *board_x = screen_width / 2 - TICTACTOE_BOARD_WIDTH / 2;
+    *board_y = TICTACTOE_BOARD_TOP;
+}
+
+void tictactoe_get_cell_center(int board_x, int board_y, int col, int row, int* x, int* y) {
+    *x = board_x + 2 + col * 4;
+    *y = board_y + 1 + row * 2;
+}
+
+bool tictactoe_board_hit_test(int board_x, int board_y, int x, int y, int* col, int* row) {
+    // Cell interiors are 3 columns wide and 1 row high, separated by frame lines
+    int dx = x - board_x - 1;
+    int dy = y - board_y - 1;
+    
+    if (dx < 0 || dy < 0 || dx % 4 == 3 || dy % 2 == 1) {
+        return false;
+    }
+    if (dx / 4 >= 3 || dy / 2 >= 3) {
+        return false;
+    }
+    
+    *col = dx / 4;
+    *row = dy / 2;
+    return true;
+}
+
+// Board frame, decoded from UTF-8 once
+const Sprite* tictactoe_get_board_frame(void) {
+    static Sprite frame;
+    static bool built = false;
+    
+    if (!built) {
+        static const char* const lines[TICTACTOE_BOARD_HEIGHT] = {
+            "┌───┬───┬───┐",
+            "│   │   │   │",
+            "├───┼───┼───┤",
+            "│   │   │   │",
+            "├───┼───┼───┤",
+            "│   │   │   │",
+            "└───┴───┴───┘"
+        };
+        init_sprite(&frame);
+        built = build_sprite(&frame, lines, TICTACTOE_BOARD_HEIGHT, TB_DEFAULT, TB_DEFAULT);
+    }
+    
+    return &frame;
+}
 
 // Core game logic functions
 void tictactoe_init_game_state(TicTacToeGameState* game) {
@@ -422,7 +475,7 @@ void tictactoe_update(void* state, double delta_time) {
     TicTacToeGameState* game = (TicTacToeGameState*)state;
     
     // Process AI turn if needed
-    if (game->game_mode == TICTACTOE_MODE_SINGLE_PLAYER) {
+    if (tictactoe_needs_update(game)) {
         if (game->current_player == game->ai_player && game->game_active && !game->ai_thinking) {
             tictactoe_trigger_ai_move(game);
         }
@@ -436,6 +489,18 @@ void tictactoe_update(void* state, double delta_time) {
     (void)delta_time;
 }
 
+GameUpdateSchedule tictactoe_next_update(const void* state, double now) {
+    const TicTacToeGameState* game = (const TicTacToeGameState*)state;
+    
+    // Turn-based: only a pending AI turn needs an update, and it is due now
+    GameUpdateSchedule schedule = {GAME_UPDATE_IDLE, 0.0};
+    if (tictactoe_needs_update(game)) {
+        schedule.kind = GAME_UPDATE_AT;
+        schedule.deadline = now;
+    }
+    return schedule;
+}
+
 bool tictactoe_is_active(const void* state) {
     const TicTacToeGameState* game = (const TicTacToeGameState*)state;
     return game->game_active;
@@ -459,41 +524,54 @@ bool tictactoe_handle_cursor_click(void* state, int x, int y) {
     TicTacToeGameState* game = (TicTacToeGameState*)state;
     
     // Convert screen coordinates to board coordinates
-    // This is a simplified conversion - actual implementation would need
-    // to match the rendering logic
-    int start_x = x - 10; // Approximate board start position
-    int start_y = y - 8;
-    
-    if (start_x >= 0 && start_x < 12 && start_y >= 0 && start_y < 6) {
-        int cell_x = start_x / 4;
-        int cell_y = start_y / 2;
-        
-        if (cell_x >= 0 && cell_x < 3 && cell_y >= 0 && cell_y < 3) {
-            // Skip move if it's AI's turn in single player mode
-            if (game->game_mode == TICTACTOE_MODE_SINGLE_PLAYER && 
-                game->current_player == game->ai_player) {
-                return false;
-            }
-            
-            return tictactoe_make_move(game, cell_x, cell_y);
+    int board_x, board_y;
+    int cell_x, cell_y;
+    tictactoe_get_board_origin(render_target_width(), &board_x, &board_y);
+    
+    if (tictactoe_board_hit_test(board_x, board_y, x, y, &cell_x, &cell_y)) {
+        // Skip move if it's AI's turn in single player mode
+        if (game->game_mode == TICTACTOE_MODE_SINGLE_PLAYER && 
+            game->current_player == game->ai_player) {
+            return false;
         }
+        
+        return tictactoe_make_move(game, cell_x, cell_y);
     }
     
     return false;
 }
 
 void tictactoe_render(const void* state, int screen_width, int screen_height) {
-    // Rendering will be handled by the generic render pipeline
-    // This is a placeholder
-    (void)state;
-    (void)screen_width;
+    const TicTacToeGameState* game = (const TicTacToeGameState*)state;
     (void)screen_height;
+    
+    int board_x, board_y;
+    tictactoe_get_board_origin(screen_width, &board_x, &board_y);
+    blit_sprite(tictactoe_get_board_frame(), board_x, board_y);
+    
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            int cell_x, cell_y;
+            tictactoe_get_cell_center(board_x, board_y, col, row, &cell_x, &cell_y);
+            
+            char symbol = ' ';
+            if (game->board[row][col] == TICTACTOE_CELL_X) {
+                symbol = 'X';
+            } else if (game->board[row][col] == TICTACTOE_CELL_O) {
+                symbol = 'O';
+            }
+            
+            bool hovered = (game->hovered_cell_x == col && game->hovered_cell_y == row);
+            render_target_set_cell(cell_x, cell_y, symbol,
+                                   hovered ? TB_BLACK : TB_DEFAULT,
+                                   hovered ? TB_YELLOW : TB_DEFAULT);
+        }
+    }
 }
 
 void tictactoe_render_ui(const void* state) {
-    // UI rendering will be handled by the generic render pipeline
-    // This is a placeholder
-    (void)state;
+    int x_center = render_target_width() / 2;
+    render_target_print(x_center - 8, 5, TB_DEFAULT, TB_DEFAULT, tictactoe_get_status_text(state));
 }
 
 bool tictactoe_update_hover_state(void* state, const void* cursor) {
@@ -507,23 +585,15 @@ bool tictactoe_update_hover_state(void* state, const void* cursor) {
     game->hovered_cell_x = -1;
     game->hovered_cell_y = -1;
     
-    // Calculate game board area (this needs to match rendering logic)
-    int start_x = 10; // Approximate board start position
-    int start_y = 8;
+    // Board area matches the rendering logic
+    int board_x, board_y;
+    int col, row;
+    tictactoe_get_board_origin(render_target_width(), &board_x, &board_y);
     
-    for (int row = 0; row < 3; row++) {
-        for (int col = 0; col < 3; col++) {
-            int cell_x = start_x + 2 + col * 4;
-            int cell_y = start_y + 1 + row * 2;
-            
-            // Check if cursor is over this cell (with some tolerance)
-            if (global_cursor->screen_x >= cell_x - 1 && global_cursor->screen_x <= cell_x + 1 && 
-                global_cursor->screen_y == cell_y) {
-                game->hovered_cell_x = col;
-                game->hovered_cell_y = row;
-                return true;
-            }
-        }
+    if (tictactoe_board_hit_test(board_x, board_y, global_cursor->screen_x, global_cursor->screen_y, &col, &row)) {
+        game->hovered_cell_x = col;
+        game->hovered_cell_y = row;
+        return true;
     }
     
     return false;
@@ -542,6 +612,12 @@ bool tictactoe_is_draw(const void* state) {
 const char* tictactoe_get_status_text(const void* state) {
     const TicTacToeGameState* game = (const TicTacToeGameState*)state;
     
+    int key = (game->game_active ? 1 : 0) | ((int)game->winner << 1) | ((int)game->current_player << 3);
+    if (key == status_buffer_key) {
+        return status_buffer;
+    }
+    status_buffer_key = key;
+    
     if (!game->game_active) {
         if (game->winner != TICTACTOE_CELL_EMPTY) {
             snprintf(status_buffer, sizeof(status_buffer), "Player %c wins!", 
@@ -561,9 +637,9 @@ const char* tictactoe_get_winner_text(const void* state) {
     const TicTacToeGameState* game = (const TicTacToeGameState*)state;
     
     if (game->winner != TICTACTOE_CELL_EMPTY) {
-        snprintf(status_buffer, sizeof(status_buffer), "Player %c", 
+        snprintf(winner_buffer, sizeof(winner_buffer), "Player %c", 
                 (game->winner == TICTACTOE_CELL_X) ? 'X' : 'O');
-        return status_buffer;
+        return winner_buffer;
     } else if (game->is_draw) {
         return "Draw";
     }
@@ -599,6 +675,7 @@ static const GameInterface tictactoe_interface = {
     .init_game = tictactoe_init,
     .reset_game = tictactoe_reset,
     .update_game = tictactoe_update,
+    .next_update = tictactoe_next_update,
     .is_game_active = tictactoe_is_active,
     .is_game_over = tictactoe_is_over,
     .handle_input = tictactoe_handle_input,
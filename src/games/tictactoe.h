@@ -2,6 +2,7 @@
 #define TICTACTOE_H
 
 #include "../games/game_interface.h"
+#include "../sprite.h"
 #include <stdbool.h>
 
 // TicTacToe cell states
@@ -58,6 +59,16 @@ typedef struct {
     bool is_draw;
 } TicTacToeGameState;
 
+// Board geometry shared by rendering, layout and hit-testing
+#define TICTACTOE_BOARD_TOP 8
+#define TICTACTOE_BOARD_WIDTH 13
+#define TICTACTOE_BOARD_HEIGHT 7
+
+void tictactoe_get_board_origin(int screen_width, int* board_x, int* board_y);
+void tictactoe_get_cell_center(int board_x, int board_y, int col, int row, int* x, int* y);
+bool tictactoe_board_hit_test(int board_x, int board_y, int x, int y, int* col, int* row);
+const Sprite* tictactoe_get_board_frame(void);
+
 // Core game logic functions (internal)
 void tictactoe_init_game_state(TicTacToeGameState* game);
 void tictactoe_reset_board(TicTacToeGameState* game);
@@ -79,10 +90,18 @@ void tictactoe_init_ai_state(TicTacToeAIState* ai_state);
 void tictactoe_trigger_ai_move(TicTacToeGameState* game);
 void tictactoe_process_ai_turn(TicTacToeGameState* game);
 
+// True when tictactoe_update has work to do (an AI turn is due or running).
+// Inline so batched loops can skip idle sessions without a call.
+static inline bool tictactoe_needs_update(const TicTacToeGameState* game) {
+    return game->game_mode == TICTACTOE_MODE_SINGLE_PLAYER &&
+           (game->ai_thinking || (game->current_player == game->ai_player && game->game_active));
+}
+
 // GameInterface implementation functions
 void tictactoe_init(void* state);
 void tictactoe_reset(void* state);
 void tictactoe_update(void* state, double delta_time);
+GameUpdateSchedule tictactoe_next_update(const void* state, double now);
 bool tictactoe_is_active(const void* state);
 bool tictactoe_is_over(const void* state);
 bool tictactoe_handle_input(void* state, const struct tb_event* event, const void* cursor);
@@ -0,0 +1,24 @@
+#ifndef TICTACTOE_DISPATCH_H
+#define TICTACTOE_DISPATCH_H
+
+#include "../game_dispatch.h"
+#include "tictactoe.h"
+
+// TicTacToe for StaticGame. Idle sessions (waiting on the human) are
+// filtered inline; only due AI turns call into tictactoe.c.
+struct TicTacToeStatic : StaticGame<TicTacToeStatic> {
+    typedef TicTacToeGameState State;
+    static const GameType type = GAME_TYPE_TICTACTOE;
+
+    static void update(State* game, double delta_time) {
+        if (tictactoe_needs_update(game)) {
+            tictactoe_update(game, delta_time);
+        }
+    }
+
+    static double next_update(const State* game, double now) {
+        return tictactoe_needs_update(game) ? now : -1.0;
+    }
+};
+
+#endif
@@ -0,0 +1,312 @@
+#include "headless.h"
+#include "game.h"
+#include "menu.h"
+#include "render.h"
+#include "render_target.h"
+#include "session_table.h"
+#include "timing.h"
+#include "games/tictactoe.h"
+#include "games/tictactoe_dispatch.h"
+#include <stdlib.h>
+
+// Simulated frame length for session updates
+#define FRAME_DELTA_SECONDS (1.0 / 60.0)
+
+// Idle updates are cheap, so the dispatch benchmark runs more of them
+#define IDLE_FRAME_MULTIPLIER 20
+
+typedef struct {
+    const char* name;
+    void (*setup)(ApplicationState* app);
+} HeadlessScreen;
+
+static void setup_main_menu(ApplicationState* app) {
+    app->current_state = STATE_MAIN_MENU;
+}
+
+static void setup_mode_selection(ApplicationState* app) {
+    app->current_state = STATE_MODE_SELECTION;
+}
+
+static void setup_difficulty_selection(ApplicationState* app) {
+    app->current_state = STATE_DIFFICULTY_SELECTION;
+}
+
+static void setup_playing(ApplicationState* app) {
+    app->game_mode = MODE_SINGLE_PLAYER;
+    app->ai_difficulty = DIFFICULTY_HARD;
+    start_single_player_game(app);
+    make_move(&app->game, 0, 0);
+    make_move(&app->game, 1, 1);
+}
+
+static void setup_game_over(ApplicationState* app) {
+    setup_playing(app);
+    make_move(&app->game, 1, 0);
+    make_move(&app->game, 2, 2);
+    make_move(&app->game, 2, 0);
+    app->winner = check_winner(&app->game);
+    app->is_draw = (app->winner == CELL_EMPTY);
+    app->current_state = STATE_GAME_OVER;
+}
+
+static const HeadlessScreen headless_screens[] = {
+    { "main_menu", setup_main_menu },
+    { "mode_selection", setup_mode_selection },
+    { "difficulty_selection", setup_difficulty_selection },
+    { "playing", setup_playing },
+    { "game_over", setup_game_over }
+};
+
+#define HEADLESS_SCREEN_COUNT (int)(sizeof(headless_screens) / sizeof(headless_screens[0]))
+
+// Fresh application on the given screen, cursor on its first widget
+static void prepare_screen(ApplicationState* app, const HeadlessScreen* screen) {
+    init_application_state(app);
+    screen->setup(app);
+    move_cursor_to_next_widget(app, 1);
+    update_hover_state(app);
+}
+
+bool parse_screen_size(const char* text, int* width, int* height) {
+    char* end = NULL;
+    long w = strtol(text, &end, 10);
+    if (!end || (*end != 'x' && *end != 'X')) {
+        return false;
+    }
+
+    long h = strtol(end + 1, &end, 10);
+    if (!end || *end != '\0' || w <= 0 || h <= 0 || w > 10000 || h > 10000) {
+        return false;
+    }
+
+    *width = (int)w;
+    *height = (int)h;
+    return true;
+}
+
+int run_render_benchmark(int width, int height, int frames) {
+    MemoryFramebuffer framebuffer;
+    if (!init_memory_framebuffer(&framebuffer, width, height)) {
+        fprintf(stderr, "Failed to allocate %dx%d framebuffer\n", width, height);
+        return 1;
+    }
+
+    RenderTarget target;
+    make_memory_render_target(&target, &framebuffer);
+    bind_render_target(&target);
+
+    printf("Render benchmark: %dx%d, %d frames per screen\n", width, height, frames);
+
+    ApplicationState app;
+    for (int i = 0; i < HEADLESS_SCREEN_COUNT; i++) {
+        prepare_screen(&app, &headless_screens[i]);
+
+        double start = get_monotonic_time();
+        for (int frame = 0; frame < frames; frame++) {
+            render_application(&app);
+            present_screen();
+        }
+        double elapsed = get_monotonic_time() - start;
+
+        double us_per_frame = elapsed * 1e6 / frames;
+        printf("  %-22s %10.2f us/frame %12.0f frames/s\n",
+               headless_screens[i].name, us_per_frame, frames / elapsed);
+
+        cleanup_application_state(&app);
+    }
+
+    bind_render_target(NULL);
+    cleanup_memory_framebuffer(&framebuffer);
+    return 0;
+}
+
+int run_frame_capture(int width, int height, FILE* out) {
+    MemoryFramebuffer framebuffer;
+    if (!init_memory_framebuffer(&framebuffer, width, height)) {
+        fprintf(stderr, "Failed to allocate %dx%d framebuffer\n", width, height);
+        return 1;
+    }
+
+    RenderTarget target;
+    make_memory_render_target(&target, &framebuffer);
+    bind_render_target(&target);
+
+    ApplicationState app;
+    for (int i = 0; i < HEADLESS_SCREEN_COUNT; i++) {
+        prepare_screen(&app, &headless_screens[i]);
+        render_application(&app);
+        present_screen();
+
+        fprintf(out, "=== %s ===\n", headless_screens[i].name);
+        write_framebuffer_text(&framebuffer, out);
+
+        cleanup_application_state(&app);
+    }
+
+    bind_render_target(NULL);
+    cleanup_memory_framebuffer(&framebuffer);
+    return 0;
+}
+
+// Plays the human side of a benchmark session: a pseudo-random empty cell
+static void play_bot_move(TicTacToeGameState* game, unsigned int* seed) {
+    int moves[18];
+    int move_count;
+    tictactoe_get_available_moves(game, moves, &move_count);
+    if (move_count == 0) return;
+
+    int choice = (int)(rand_r(seed) % (unsigned int)move_count);
+    tictactoe_make_move(game, moves[choice * 2], moves[choice * 2 + 1]);
+}
+
+typedef void (*SessionUpdateFunction)(SessionTable* table, double delta_time);
+
+static bool create_benchmark_sessions(SessionTable* table, SessionHandle* handles, int session_count) {
+    for (int i = 0; i < session_count; i++) {
+        handles[i] = create_session(table, GAME_TYPE_TICTACTOE);
+        TicTacToeGameState* game = (TicTacToeGameState*)get_session_state(table, handles[i]);
+        if (!game) {
+            fprintf(stderr, "Failed to create session %d\n", i);
+            return false;
+        }
+        tictactoe_setup_single_player_game(game, TICTACTOE_DIFFICULTY_HARD);
+    }
+    return true;
+}
+
+// Plays every session against the bot; returns seconds spent in update
+static double play_session_frames(SessionTable* table, const SessionHandle* handles, int session_count,
+                                  int frames, SessionUpdateFunction update, long* games_finished) {
+    unsigned int seed = 12345;
+    double update_time = 0.0;
+
+    for (int frame = 0; frame < frames; frame++) {
+        // Bots answer on the human side; finished games start over
+        for (int i = 0; i < session_count; i++) {
+            TicTacToeGameState* game = (TicTacToeGameState*)get_session_state(table, handles[i]);
+            if (!game->game_active) {
+                (*games_finished)++;
+                tictactoe_reset_board(game);
+                wake_session(table, handles[i]);
+            } else if (game->current_player == game->human_player) {
+                play_bot_move(game, &seed);
+                wake_session(table, handles[i]);
+            }
+        }
+
+        // AI replies for every session in one batched update
+        double start = get_monotonic_time();
+        update(table, FRAME_DELTA_SECONDS);
+        update_time += get_monotonic_time() - start;
+    }
+
+    return update_time;
+}
+
+// Every session waits on its human. Waking them all each frame forces the
+// scan, so the dispatch itself is what gets timed.
+static double time_idle_updates(SessionTable* table, const SessionHandle* handles, int session_count,
+                                int frames, SessionUpdateFunction update) {
+    for (int i = 0; i < session_count; i++) {
+        tictactoe_reset_board((TicTacToeGameState*)get_session_state(table, handles[i]));
+    }
+
+    double elapsed = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        wake_all_sessions(table);
+        double start = get_monotonic_time();
+        update(table, FRAME_DELTA_SECONDS);
+        elapsed += get_monotonic_time() - start;
+    }
+    return elapsed;
+}
+
+int run_session_benchmark(int session_count, int worker_count, int frames) {
+    SessionTable table;
+    if (!init_session_table(&table, worker_count)) {
+        fprintf(stderr, "Failed to start %d session workers\n", worker_count);
+        return 1;
+    }
+
+    SessionHandle* handles = (SessionHandle*)malloc(sizeof(SessionHandle) * session_count);
+    if (!handles || !create_benchmark_sessions(&table, handles, session_count)) {
+        free(handles);
+        cleanup_session_table(&table);
+        return 1;
+    }
+
+    printf("Session benchmark: %d sessions, %d worker threads, %d frames\n",
+           get_active_session_count(&table), worker_count, frames);
+
+    long games_finished = 0;
+    double update_time = play_session_frames(&table, handles, session_count, frames,
+                                             update_all_sessions, &games_finished);
+
+    printf("  %10.3f ms per batched update\n", update_time * 1e3 / frames);
+    printf("  %10.0f session updates/s\n", (double)session_count * frames / update_time);
+    printf("  %10ld games finished\n", games_finished);
+
+    // Once every session waits on its human, updates skip the table
+    time_idle_updates(&table, handles, session_count, 1, update_all_sessions);
+    double idle_start = get_monotonic_time();
+    for (int frame = 0; frame < frames; frame++) {
+        update_all_sessions(&table, FRAME_DELTA_SECONDS);
+    }
+    printf("  %10.3f us per update with every session idle\n",
+           (get_monotonic_time() - idle_start) * 1e6 / frames);
+
+    free(handles);
+    cleanup_session_table(&table);
+    return 0;
+}
+
+int run_dispatch_benchmark(int session_count, int worker_count, int frames) {
+    SessionTable table;
+    if (!init_session_table(&table, worker_count)) {
+        fprintf(stderr, "Failed to start %d session workers\n", worker_count);
+        return 1;
+    }
+
+    SessionHandle* handles = (SessionHandle*)malloc(sizeof(SessionHandle) * session_count);
+    if (!handles || !create_benchmark_sessions(&table, handles, session_count)) {
+        free(handles);
+        cleanup_session_table(&table);
+        return 1;
+    }
+
+    printf("Dispatch benchmark: %d sessions, %d worker threads, %d frames\n",
+           get_active_session_count(&table), worker_count, frames);
+
+    int idle_frames = frames * IDLE_FRAME_MULTIPLIER;
+    double updates = (double)session_count * idle_frames;
+    double idle_interface = time_idle_updates(&table, handles, session_count, idle_frames, update_all_sessions);
+    double idle_static = time_idle_updates(&table, handles, session_count, idle_frames,
+                                           TicTacToeStatic::update_sessions);
+    printf("  idle     interface %8.2f ns/session   static %8.2f ns/session   %5.2fx\n",
+           idle_interface * 1e9 / updates, idle_static * 1e9 / updates, idle_interface / idle_static);
+
+    // Same bot seed for both runs, so both see the same games
+    long finished_interface = 0;
+    long finished_static = 0;
+    time_idle_updates(&table, handles, session_count, 0, update_all_sessions);
+    double play_interface = play_session_frames(&table, handles, session_count, frames,
+                                                update_all_sessions, &finished_interface);
+    time_idle_updates(&table, handles, session_count, 0, update_all_sessions);
+    double play_static = play_session_frames(&table, handles, session_count, frames,
+                                             TicTacToeStatic::update_sessions, &finished_static);
+    printf("  playing  interface %8.3f ms/update    static %8.3f ms/update    %5.2fx\n",
+           play_interface * 1e3 / frames, play_static * 1e3 / frames, play_interface / play_static);
+
+    if (finished_interface != finished_static) {
+        fprintf(stderr, "Dispatch paths disagree: %ld vs %ld games finished\n",
+                finished_interface, finished_static);
+        free(handles);
+        cleanup_session_table(&table);
+        return 1;
+    }
+
+    free(handles);
+    cleanup_session_table(&table);
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Parses "WIDTHxHEIGHT" (e.g. "1000x300")
+bool parse_screen_size(const char* text, int* width, int* height);
+
+// Renders every application screen into an in-memory framebuffer and
+// reports the cost per frame; no terminal required
+int run_render_benchmark(int width, int height, int frames);
+
+// Runs many single-player sessions against a bot through the session table
+// and reports the cost of each batched update
+int run_session_benchmark(int session_count, int worker_count, int frames);
+
+// Compares GameInterface dispatch with StaticGame dispatch on the same
+// session table, idle and while playing
+int run_dispatch_benchmark(int session_count, int worker_count, int frames);
+
+// Writes each application screen as plain text, for golden frames and tools
+int run_frame_capture(int width, int height, FILE* out);
+
+#endif
@@ -0,0 +1,156 @@
+#include "hints.h"
+#include <string.h>
+
+// 3^9 boards, each with either side to move
+#define HINT_BOARDS 19683
+#define HINT_UNSOLVED INT8_MAX
+
+static int8_t solved_values[HINT_BOARDS * 2];
+static bool solved_ready = false;
+
+static const int power_of_three[9] = {1, 3, 9, 27, 81, 243, 729, 2187, 6561};
+
+static const uint8_t winning_lines[8][3] = {
+    {0, 1, 2}, {3, 4, 5}, {6, 7, 8},
+    {0, 3, 6}, {1, 4, 7}, {2, 5, 8},
+    {0, 4, 8}, {2, 4, 6}
+};
+
+bool has_winning_line(const uint8_t cells[9], int player) {
+    for (int i = 0; i < 8; i++) {
+        const uint8_t* line = winning_lines[i];
+        if (cells[line[0]] == player && cells[line[1]] == player && cells[line[2]] == player) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A child's value seen from its parent, one ply further from the result
+static int8_t to_parent_value(int8_t child) {
+    if (child > 0) return (int8_t)(-(child - 1));
+    if (child < 0) return (int8_t)(-child - 1);
+    return 0;
+}
+
+// Negamax over the whole remaining game; board is the base-3 index of cells
+static int8_t solve_position(uint8_t cells[9], int board, int to_move) {
+    int key = board * 2 + (to_move - 1);
+    if (solved_values[key] != HINT_UNSOLVED) {
+        return solved_values[key];
+    }
+
+    int8_t best;
+    int opponent = 3 - to_move;
+    if (has_winning_line(cells, opponent)) {
+        best = -HINT_WIN;
+    } else {
+        best = HINT_NONE;
+        for (int cell = 0; cell < 9; cell++) {
+            if (cells[cell] != 0) continue;
+
+            cells[cell] = (uint8_t)to_move;
+            int8_t value = to_parent_value(solve_position(cells, board + to_move * power_of_three[cell], opponent));
+            cells[cell] = 0;
+
+            if (value > best) best = value;
+        }
+        if (best == HINT_NONE) best = 0;   // Full board, nobody won
+    }
+
+    solved_values[key] = best;
+    return best;
+}
+
+static int get_board_index(const uint8_t cells[9]) {
+    int board = 0;
+    for (int cell = 0; cell < 9; cell++) {
+        board += cells[cell] * power_of_three[cell];
+    }
+    return board;
+}
+
+static void prepare_solved_values(void) {
+    if (!solved_ready) {
+        memset(solved_values, HINT_UNSOLVED, sizeof(solved_values));
+        solved_ready = true;
+    }
+}
+
+void init_move_hints(MoveHints* hints) {
+    hints->visible = false;
+    hints->position_key = -1;
+    memset(hints->values, (uint8_t)HINT_NONE, sizeof(hints->values));
+}
+
+void toggle_move_hints(MoveHints* hints) {
+    hints->visible = !hints->visible;
+}
+
+void update_move_hints(MoveHints* hints, const uint8_t cells[9], int to_move) {
+    int board = get_board_index(cells);
+    int key = board * 2 + (to_move - 1);
+    if (key == hints->position_key) return;
+
+    prepare_solved_values();
+
+    uint8_t scratch[9];
+    memcpy(scratch, cells, sizeof(scratch));
+    bool over = has_winning_line(cells, 1) || has_winning_line(cells, 2);
+
+    for (int cell = 0; cell < 9; cell++) {
+        if (cells[cell] != 0 || over) {
+            hints->values[cell] = HINT_NONE;
+            continue;
+        }
+
+        scratch[cell] = (uint8_t)to_move;
+        hints->values[cell] = to_parent_value(solve_position(scratch, board + to_move * power_of_three[cell], 3 - to_move));
+        scratch[cell] = 0;
+    }
+
+    hints->position_key = key;
+}
+
+void solve_all_hint_positions(void) {
+    prepare_solved_values();
+
+    uint8_t cells[9] = {0};
+    solve_position(cells, 0, 1);
+    solve_position(cells, 0, 2);
+}
+
+int get_best_hint_move(const uint8_t cells[9], int to_move, int8_t* value) {
+    int opponent = 3 - to_move;
+    *value = has_winning_line(cells, opponent) ? -HINT_WIN : 0;
+    if (*value != 0) return -1;
+
+    // Children only, so the cache is never written
+    int board = get_board_index(cells);
+    int best_move = -1;
+    for (int cell = 0; cell < 9; cell++) {
+        if (cells[cell] != 0) continue;
+
+        int child_key = (board + to_move * power_of_three[cell]) * 2 + (opponent - 1);
+        int8_t child_value = solved_values[child_key];
+        if (child_value == HINT_UNSOLVED) continue;
+
+        int8_t cell_value = to_parent_value(child_value);
+        if (best_move < 0 || cell_value > *value) {
+            best_move = cell;
+            *value = cell_value;
+        }
+    }
+    return best_move;
+}
+
+HintOutcome get_hint_outcome(int8_t value) {
+    if (value > 0) return HINT_OUTCOME_WIN;
+    if (value < 0) return HINT_OUTCOME_LOSS;
+    return HINT_OUTCOME_DRAW;
+}
+
+// Plies until a win or loss; 0 for a draw, which lasts until the board fills
+int get_hint_distance(int8_t value) {
+    return (value > 0) ? HINT_WIN - value : (value < 0) ? HINT_WIN + value : 0;
+}
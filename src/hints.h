@@ -0,0 +1,49 @@
+#ifndef HINTS_H
+#define HINTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Solved values count plies to the result: HINT_WIN - n is a win in n
+// plies for the side to move, -(HINT_WIN - n) a loss in n, 0 a draw
+#define HINT_WIN 16
+#define HINT_NONE INT8_MIN   // Occupied cell, or no position yet
+
+typedef enum {
+    HINT_OUTCOME_LOSS,
+    HINT_OUTCOME_DRAW,
+    HINT_OUTCOME_WIN
+} HintOutcome;
+
+// Per-cell values of the position on the board, for the player to move.
+// Refreshed only when the position changes; rendering just reads them.
+typedef struct {
+    bool visible;
+    int position_key;        // Position the values belong to, -1 for none
+    int8_t values[9];        // Row-major; HINT_NONE for taken cells
+} MoveHints;
+
+void init_move_hints(MoveHints* hints);
+void toggle_move_hints(MoveHints* hints);
+
+// cells holds 0 (empty), 1 (X) or 2 (O) row-major; to_move is 1 or 2.
+// Every position ever solved is cached, so after the first call a move
+// costs only the positions it newly reaches.
+void update_move_hints(MoveHints* hints, const uint8_t cells[9], int to_move);
+
+bool has_winning_line(const uint8_t cells[9], int player);
+
+// Solves every position reachable from the empty board with either side
+// starting. Afterwards get_best_hint_move only reads the cache, so any
+// number of threads may call it at once.
+void solve_all_hint_positions(void);
+
+// Best cell for to_move in a legal position that solve_all_hint_positions
+// covered, and its value in *value. Returns -1 when the game is already
+// over: *value is then -HINT_WIN if the opponent has a line, 0 otherwise.
+int get_best_hint_move(const uint8_t cells[9], int to_move, int8_t* value);
+
+HintOutcome get_hint_outcome(int8_t value);
+int get_hint_distance(int8_t value);
+
+#endif
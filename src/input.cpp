@@ -0,0 +1,453 @@
+#include "input.h"
+#include "menu.h"
+#include "netplay.h"
+#include "perf_hud.h"
+#include "timing.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Keymap active_keymap;
+static bool keymap_ready = false;
+
+static const char* const action_names[ACTION_COUNT] = {
+    "none",
+    "cursor_up",
+    "cursor_down",
+    "cursor_left",
+    "cursor_right",
+    "next_widget",
+    "previous_widget",
+    "toggle_perf_hud",
+    "toggle_hints",
+    "click",
+    "new_game",
+    "continue",
+    "more_games",
+    "quit",
+    "main_menu",
+    "back",
+    "restart",
+    "undo",
+    "redo",
+    "two_player",
+    "single_player",
+    "easy",
+    "medium",
+    "hard",
+    "select_game",
+    "game_1",
+    "game_2",
+    "game_3"
+};
+
+// Screen names for the keymap file, indexed by AppState
+static const char* const screen_names[KEYMAP_STATES] = {
+    "menu",
+    "game_selection",
+    "mode_selection",
+    "difficulty",
+    "playing",
+    "game_over",
+    "quit"
+};
+
+typedef struct {
+    const char* name;
+    uint16_t key;
+} NamedKey;
+
+static const NamedKey named_keys[] = {
+    {"up", TB_KEY_ARROW_UP},
+    {"down", TB_KEY_ARROW_DOWN},
+    {"left", TB_KEY_ARROW_LEFT},
+    {"right", TB_KEY_ARROW_RIGHT},
+    {"enter", TB_KEY_ENTER},
+    {"tab", TB_KEY_TAB},
+    {"backtab", TB_KEY_BACK_TAB},
+    {"esc", TB_KEY_ESC},
+    {"backspace", TB_KEY_BACKSPACE2},
+    {"delete", TB_KEY_DELETE},
+    {"home", TB_KEY_HOME},
+    {"end", TB_KEY_END},
+    {"pgup", TB_KEY_PGUP},
+    {"pgdn", TB_KEY_PGDN},
+    {"f1", TB_KEY_F1},
+    {"f2", TB_KEY_F2},
+    {"f3", TB_KEY_F3},
+    {"f4", TB_KEY_F4},
+    {"f5", TB_KEY_F5},
+    {"f6", TB_KEY_F6},
+    {"f7", TB_KEY_F7},
+    {"f8", TB_KEY_F8},
+    {"f9", TB_KEY_F9},
+    {"f10", TB_KEY_F10},
+    {"f11", TB_KEY_F11},
+    {"f12", TB_KEY_F12}
+};
+
+// Key codes
+static int get_char_code(uint32_t ch) {
+    return ch < KEYMAP_CHAR_CODES ? (int)ch : -1;
+}
+
+static int get_special_key_code(uint16_t key) {
+    if (key < KEYMAP_CONTROL_CODES) {
+        return KEYMAP_CHAR_CODES + key;
+    }
+    int special = 0xffff - key;
+    return special < KEYMAP_SPECIAL_CODES ? KEYMAP_CHAR_CODES + KEYMAP_CONTROL_CODES + special : -1;
+}
+
+static int get_event_key_code(const struct tb_event* event) {
+    if (event->type != TB_EVENT_KEY) return -1;
+    return event->ch ? get_char_code(event->ch) : get_special_key_code(event->key);
+}
+
+// Letters are bound in both cases
+static void bind_char(uint8_t* table, char ch, InputAction action) {
+    table[get_char_code((unsigned char)ch)] = (uint8_t)action;
+    if (ch >= 'a' && ch <= 'z') {
+        table[get_char_code((unsigned char)(ch - 'a' + 'A'))] = (uint8_t)action;
+    }
+}
+
+static void bind_key(uint8_t* table, uint16_t key, InputAction action) {
+    table[get_special_key_code(key)] = (uint8_t)action;
+}
+
+void init_default_keymap(Keymap* keymap) {
+    memset(keymap, ACTION_NONE, sizeof(*keymap));
+
+    uint8_t* global = keymap->global;
+    bind_key(global, TB_KEY_ARROW_UP, ACTION_CURSOR_UP);
+    bind_key(global, TB_KEY_ARROW_DOWN, ACTION_CURSOR_DOWN);
+    bind_key(global, TB_KEY_ARROW_LEFT, ACTION_CURSOR_LEFT);
+    bind_key(global, TB_KEY_ARROW_RIGHT, ACTION_CURSOR_RIGHT);
+    bind_char(global, 'w', ACTION_CURSOR_UP);
+    bind_char(global, 's', ACTION_CURSOR_DOWN);
+    bind_char(global, 'a', ACTION_CURSOR_LEFT);
+    bind_char(global, 'd', ACTION_CURSOR_RIGHT);
+    bind_key(global, TB_KEY_TAB, ACTION_NEXT_WIDGET);
+    bind_key(global, TB_KEY_BACK_TAB, ACTION_PREVIOUS_WIDGET);
+    bind_key(global, TB_KEY_F2, ACTION_TOGGLE_PERF_HUD);
+
+    // Enter clicks whatever the cursor is over
+    for (int state = 0; state < KEYMAP_STATES; state++) {
+        if (state == STATE_QUIT) continue;
+        bind_key(keymap->screens[state], TB_KEY_ENTER, ACTION_CLICK);
+        bind_char(keymap->screens[state], '\n', ACTION_CLICK);
+        bind_char(keymap->screens[state], 'q', ACTION_QUIT);
+    }
+
+    uint8_t* menu = keymap->screens[STATE_MAIN_MENU];
+    bind_char(menu, 'n', ACTION_NEW_GAME);
+    bind_char(menu, 'c', ACTION_CONTINUE);
+    bind_char(menu, 'g', ACTION_MORE_GAMES);
+
+    uint8_t* games = keymap->screens[STATE_GAME_SELECTION];
+    bind_key(games, TB_KEY_ESC, ACTION_MAIN_MENU);
+    bind_char(games, '1', ACTION_GAME_1);
+    bind_char(games, '2', ACTION_GAME_2);
+    bind_char(games, '3', ACTION_GAME_3);
+    bind_char(games, 'b', ACTION_MAIN_MENU);
+
+    uint8_t* modes = keymap->screens[STATE_MODE_SELECTION];
+    bind_char(modes, '1', ACTION_TWO_PLAYER);
+    bind_char(modes, '2', ACTION_SINGLE_PLAYER);
+    bind_char(modes, 'b', ACTION_BACK);
+
+    uint8_t* difficulty = keymap->screens[STATE_DIFFICULTY_SELECTION];
+    bind_char(difficulty, '1', ACTION_EASY);
+    bind_char(difficulty, '2', ACTION_MEDIUM);
+    bind_char(difficulty, '3', ACTION_HARD);
+    bind_char(difficulty, 'b', ACTION_BACK);
+
+    uint8_t* playing = keymap->screens[STATE_PLAYING];
+    bind_char(playing, 'r', ACTION_RESTART);
+    bind_char(playing, 'u', ACTION_UNDO);
+    bind_char(playing, 'y', ACTION_REDO);
+    bind_char(playing, 'm', ACTION_MAIN_MENU);
+    bind_char(playing, 'h', ACTION_TOGGLE_HINTS);
+
+    uint8_t* game_over = keymap->screens[STATE_GAME_OVER];
+    bind_char(game_over, 'r', ACTION_RESTART);
+    bind_char(game_over, 'u', ACTION_UNDO);
+    bind_char(game_over, 'm', ACTION_MAIN_MENU);
+}
+
+static const Keymap* get_keymap(void) {
+    if (!keymap_ready) {
+        init_default_keymap(&active_keymap);
+        keymap_ready = true;
+    }
+    return &active_keymap;
+}
+
+// Keymap file
+static int parse_key_name(const char* name) {
+    if (strlen(name) == 1 && name[0] > ' ' && name[0] < 0x7f) {
+        return get_char_code((unsigned char)name[0]);
+    }
+    if (strcmp(name, "space") == 0) {
+        return get_char_code(' ');
+    }
+    for (size_t i = 0; i < sizeof(named_keys) / sizeof(named_keys[0]); i++) {
+        if (strcmp(name, named_keys[i].name) == 0) {
+            return get_special_key_code(named_keys[i].key);
+        }
+    }
+    return -1;
+}
+
+static int parse_action_name(const char* name) {
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        if (strcmp(name, action_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static uint8_t* parse_screen_name(Keymap* keymap, const char* name) {
+    if (strcmp(name, "all") == 0) return keymap->global;
+    for (int i = 0; i < STATE_QUIT; i++) {
+        if (strcmp(name, screen_names[i]) == 0) return keymap->screens[i];
+    }
+    return NULL;
+}
+
+static bool get_keymap_path(char* buffer, size_t size) {
+    const char* from_env = getenv(KEYMAP_FILE_ENV);
+    const char* home = getenv("HOME");
+    int written;
+
+    if (from_env && *from_env) {
+        written = snprintf(buffer, size, "%s", from_env);
+    } else if (home && *home) {
+        written = snprintf(buffer, size, "%s/.config/tictactoe/keys.conf", home);
+    } else {
+        return false;
+    }
+    return written > 0 && (size_t)written < size;
+}
+
+void load_keymap(void) {
+    Keymap* keymap = &active_keymap;
+    init_default_keymap(keymap);
+    keymap_ready = true;
+
+    char path[PATH_MAX];
+    if (!get_keymap_path(path, sizeof(path))) return;
+
+    FILE* file = fopen(path, "r");
+    if (!file) return;
+
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char screen[64], key[64], action[64], extra[2];
+        int fields = sscanf(line, "%63s %63s %63s %1s", screen, key, action, extra);
+        if (fields <= 0) continue;
+
+        uint8_t* table = (fields == 3) ? parse_screen_name(keymap, screen) : NULL;
+        int code = (fields == 3) ? parse_key_name(key) : -1;
+        int bound_action = (fields == 3) ? parse_action_name(action) : -1;
+        if (!table || code < 0 || bound_action < 0) {
+            fprintf(stderr, "%s:%d: expected SCREEN KEY ACTION, ignoring this line\n", path, line_number);
+            continue;
+        }
+
+        // A key moved to a screen table must not stay shadowed globally;
+        // the other screens keep its global action unless they bind it
+        if (table != keymap->global && keymap->global[code] != ACTION_NONE) {
+            for (int i = 0; i < KEYMAP_STATES; i++) {
+                if (keymap->screens[i] != table && keymap->screens[i][code] == ACTION_NONE) {
+                    keymap->screens[i][code] = keymap->global[code];
+                }
+            }
+            keymap->global[code] = ACTION_NONE;
+        }
+        table[code] = (uint8_t)bound_action;
+    }
+    fclose(file);
+}
+
+static bool get_action_delta(InputAction action, int* dx, int* dy) {
+    *dx = 0;
+    *dy = 0;
+    switch (action) {
+        case ACTION_CURSOR_UP:    *dy = -1; return true;
+        case ACTION_CURSOR_DOWN:  *dy = 1;  return true;
+        case ACTION_CURSOR_LEFT:  *dx = -1; return true;
+        case ACTION_CURSOR_RIGHT: *dx = 1;  return true;
+        default:                  return false;
+    }
+}
+
+bool is_movement_key(const struct tb_event* event, int* dx, int* dy) {
+    int code = get_event_key_code(event);
+    InputAction action = code >= 0 ? (InputAction)get_keymap()->global[code] : ACTION_NONE;
+    return get_action_delta(action, dx, dy);
+}
+
+// Cursor acceleration
+int accelerate_cursor_moves(GlobalCursor* cursor, int dx, int dy, int count, double now) {
+    bool held = cursor->move_streak > 0 && dx == cursor->last_move_dx && dy == cursor->last_move_dy &&
+                now - cursor->last_move_time <= CURSOR_REPEAT_WINDOW;
+    int streak = held ? cursor->move_streak : 0;
+
+    int cells = 0;
+    for (int i = 0; i < count; i++, streak++) {
+        int doublings = streak / CURSOR_ACCELERATION_REPEATS;
+        cells += (doublings >= 16 || (1 << doublings) > CURSOR_MAX_STEP) ? CURSOR_MAX_STEP : (1 << doublings);
+    }
+
+    cursor->move_streak = streak;
+    cursor->last_move_dx = dx;
+    cursor->last_move_dy = dy;
+    cursor->last_move_time = now;
+    return cells;
+}
+
+// Actions
+static void restart_game(ApplicationState* app) {
+    if (has_active_game_session(app)) {
+        reset_current_game(&app->game_manager);
+    } else if (app->current_state == STATE_GAME_OVER) {
+        reset_board(&app->game);
+        clear_board_history(app);
+        app->game.game_active = true;
+        app->current_state = STATE_PLAYING;
+        app->winner = CELL_EMPTY;
+        app->is_draw = false;
+        app->has_active_game = true;
+        if (app->netplay) netplay_send_reset(app->netplay);
+    } else if (app->game_mode == MODE_SINGLE_PLAYER) {
+        start_single_player_game(app);
+    } else {
+        reset_board(&app->game);
+        clear_board_history(app);
+        app->game.game_active = true;
+        if (app->netplay) netplay_send_reset(app->netplay);
+    }
+}
+
+static void continue_game(ApplicationState* app) {
+    if (!app->has_active_game) return;
+
+    // A finished board goes back to its game over screen
+    if (!has_active_game_session(app) && !app->game.game_active && (app->winner != CELL_EMPTY || app->is_draw)) {
+        app->current_state = STATE_GAME_OVER;
+    } else {
+        app->current_state = STATE_PLAYING;
+    }
+}
+
+static void start_two_player_game(ApplicationState* app) {
+    app->game_mode = MODE_TWO_PLAYER;
+    reset_board(&app->game);
+    clear_board_history(app);
+    app->game.game_active = true;
+    app->current_state = STATE_PLAYING;
+    app->has_active_game = true;
+    app->winner = CELL_EMPTY;
+    app->is_draw = false;
+}
+
+static void select_game(ApplicationState* app, int game) {
+    app->game_selection = game;
+    setup_game_from_selection(app);
+}
+
+void perform_input_action(ApplicationState* app, InputAction action) {
+    int dx, dy;
+    if (get_action_delta(action, &dx, &dy)) {
+        int cells = accelerate_cursor_moves(&app->cursor, dx, dy, 1, get_monotonic_time());
+        move_global_cursor(app, dx * cells, dy * cells);
+        return;
+    }
+
+    switch (action) {
+        case ACTION_NEXT_WIDGET:      move_cursor_to_next_widget(app, 1); break;
+        case ACTION_PREVIOUS_WIDGET:  move_cursor_to_next_widget(app, -1); break;
+        case ACTION_TOGGLE_PERF_HUD:  toggle_perf_hud(&app->perf_hud); break;
+        case ACTION_TOGGLE_HINTS:     toggle_move_hints(&app->move_hints); break;
+        case ACTION_CLICK:            handle_cursor_click(app); break;
+        case ACTION_QUIT:             app->current_state = STATE_QUIT; break;
+        case ACTION_MAIN_MENU:        transition_to_main_menu(app); break;
+        case ACTION_CONTINUE:         continue_game(app); break;
+        case ACTION_MORE_GAMES:       transition_to_game_selection(app); break;
+        case ACTION_NEW_GAME:         open_board_game_setup(app); break;
+        case ACTION_RESTART:          restart_game(app); break;
+        case ACTION_TWO_PLAYER:       start_two_player_game(app); break;
+        case ACTION_SELECT_GAME:      setup_game_from_selection(app); break;
+        case ACTION_GAME_1:           select_game(app, 0); break;
+        case ACTION_GAME_2:           select_game(app, 1); break;
+        case ACTION_GAME_3:           select_game(app, 2); break;
+
+        case ACTION_BACK:
+            if (app->current_state == STATE_DIFFICULTY_SELECTION) {
+                app->current_state = STATE_MODE_SELECTION;
+                app->mode_selection = 0;
+            } else {
+                transition_to_main_menu(app);
+            }
+            break;
+
+        case ACTION_UNDO:
+            if (has_active_game_session(app)) undo_current_game_move(&app->game_manager);
+            else undo_board_move(app);
+            break;
+
+        case ACTION_REDO:
+            if (has_active_game_session(app)) redo_current_game_move(&app->game_manager);
+            else redo_board_move(app);
+            break;
+
+        case ACTION_SINGLE_PLAYER:
+            app->game_mode = MODE_SINGLE_PLAYER;
+            app->current_state = STATE_DIFFICULTY_SELECTION;
+            app->difficulty_selection = 0;
+            break;
+
+        case ACTION_EASY:
+        case ACTION_MEDIUM:
+        case ACTION_HARD:
+            app->ai_difficulty = (action == ACTION_EASY) ? DIFFICULTY_EASY :
+                                 (action == ACTION_MEDIUM) ? DIFFICULTY_MEDIUM : DIFFICULTY_HARD;
+            start_single_player_game(app);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void handle_application_input(ApplicationState* app, const struct tb_event* event) {
+    // A running game from the game list sees keys before the bindings do
+    if (is_game_session_running(app) && handle_current_game_input(&app->game_manager, event, &app->cursor)) {
+        return;
+    }
+
+    int code = get_event_key_code(event);
+    if (code < 0) return;
+
+    const Keymap* keymap = get_keymap();
+    InputAction action = (InputAction)keymap->global[code];
+    if (action != ACTION_NONE) {
+        perform_input_action(app, action);
+        return;
+    }
+
+    // The board ignores the human while the AI is to move
+    if (app->current_state == STATE_PLAYING && app->game_mode == MODE_SINGLE_PLAYER &&
+        app->game.current_player == app->ai_player && app->game.game_active) {
+        return;
+    }
+
+    perform_input_action(app, (InputAction)keymap->screens[app->current_state][code]);
+}
@@ -1,28 +1,90 @@
 #ifndef INPUT_H
 #define INPUT_H
 
-#include \"game.h\"
-#include \"../lib/termbox2/termbox2.h\"
+#include "game.h"
+#include "../lib/termbox2/termbox2.h"
+#include <stdint.h>
 
-// Main input dispatcher
+// Everything a key can do. Screens interpret a few of them (restart,
+// back) in their own way; the rest mean the same everywhere.
+typedef enum {
+    ACTION_NONE,
+    ACTION_CURSOR_UP,
+    ACTION_CURSOR_DOWN,
+    ACTION_CURSOR_LEFT,
+    ACTION_CURSOR_RIGHT,
+    ACTION_NEXT_WIDGET,
+    ACTION_PREVIOUS_WIDGET,
+    ACTION_TOGGLE_PERF_HUD,
+    ACTION_TOGGLE_HINTS,
+    ACTION_CLICK,
+    ACTION_NEW_GAME,
+    ACTION_CONTINUE,
+    ACTION_MORE_GAMES,
+    ACTION_QUIT,
+    ACTION_MAIN_MENU,
+    ACTION_BACK,
+    ACTION_RESTART,
+    ACTION_UNDO,
+    ACTION_REDO,
+    ACTION_TWO_PLAYER,
+    ACTION_SINGLE_PLAYER,
+    ACTION_EASY,
+    ACTION_MEDIUM,
+    ACTION_HARD,
+    ACTION_SELECT_GAME,
+    ACTION_GAME_1,
+    ACTION_GAME_2,
+    ACTION_GAME_3,
+    ACTION_COUNT
+} InputAction;
+
+// One dense table per screen plus a global one, indexed by key code:
+// characters below 128, then control keys, then termbox's special keys
+// (counted down from 0xffff). Lookup is a single array read.
+#define KEYMAP_CHAR_CODES 128
+#define KEYMAP_CONTROL_CODES 128
+#define KEYMAP_SPECIAL_CODES 64
+#define KEYMAP_CODES (KEYMAP_CHAR_CODES + KEYMAP_CONTROL_CODES + KEYMAP_SPECIAL_CODES)
+#define KEYMAP_STATES (STATE_QUIT + 1)
+
+// $TICTACTOE_KEYMAP, else ~/.config/tictactoe/keys.conf. Lines read
+// "SCREEN KEY ACTION", e.g. "playing x restart" or "all h cursor_left";
+// ACTION "none" unbinds. Screens: all, menu, game_selection,
+// mode_selection, difficulty, playing, game_over. Keys: a printable
+// character or up, down, left, right, enter, tab, backtab, esc, space,
+// backspace, delete, home, end, pgup, pgdn, f1..f12.
+#define KEYMAP_FILE_ENV "TICTACTOE_KEYMAP"
+
+typedef struct {
+    uint8_t global[KEYMAP_CODES];
+    uint8_t screens[KEYMAP_STATES][KEYMAP_CODES];
+} Keymap;
+
+// Held cursor keys speed up: the step doubles every
+// CURSOR_ACCELERATION_REPEATS repeats, up to CURSOR_MAX_STEP cells. A key
+// counts as held while repeats arrive within CURSOR_REPEAT_WINDOW seconds.
+#define CURSOR_ACCELERATION_REPEATS 4
+#define CURSOR_MAX_STEP 32
+#define CURSOR_REPEAT_WINDOW 0.15
+
+// The built-in bindings (arrows/WASD, Enter, Tab, F2 and each screen's
+// letter and digit shortcuts)
+void init_default_keymap(Keymap* keymap);
+
+// Applies the user's keymap file over the defaults; problems are reported
+// on stderr and the offending lines skipped. Call before the terminal is
+// taken over.
+void load_keymap(void);
+
+// Cursor movement keys, with their direction
+bool is_movement_key(const struct tb_event* event, int* dx, int* dy);
+
+// Cells to move for `count` presses continuing the cursor's current streak
+int accelerate_cursor_moves(GlobalCursor* cursor, int dx, int dy, int count, double now);
+
+// Runs the key's action for the current screen
 void handle_application_input(ApplicationState* app, const struct tb_event* event);
+void perform_input_action(ApplicationState* app, InputAction action);
 
-// State-specific input handlers
-void handle_main_menu_input(ApplicationState* app, const struct tb_event* event);
-void handle_game_selection_input(ApplicationState* app, const struct tb_event* event);
-void handle_mode_selection_input(ApplicationState* app, const struct tb_event* event);
-void handle_difficulty_selection_input(ApplicationState* app, const struct tb_event* event);
-void handle_playing_input(ApplicationState* app, const struct tb_event* event);
-void handle_game_over_input(ApplicationState* app, const struct tb_event* event);
-
-// Universal input handlers
-void handle_universal_game_input(ApplicationState* app, const struct tb_event* event);
-void handle_cursor_movement(ApplicationState* app, const struct tb_event* event);
-void handle_mouse_input(ApplicationState* app, const struct tb_event* event);
-
-// Input processing utilities
-bool is_movement_key(const struct tb_event* event);
-bool is_action_key(const struct tb_event* event);
-bool is_escape_key(const struct tb_event* event);
-
-#endif
\ No newline at end of file
+#endif
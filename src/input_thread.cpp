@@ -0,0 +1,205 @@
+#include "input_thread.h"
+#include "timing.h"
+#include "trace.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Single producer (the input thread), single consumer (the main loop)
+static TimedInputEvent input_queue[INPUT_QUEUE_CAPACITY];
+static uint32_t input_queue_head = 0;   // Next write; input thread only
+static uint32_t input_queue_tail = 0;   // Next read; main thread only
+
+static pthread_mutex_t terminal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t input_thread;
+static bool input_thread_running = false;
+static bool input_failed = false;       // Reading the terminal failed; the thread has exited
+static int wake_fd = -1;                // Written after each burst of queued events
+static int stop_fd = -1;
+
+void lock_terminal(void) {
+    pthread_mutex_lock(&terminal_lock);
+}
+
+void unlock_terminal(void) {
+    pthread_mutex_unlock(&terminal_lock);
+}
+
+static void signal_fd(int fd) {
+    uint64_t one = 1;
+    ssize_t written = write(fd, &one, sizeof(one));
+    (void)written;
+}
+
+// Moves every event termbox can decode into the queue. Returns false if
+// the queue filled up first; the remaining events stay buffered in termbox.
+static bool drain_terminal(double arrival_time, int* pushed) {
+    for (;;) {
+        uint32_t head = input_queue_head;
+        uint32_t tail = __atomic_load_n(&input_queue_tail, __ATOMIC_ACQUIRE);
+        if (head - tail >= INPUT_QUEUE_CAPACITY) {
+            return false;
+        }
+
+        TimedInputEvent* slot = &input_queue[head % INPUT_QUEUE_CAPACITY];
+        int result = tb_peek_event(&slot->event, 0);
+        if (result == TB_ERR_NO_EVENT) {
+            return true;
+        }
+        if (result != TB_OK) {
+            __atomic_store_n(&input_failed, true, __ATOMIC_RELEASE);
+            return true;
+        }
+
+        slot->arrival_time = arrival_time;
+        __atomic_store_n(&input_queue_head, head + 1, __ATOMIC_RELEASE);
+        (*pushed)++;
+    }
+}
+
+static void* run_input_thread(void* arg) {
+    (void)arg;
+    TRACE_THREAD_NAME("input");
+
+    int tty_fd = -1;
+    int resize_fd = -1;
+    tb_get_fds(&tty_fd, &resize_fd);
+
+    bool backlog = false;
+    while (!__atomic_load_n(&input_failed, __ATOMIC_ACQUIRE)) {
+        // Poll ignores negative descriptors
+        struct pollfd fds[3] = {
+            { stop_fd, POLLIN, 0 },
+            { tty_fd, POLLIN, 0 },
+            { resize_fd, POLLIN, 0 }
+        };
+
+        // With a full queue, retry shortly instead of waiting on the
+        // terminal: termbox may be holding events it already read
+        int ready = poll(fds, 3, backlog ? 1 : -1);
+        if (ready < 0 && errno != EINTR) {
+            __atomic_store_n(&input_failed, true, __ATOMIC_RELEASE);
+            break;
+        }
+        if (fds[0].revents) {
+            break;
+        }
+
+        // Stamped before the lock, which the main thread may be holding
+        // for a whole frame
+        double arrival_time = get_system_monotonic_time();
+        int pushed = 0;
+        {
+            TRACE_SCOPE("decode_input");
+            lock_terminal();
+            backlog = !drain_terminal(arrival_time, &pushed);
+            unlock_terminal();
+        }
+
+        if (pushed > 0) {
+            signal_fd(wake_fd);
+        }
+    }
+
+    // Let a waiting main loop see the failure
+    signal_fd(wake_fd);
+    return NULL;
+}
+
+bool start_input_thread(void) {
+    if (input_thread_running) return true;
+
+    wake_fd = eventfd(0, EFD_NONBLOCK);
+    stop_fd = eventfd(0, EFD_NONBLOCK);
+    if (wake_fd < 0 || stop_fd < 0) {
+        stop_input_thread();
+        return false;
+    }
+
+    input_queue_head = 0;
+    input_queue_tail = 0;
+    input_failed = false;
+    if (pthread_create(&input_thread, NULL, run_input_thread, NULL) != 0) {
+        stop_input_thread();
+        return false;
+    }
+
+    input_thread_running = true;
+    return true;
+}
+
+void stop_input_thread(void) {
+    if (input_thread_running) {
+        signal_fd(stop_fd);
+        pthread_join(input_thread, NULL);
+        input_thread_running = false;
+    }
+
+    if (wake_fd >= 0) close(wake_fd);
+    if (stop_fd >= 0) close(stop_fd);
+    wake_fd = -1;
+    stop_fd = -1;
+}
+
+bool is_input_thread_running(void) {
+    return input_thread_running;
+}
+
+bool pop_input_event(TimedInputEvent* out) {
+    uint32_t tail = input_queue_tail;
+    uint32_t head = __atomic_load_n(&input_queue_head, __ATOMIC_ACQUIRE);
+    if (tail == head) {
+        return false;
+    }
+
+    *out = input_queue[tail % INPUT_QUEUE_CAPACITY];
+    __atomic_store_n(&input_queue_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool is_input_queue_empty(void) {
+    return __atomic_load_n(&input_queue_head, __ATOMIC_ACQUIRE) == input_queue_tail;
+}
+
+int wait_for_input_event(double deadline, int watch_fd) {
+    for (;;) {
+        // The producer signals after pushing, so checking before the poll
+        // cannot miss a wake-up; a stale signal only costs one extra loop
+        if (!is_input_queue_empty()) {
+            return TB_OK;
+        }
+        if (__atomic_load_n(&input_failed, __ATOMIC_ACQUIRE)) {
+            return TB_ERR_POLL;
+        }
+
+        int timeout_ms = -1;
+        if (deadline >= 0.0) {
+            double remaining = deadline - get_monotonic_time();
+            timeout_ms = (remaining > 0.0) ? (int)(remaining * 1000.0 + 0.999) : 0;
+        }
+
+        struct pollfd fds[2] = {
+            { wake_fd, POLLIN, 0 },
+            { watch_fd, POLLIN, 0 }
+        };
+        int ready = poll(fds, 2, timeout_ms);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return TB_ERR_POLL;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t count;
+            ssize_t bytes = read(wake_fd, &count, sizeof(count));
+            (void)bytes;
+        }
+
+        if (ready == 0 || (fds[1].revents != 0)) {
+            return is_input_queue_empty() ? TB_ERR_NO_EVENT : TB_OK;
+        }
+    }
+}
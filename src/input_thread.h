@@ -0,0 +1,38 @@
+#ifndef INPUT_THREAD_H
+#define INPUT_THREAD_H
+
+#include "../lib/termbox2/termbox2.h"
+#include <stdbool.h>
+
+// Decoded events waiting for the main loop; a power of two. When it fills
+// up the input thread stops reading and the rest waits in the kernel.
+#define INPUT_QUEUE_CAPACITY 1024
+
+typedef struct {
+    struct tb_event event;
+    double arrival_time;    // Real clock, when the terminal became readable
+} TimedInputEvent;
+
+// Reads and decodes terminal input on its own thread so events are
+// timestamped while the main thread renders or searches. Call after
+// tb_init; returns false if the thread could not be started, in which case
+// collect_input_batch keeps polling termbox directly.
+bool start_input_thread(void);
+void stop_input_thread(void);
+bool is_input_thread_running(void);
+
+// Termbox is not thread-safe and decoding a resize reallocates its cell
+// buffers, so while the input thread runs the main thread holds this lock
+// around every use of the termbox render target
+void lock_terminal(void);
+void unlock_terminal(void);
+
+// Main thread only. Returns false if the queue is empty.
+bool pop_input_event(TimedInputEvent* out);
+
+// Waits until the queue is not empty (TB_OK), get_monotonic_time reaches
+// the deadline or watch_fd becomes readable (TB_ERR_NO_EVENT). A negative
+// deadline waits indefinitely, a negative watch_fd is ignored.
+int wait_for_input_event(double deadline, int watch_fd);
+
+#endif
@@ -0,0 +1,301 @@
+#include "journal.h"
+#include "timing.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define JOURNAL_HEADER_SIZE 16
+#define JOURNAL_RECORD_SIZE 8
+#define JOURNAL_FILE_SIZE (JOURNAL_HEADER_SIZE + JOURNAL_RECORD_CAPACITY * JOURNAL_RECORD_SIZE)
+#define CHECKPOINT_HEADER_SIZE 16
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value & 0xff);
+    out[1] = (unsigned char)((value >> 8) & 0xff);
+    out[2] = (unsigned char)((value >> 16) & 0xff);
+    out[3] = (unsigned char)((value >> 24) & 0xff);
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Tracked fields
+static void capture_journal_state(const ApplicationState* app, JournalState* state) {
+    for (int i = 0; i < 9; i++) {
+        state->fields[JOURNAL_FIELD_BOARD + i] = (uint8_t)app->game.board[i / 3][i % 3];
+    }
+    state->fields[JOURNAL_FIELD_CURRENT_PLAYER] = (uint8_t)app->game.current_player;
+    state->fields[JOURNAL_FIELD_GAME_ACTIVE] = app->game.game_active;
+    state->fields[JOURNAL_FIELD_APP_STATE] = (uint8_t)app->current_state;
+    state->fields[JOURNAL_FIELD_GAME_MODE] = (uint8_t)app->game_mode;
+    state->fields[JOURNAL_FIELD_DIFFICULTY] = (uint8_t)app->ai_difficulty;
+    state->fields[JOURNAL_FIELD_HUMAN_PLAYER] = (uint8_t)app->human_player;
+    state->fields[JOURNAL_FIELD_AI_PLAYER] = (uint8_t)app->ai_player;
+    state->fields[JOURNAL_FIELD_WINNER] = (uint8_t)app->winner;
+    state->fields[JOURNAL_FIELD_IS_DRAW] = app->is_draw;
+    // Only the board game is tracked; a More Games session leaves the
+    // board inactive, and restoring it would resume a dead game
+    state->fields[JOURNAL_FIELD_HAS_ACTIVE_GAME] = app->has_active_game && !has_active_game_session(app);
+}
+
+static bool restore_journal_state(const JournalState* state, ApplicationState* app) {
+    if (!state->fields[JOURNAL_FIELD_HAS_ACTIVE_GAME]) {
+        return false;
+    }
+
+    for (int i = 0; i < 9; i++) {
+        app->game.board[i / 3][i % 3] = (CellState)(state->fields[JOURNAL_FIELD_BOARD + i] % 3);
+    }
+    app->game.current_player = (CellState)(state->fields[JOURNAL_FIELD_CURRENT_PLAYER] % 3);
+    app->game.game_active = state->fields[JOURNAL_FIELD_GAME_ACTIVE] != 0;
+    app->game_mode = (GameMode)(state->fields[JOURNAL_FIELD_GAME_MODE] & 1);
+    app->ai_difficulty = (AIDifficulty)(state->fields[JOURNAL_FIELD_DIFFICULTY] % 3);
+    app->human_player = (CellState)(state->fields[JOURNAL_FIELD_HUMAN_PLAYER] % 3);
+    app->ai_player = (CellState)(state->fields[JOURNAL_FIELD_AI_PLAYER] % 3);
+    app->winner = (CellState)(state->fields[JOURNAL_FIELD_WINNER] % 3);
+    app->is_draw = state->fields[JOURNAL_FIELD_IS_DRAW] != 0;
+    app->has_active_game = true;
+
+    // Back into the game itself; from a menu, the game waits behind it
+    AppState saved = (AppState)state->fields[JOURNAL_FIELD_APP_STATE];
+    app->current_state = (saved == STATE_PLAYING || saved == STATE_GAME_OVER) ? saved : STATE_MAIN_MENU;
+    return true;
+}
+
+// Files
+static bool make_directories(const char* path) {
+    char partial[512];
+    size_t length = strlen(path);
+    if (length == 0 || length >= sizeof(partial)) return false;
+
+    for (size_t i = 1; i <= length; i++) {
+        if (path[i] == '/' || path[i] == '\0') {
+            memcpy(partial, path, i);
+            partial[i] = '\0';
+            if (mkdir(partial, 0700) != 0 && errno != EEXIST) return false;
+        }
+    }
+    return true;
+}
+
+static bool get_journal_directory(char* buffer, size_t size) {
+    const char* from_env = getenv(JOURNAL_STATE_DIR_ENV);
+    const char* home = getenv("HOME");
+    int written;
+
+    if (from_env && *from_env) {
+        written = snprintf(buffer, size, "%s", from_env);
+    } else if (home && *home) {
+        written = snprintf(buffer, size, "%s/.local/state/tictactoe", home);
+    } else {
+        return false;
+    }
+
+    return written > 0 && (size_t)written < size && make_directories(buffer);
+}
+
+static void get_journal_path(const SessionJournal* journal, const char* name, char* buffer, size_t size) {
+    snprintf(buffer, size, "%s/%s", journal->directory, name);
+}
+
+// Maps the checkpoint read-only; false if there is none usable
+static bool read_checkpoint(const SessionJournal* journal, JournalState* state, uint32_t* sequence) {
+    char path[600];
+    get_journal_path(journal, "session.checkpoint", path, sizeof(path));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    bool ok = false;
+    if (fstat(fd, &info) == 0 && info.st_size == CHECKPOINT_HEADER_SIZE + JOURNAL_FIELD_COUNT) {
+        void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            const unsigned char* data = (const unsigned char*)map;
+            if (memcmp(data, "TTTC", 4) == 0 && get_u32(data + 4) == JOURNAL_VERSION &&
+                get_u32(data + 12) == JOURNAL_FIELD_COUNT) {
+                *sequence = get_u32(data + 8);
+                memcpy(state->fields, data + CHECKPOINT_HEADER_SIZE, JOURNAL_FIELD_COUNT);
+                ok = true;
+            }
+            munmap(map, (size_t)info.st_size);
+        }
+    }
+
+    close(fd);
+    return ok;
+}
+
+// Written beside the old one and renamed over it, so a crash leaves
+// either checkpoint intact
+static bool write_checkpoint(const SessionJournal* journal, const JournalState* state, uint32_t sequence) {
+    char path[600];
+    char temporary[620];
+    get_journal_path(journal, "session.checkpoint", path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+
+    unsigned char data[CHECKPOINT_HEADER_SIZE + JOURNAL_FIELD_COUNT];
+    memcpy(data, "TTTC", 4);
+    put_u32(data + 4, JOURNAL_VERSION);
+    put_u32(data + 8, sequence);
+    put_u32(data + 12, JOURNAL_FIELD_COUNT);
+    memcpy(data + CHECKPOINT_HEADER_SIZE, state->fields, JOURNAL_FIELD_COUNT);
+
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return false;
+
+    bool ok = write(fd, data, sizeof(data)) == (ssize_t)sizeof(data);
+    close(fd);
+    return ok && rename(temporary, path) == 0;
+}
+
+// Checkpoint the journaled fields, then empty the log. Records the log
+// still holds are at or below the checkpoint's sequence, so a crash in
+// between replays nothing twice.
+static void compact_session_journal(SessionJournal* journal) {
+    uint32_t sequence = journal->base_sequence + journal->record_count;
+    if (!write_checkpoint(journal, &journal->journaled, sequence)) {
+        return;
+    }
+
+    put_u32(journal->map + 8, sequence);
+    memset(journal->map + JOURNAL_HEADER_SIZE, 0, (size_t)journal->record_count * JOURNAL_RECORD_SIZE);
+    journal->base_sequence = sequence;
+    journal->record_count = 0;
+}
+
+static void append_record(SessionJournal* journal, int field, uint8_t value) {
+    if (journal->record_count == JOURNAL_RECORD_CAPACITY) {
+        compact_session_journal(journal);
+        if (journal->record_count == JOURNAL_RECORD_CAPACITY) return;
+    }
+
+    unsigned char* record = journal->map + JOURNAL_HEADER_SIZE + journal->record_count * JOURNAL_RECORD_SIZE;
+    record[0] = (uint8_t)field;
+    record[1] = value;
+
+    // The sequence makes the record valid, so it goes in last
+    uint32_t sequence = journal->base_sequence + journal->record_count + 1;
+    unsigned char encoded[4];
+    put_u32(encoded, sequence);
+    uint32_t word;
+    memcpy(&word, encoded, sizeof(word));
+    __atomic_store_n((uint32_t*)(record + 4), word, __ATOMIC_RELEASE);
+
+    journal->record_count++;
+}
+
+bool open_session_journal(SessionJournal* journal, ApplicationState* app) {
+    journal->fd = -1;
+    journal->map = NULL;
+    journal->base_sequence = 0;
+    journal->record_count = 0;
+    journal->records_replayed = 0;
+    journal->recovery_time = 0.0;
+
+    if (!get_journal_directory(journal->directory, sizeof(journal->directory))) {
+        return false;
+    }
+
+    char path[600];
+    get_journal_path(journal, "session.journal", path, sizeof(path));
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) return false;
+
+    // The log is shared memory; a second instance runs without one
+    // rather than interleave records with the first. The lock goes with
+    // the fd, at close or at exit.
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close(fd);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (info.st_size != JOURNAL_FILE_SIZE && ftruncate(fd, JOURNAL_FILE_SIZE) != 0)) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, JOURNAL_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    journal->fd = fd;
+    journal->map = (unsigned char*)map;
+    journal->map_size = JOURNAL_FILE_SIZE;
+
+    // Checkpoint, then the log's tail past it
+    double start = get_monotonic_time();
+    JournalState state;
+    capture_journal_state(app, &state);
+    uint32_t sequence = 0;
+    read_checkpoint(journal, &state, &sequence);
+
+    bool valid_log = memcmp(journal->map, "TTTJ", 4) == 0 && get_u32(journal->map + 4) == JOURNAL_VERSION;
+    if (valid_log) {
+        uint32_t base = get_u32(journal->map + 8);
+        for (uint32_t i = 0; i < JOURNAL_RECORD_CAPACITY; i++) {
+            const unsigned char* record = journal->map + JOURNAL_HEADER_SIZE + i * JOURNAL_RECORD_SIZE;
+            uint32_t record_sequence = get_u32(record + 4);
+            if (record_sequence != base + i + 1) break;
+            if (record_sequence <= sequence || record[0] >= JOURNAL_FIELD_COUNT) continue;
+
+            state.fields[record[0]] = record[1];
+            sequence = record_sequence;
+            journal->records_replayed++;
+        }
+    }
+
+    bool restored = restore_journal_state(&state, app);
+    journal->recovery_time = get_monotonic_time() - start;
+
+    // Continue from a fresh checkpoint of what was restored; the old log
+    // is only cleared once that is safely written
+    capture_journal_state(app, &journal->journaled);
+    write_checkpoint(journal, &journal->journaled, sequence);
+    memset(journal->map, 0, JOURNAL_FILE_SIZE);
+    memcpy(journal->map, "TTTJ", 4);
+    put_u32(journal->map + 4, JOURNAL_VERSION);
+    put_u32(journal->map + 8, sequence);
+    journal->base_sequence = sequence;
+
+    return restored;
+}
+
+void sync_session_journal(SessionJournal* journal, const ApplicationState* app) {
+    if (journal->fd < 0) return;
+
+    JournalState current;
+    capture_journal_state(app, &current);
+
+    for (int i = 0; i < JOURNAL_FIELD_COUNT; i++) {
+        if (current.fields[i] != journal->journaled.fields[i]) {
+            append_record(journal, i, current.fields[i]);
+            journal->journaled.fields[i] = current.fields[i];
+        }
+    }
+
+    if (journal->record_count >= JOURNAL_CHECKPOINT_INTERVAL) {
+        compact_session_journal(journal);
+    }
+}
+
+void close_session_journal(SessionJournal* journal, const ApplicationState* app) {
+    if (journal->fd < 0) return;
+
+    sync_session_journal(journal, app);
+    compact_session_journal(journal);
+
+    munmap(journal->map, journal->map_size);
+    close(journal->fd);
+    journal->map = NULL;
+    journal->fd = -1;
+}
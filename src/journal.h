@@ -0,0 +1,68 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "game.h"
+#include <stdint.h>
+
+// Crash-safe record of the current game. Every frame the tracked fields
+// below are compared with the last journaled values and each change is
+// appended to a memory-mapped log; a process crash loses nothing already
+// stored there. Every JOURNAL_CHECKPOINT_INTERVAL records (and when the
+// log fills) the fields are compacted into a checkpoint file and the log
+// starts over, so recovery maps one small checkpoint and replays at most
+// that many records, however long the session ran.
+//
+// Files live in $TICTACTOE_STATE_DIR, else ~/.local/state/tictactoe:
+//   session.checkpoint  "TTTC" u32 version, u32 sequence, u32 field count, fields
+//   session.journal     "TTTJ" u32 version, u32 base sequence, u32 unused,
+//                       then 8-byte records: u8 field, u8 value, u16 unused, u32 sequence
+// A record is valid only if its sequence is base + index + 1, and it is
+// written last, so a torn record is ignored.
+#define JOURNAL_STATE_DIR_ENV "TICTACTOE_STATE_DIR"
+#define JOURNAL_VERSION 1
+#define JOURNAL_RECORD_CAPACITY 1024
+#define JOURNAL_CHECKPOINT_INTERVAL 256
+
+// Tracked fields, one byte each
+typedef enum {
+    JOURNAL_FIELD_BOARD,                 // 9 cells, row-major
+    JOURNAL_FIELD_CURRENT_PLAYER = 9,
+    JOURNAL_FIELD_GAME_ACTIVE,
+    JOURNAL_FIELD_APP_STATE,
+    JOURNAL_FIELD_GAME_MODE,
+    JOURNAL_FIELD_DIFFICULTY,
+    JOURNAL_FIELD_HUMAN_PLAYER,
+    JOURNAL_FIELD_AI_PLAYER,
+    JOURNAL_FIELD_WINNER,
+    JOURNAL_FIELD_IS_DRAW,
+    JOURNAL_FIELD_HAS_ACTIVE_GAME,
+    JOURNAL_FIELD_COUNT
+} JournalField;
+
+typedef struct {
+    uint8_t fields[JOURNAL_FIELD_COUNT];
+} JournalState;
+
+typedef struct {
+    char directory[512];
+    int fd;
+    unsigned char* map;        // Journal file, MAP_SHARED
+    size_t map_size;
+    uint32_t base_sequence;    // Sequence of the last checkpoint
+    uint32_t record_count;     // Records since then
+    JournalState journaled;    // Fields as of the last record
+    double recovery_time;      // Seconds spent restoring at open
+    uint32_t records_replayed;
+} SessionJournal;
+
+// Opens (or creates) the journal and restores the latest state into app.
+// Returns true if a game was restored; journal->fd < 0 if journaling is off.
+bool open_session_journal(SessionJournal* journal, ApplicationState* app);
+
+// Appends whatever changed since the last call; call once per frame
+void sync_session_journal(SessionJournal* journal, const ApplicationState* app);
+
+// Final sync and checkpoint
+void close_session_journal(SessionJournal* journal, const ApplicationState* app);
+
+#endif
@@ -0,0 +1,572 @@
+#include "latency_bench.h"
+#include "timing.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Screen contents rebuilt from the game's terminal output. Only what the
+// scenarios look at is kept: characters and background colours.
+typedef struct {
+    uint32_t ch[LATENCY_SCREEN_HEIGHT][LATENCY_SCREEN_WIDTH];
+    int bg[LATENCY_SCREEN_HEIGHT][LATENCY_SCREEN_WIDTH];
+    int row;
+    int col;
+    int current_bg;
+
+    // Escape sequence parser
+    int state;
+    char sequence[64];
+    int sequence_length;
+
+    // UTF-8 decoder
+    uint32_t codepoint;
+    int continuation_bytes;
+} VirtualScreen;
+
+enum {
+    VT_TEXT,
+    VT_ESCAPE,
+    VT_CSI,
+    VT_OSC,
+    VT_CHARSET
+};
+
+#define VT_DEFAULT_BG -1
+
+typedef struct {
+    pid_t pid;
+    int master_fd;
+    char state_dir[PATH_MAX];
+    VirtualScreen screen;
+} GameProcess;
+
+typedef bool (*ScreenCondition)(const VirtualScreen* screen, const void* context);
+
+// Virtual terminal
+static void clear_screen_cells(VirtualScreen* screen) {
+    for (int y = 0; y < LATENCY_SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < LATENCY_SCREEN_WIDTH; x++) {
+            screen->ch[y][x] = ' ';
+            screen->bg[y][x] = VT_DEFAULT_BG;
+        }
+    }
+}
+
+static void init_virtual_screen(VirtualScreen* screen) {
+    memset(screen, 0, sizeof(*screen));
+    screen->current_bg = VT_DEFAULT_BG;
+    clear_screen_cells(screen);
+}
+
+static void put_screen_char(VirtualScreen* screen, uint32_t ch) {
+    if (screen->row >= 0 && screen->row < LATENCY_SCREEN_HEIGHT &&
+        screen->col >= 0 && screen->col < LATENCY_SCREEN_WIDTH) {
+        screen->ch[screen->row][screen->col] = ch;
+        screen->bg[screen->row][screen->col] = screen->current_bg;
+    }
+    screen->col++;
+}
+
+static int sequence_param(const char* params, int index, int fallback) {
+    const char* p = params;
+    for (int i = 0; i < index; i++) {
+        p = strchr(p, ';');
+        if (!p) return fallback;
+        p++;
+    }
+    return (*p >= '0' && *p <= '9') ? atoi(p) : fallback;
+}
+
+static void apply_sgr(VirtualScreen* screen, const char* params) {
+    const char* p = params;
+    for (;;) {
+        int value = (*p >= '0' && *p <= '9') ? atoi(p) : 0;
+
+        if (value == 0 || value == 49) {
+            screen->current_bg = VT_DEFAULT_BG;
+        } else if (value >= 40 && value <= 47) {
+            screen->current_bg = value - 40;
+        } else if (value >= 100 && value <= 107) {
+            screen->current_bg = value - 100 + 8;
+        } else if (value == 48) {
+            // 48;5;n
+            const char* next = strchr(p, ';');
+            next = next ? strchr(next + 1, ';') : NULL;
+            if (next) {
+                screen->current_bg = atoi(next + 1);
+                p = next;
+            }
+        }
+
+        p = strchr(p, ';');
+        if (!p) break;
+        p++;
+    }
+}
+
+static void apply_csi(VirtualScreen* screen, char final, const char* params) {
+    if (params[0] == '?') return;   // Private modes (cursor, mouse)
+
+    switch (final) {
+        case 'H':
+        case 'f':
+            screen->row = sequence_param(params, 0, 1) - 1;
+            screen->col = sequence_param(params, 1, 1) - 1;
+            break;
+        case 'A': screen->row -= sequence_param(params, 0, 1); break;
+        case 'B': screen->row += sequence_param(params, 0, 1); break;
+        case 'C': screen->col += sequence_param(params, 0, 1); break;
+        case 'D': screen->col -= sequence_param(params, 0, 1); break;
+        case 'G': screen->col = sequence_param(params, 0, 1) - 1; break;
+        case 'd': screen->row = sequence_param(params, 0, 1) - 1; break;
+        case 'm': apply_sgr(screen, params); break;
+        case 'J':
+            if (sequence_param(params, 0, 0) == 2) clear_screen_cells(screen);
+            break;
+        case 'K':
+            if (screen->row >= 0 && screen->row < LATENCY_SCREEN_HEIGHT) {
+                for (int x = screen->col < 0 ? 0 : screen->col; x < LATENCY_SCREEN_WIDTH; x++) {
+                    screen->ch[screen->row][x] = ' ';
+                    screen->bg[screen->row][x] = screen->current_bg;
+                }
+            }
+            break;
+    }
+}
+
+static void feed_virtual_screen(VirtualScreen* screen, const unsigned char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char byte = data[i];
+
+        switch (screen->state) {
+            case VT_ESCAPE:
+                screen->sequence_length = 0;
+                if (byte == '[') screen->state = VT_CSI;
+                else if (byte == ']') screen->state = VT_OSC;
+                else if (byte == '(' || byte == ')') screen->state = VT_CHARSET;
+                else screen->state = VT_TEXT;
+                continue;
+
+            case VT_CHARSET:
+                screen->state = VT_TEXT;
+                continue;
+
+            case VT_OSC:
+                if (byte == 0x07 || byte == '\\') screen->state = VT_TEXT;
+                continue;
+
+            case VT_CSI:
+                if (byte >= 0x40 && byte <= 0x7e) {
+                    screen->sequence[screen->sequence_length] = '\0';
+                    apply_csi(screen, (char)byte, screen->sequence);
+                    screen->state = VT_TEXT;
+                } else if (screen->sequence_length < (int)sizeof(screen->sequence) - 1) {
+                    screen->sequence[screen->sequence_length++] = (char)byte;
+                }
+                continue;
+        }
+
+        if (screen->continuation_bytes > 0 && (byte & 0xc0) == 0x80) {
+            screen->codepoint = (screen->codepoint << 6) | (byte & 0x3f);
+            if (--screen->continuation_bytes == 0) put_screen_char(screen, screen->codepoint);
+            continue;
+        }
+        screen->continuation_bytes = 0;
+
+        if (byte == 0x1b) {
+            screen->state = VT_ESCAPE;
+        } else if (byte == '\r') {
+            screen->col = 0;
+        } else if (byte == '\n') {
+            screen->row++;
+        } else if (byte == '\b') {
+            screen->col--;
+        } else if (byte >= 0xf0) {
+            screen->codepoint = byte & 0x07;
+            screen->continuation_bytes = 3;
+        } else if (byte >= 0xe0) {
+            screen->codepoint = byte & 0x0f;
+            screen->continuation_bytes = 2;
+        } else if (byte >= 0xc0) {
+            screen->codepoint = byte & 0x1f;
+            screen->continuation_bytes = 1;
+        } else if (byte >= 0x20) {
+            put_screen_char(screen, byte);
+        }
+    }
+}
+
+static bool screen_contains(const VirtualScreen* screen, const char* text) {
+    size_t length = strlen(text);
+    for (int y = 0; y < LATENCY_SCREEN_HEIGHT; y++) {
+        for (int x = 0; x + (int)length <= LATENCY_SCREEN_WIDTH; x++) {
+            size_t i = 0;
+            while (i < length && screen->ch[y][x + i] == (unsigned char)text[i]) i++;
+            if (i == length) return true;
+        }
+    }
+    return false;
+}
+
+// The cursor is the one cell drawn on a white background
+static bool find_screen_cursor(const VirtualScreen* screen, int* x, int* y) {
+    for (int row = 0; row < LATENCY_SCREEN_HEIGHT; row++) {
+        for (int col = 0; col < LATENCY_SCREEN_WIDTH; col++) {
+            if (screen->bg[row][col] == 7 || screen->bg[row][col] == 15) {
+                *x = col;
+                *y = row;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Board cells sit inside the box drawn from its top-left corner
+static bool find_board_cell(const VirtualScreen* screen, int cell, int* x, int* y) {
+    for (int row = 0; row < LATENCY_SCREEN_HEIGHT; row++) {
+        for (int col = 0; col < LATENCY_SCREEN_WIDTH; col++) {
+            if (screen->ch[row][col] == 0x250c) {
+                *x = col + 2 + (cell % 3) * 4;
+                *y = row + 1 + (cell / 3) * 2;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static int count_board_marks(const VirtualScreen* screen, uint32_t mark) {
+    int count = 0;
+    for (int cell = 0; cell < 9; cell++) {
+        int x, y;
+        if (find_board_cell(screen, cell, &x, &y) && screen->ch[y][x] == mark) count++;
+    }
+    return count;
+}
+
+// Game process
+static bool start_game_process(GameProcess* game) {
+    init_virtual_screen(&game->screen);
+    game->pid = -1;
+
+    // A private journal directory, so no earlier game gets resumed
+    snprintf(game->state_dir, sizeof(game->state_dir), "/tmp/tictactoe-latency-XXXXXX");
+    if (!mkdtemp(game->state_dir)) return false;
+
+    game->master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (game->master_fd < 0 || grantpt(game->master_fd) != 0 || unlockpt(game->master_fd) != 0) {
+        return false;
+    }
+
+    const char* slave_name = ptsname(game->master_fd);
+    if (!slave_name) return false;
+
+    char executable[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length <= 0) return false;
+    executable[length] = '\0';
+
+    game->pid = fork();
+    if (game->pid < 0) return false;
+
+    if (game->pid == 0) {
+        setsid();
+        int slave_fd = open(slave_name, O_RDWR);
+        if (slave_fd < 0) _exit(127);
+        ioctl(slave_fd, TIOCSCTTY, 0);
+
+        struct winsize size;
+        memset(&size, 0, sizeof(size));
+        size.ws_col = LATENCY_SCREEN_WIDTH;
+        size.ws_row = LATENCY_SCREEN_HEIGHT;
+        ioctl(slave_fd, TIOCSWINSZ, &size);
+
+        dup2(slave_fd, STDIN_FILENO);
+        dup2(slave_fd, STDOUT_FILENO);
+        dup2(slave_fd, STDERR_FILENO);
+        if (slave_fd > STDERR_FILENO) close(slave_fd);
+        close(game->master_fd);
+
+        setenv("TERM", "xterm", 1);
+        setenv("TICTACTOE_STATE_DIR", game->state_dir, 1);
+        unsetenv("TICTACTOE_TRACE");
+        execl(executable, executable, (char*)NULL);
+        _exit(127);
+    }
+
+    return true;
+}
+
+static void stop_game_process(GameProcess* game) {
+    if (game->pid > 0) {
+        (void)!write(game->master_fd, "q", 1);
+
+        // Give it a moment to quit cleanly, then make sure
+        double deadline = get_monotonic_time() + 1.0;
+        int status;
+        while (waitpid(game->pid, &status, WNOHANG) == 0) {
+            if (get_monotonic_time() > deadline) {
+                kill(game->pid, SIGKILL);
+                waitpid(game->pid, &status, 0);
+                break;
+            }
+            usleep(1000);
+        }
+    }
+    if (game->master_fd >= 0) close(game->master_fd);
+
+    char path[PATH_MAX + 32];
+    snprintf(path, sizeof(path), "%s/session.journal", game->state_dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/session.checkpoint", game->state_dir);
+    unlink(path);
+    rmdir(game->state_dir);
+}
+
+static bool send_input(GameProcess* game, const char* bytes) {
+    size_t length = strlen(bytes);
+    return write(game->master_fd, bytes, length) == (ssize_t)length;
+}
+
+static bool send_click(GameProcess* game, int x, int y) {
+    char sequence[64];
+    snprintf(sequence, sizeof(sequence), "\x1b[<0;%d;%dM\x1b[<0;%d;%dm", x + 1, y + 1, x + 1, y + 1);
+    return send_input(game, sequence);
+}
+
+// Reads output until the condition holds; returns the time it first did,
+// or a negative value on timeout
+static double wait_for_screen(GameProcess* game, ScreenCondition condition, const void* context) {
+    double deadline = get_monotonic_time() + LATENCY_SAMPLE_TIMEOUT_SECONDS;
+    unsigned char buffer[16384];
+
+    for (;;) {
+        if (condition(&game->screen, context)) {
+            return get_monotonic_time();
+        }
+
+        double remaining = deadline - get_monotonic_time();
+        if (remaining <= 0.0) return -1.0;
+
+        struct pollfd pfd = {game->master_fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, (int)(remaining * 1000.0) + 1);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return -1.0;
+
+        ssize_t count = read(game->master_fd, buffer, sizeof(buffer));
+        if (count <= 0) return -1.0;
+        feed_virtual_screen(&game->screen, buffer, (size_t)count);
+    }
+}
+
+// Conditions
+static bool shows_text(const VirtualScreen* screen, const void* context) {
+    return screen_contains(screen, (const char*)context);
+}
+
+typedef struct {
+    int x;
+    int y;
+} ScreenPoint;
+
+static bool cursor_at(const VirtualScreen* screen, const void* context) {
+    const ScreenPoint* point = (const ScreenPoint*)context;
+    int x, y;
+    return find_screen_cursor(screen, &x, &y) && x == point->x && y == point->y;
+}
+
+static bool cell_has_mark(const VirtualScreen* screen, const void* context) {
+    const ScreenPoint* point = (const ScreenPoint*)context;
+    uint32_t ch = screen->ch[point->y][point->x];
+    return ch == 'X' || ch == 'O';
+}
+
+static bool board_has_o(const VirtualScreen* screen, const void* context) {
+    (void)context;
+    return count_board_marks(screen, 'O') > 0;
+}
+
+static bool board_is_empty(const VirtualScreen* screen, const void* context) {
+    (void)context;
+    return screen_contains(screen, "Current Player: X") &&
+           count_board_marks(screen, 'X') + count_board_marks(screen, 'O') == 0;
+}
+
+// Statistics
+typedef struct {
+    const char* name;
+    double* latencies;
+    int count;
+    int failures;
+} LatencyScenario;
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void record_latency(LatencyScenario* scenario, double start, double end) {
+    if (end < 0.0) {
+        scenario->failures++;
+    } else {
+        scenario->latencies[scenario->count++] = end - start;
+    }
+}
+
+static void report_scenario(LatencyScenario* scenario) {
+    if (scenario->count == 0) {
+        printf("  %-18s no samples (%d timed out)\n", scenario->name, scenario->failures);
+        return;
+    }
+
+    qsort(scenario->latencies, scenario->count, sizeof(double), compare_doubles);
+    double* l = scenario->latencies;
+    int n = scenario->count;
+    printf("  %-18s %5d  p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f ms", scenario->name, n,
+           l[n / 2] * 1e3, l[n * 9 / 10] * 1e3, l[n * 99 / 100] * 1e3, l[n - 1] * 1e3);
+    if (scenario->failures) printf("  (%d timed out)", scenario->failures);
+    printf("\n");
+}
+
+// Scenarios. Each starts from the main menu of a fresh process.
+static void measure_menu_transitions(GameProcess* game, LatencyScenario* scenario, int samples) {
+    for (int i = 0; i < samples; i++) {
+        double start = get_monotonic_time();
+        send_input(game, "n");
+        record_latency(scenario, start, wait_for_screen(game, shows_text, "SELECT GAME MODE"));
+
+        start = get_monotonic_time();
+        send_input(game, "b");
+        record_latency(scenario, start, wait_for_screen(game, shows_text, "TIC-TAC-TOE GAME"));
+    }
+}
+
+static void measure_cursor_moves(GameProcess* game, LatencyScenario* scenario, int samples) {
+    ScreenPoint target;
+    if (!find_screen_cursor(&game->screen, &target.x, &target.y)) {
+        // Nothing drawn yet: nudge the cursor onto the screen
+        send_input(game, "\x1b[B");
+        wait_for_screen(game, cursor_at, &target);
+    }
+    if (!find_screen_cursor(&game->screen, &target.x, &target.y)) {
+        scenario->failures += samples;
+        return;
+    }
+
+    for (int i = 0; i < samples; i++) {
+        bool right = (i % 2) == 0;
+        target.x += right ? 1 : -1;
+
+        double start = get_monotonic_time();
+        send_input(game, right ? "\x1b[C" : "\x1b[D");
+        record_latency(scenario, start, wait_for_screen(game, cursor_at, &target));
+    }
+}
+
+static void measure_mark_placement(GameProcess* game, LatencyScenario* scenario, int samples) {
+    send_input(game, "n");
+    wait_for_screen(game, shows_text, "SELECT GAME MODE");
+    send_input(game, "1");
+    wait_for_screen(game, board_is_empty, NULL);
+
+    for (int i = 0; i < samples; i++) {
+        ScreenPoint cell;
+        if (!find_board_cell(&game->screen, i % 9, &cell.x, &cell.y)) {
+            scenario->failures++;
+            continue;
+        }
+
+        double start = get_monotonic_time();
+        send_click(game, cell.x, cell.y);
+        record_latency(scenario, start, wait_for_screen(game, cell_has_mark, &cell));
+
+        send_input(game, "r");
+        wait_for_screen(game, board_is_empty, NULL);
+    }
+}
+
+static void measure_ai_replies(GameProcess* game, LatencyScenario* scenario, const char* difficulty_key, int samples) {
+    send_input(game, "n");
+    wait_for_screen(game, shows_text, "SELECT GAME MODE");
+    send_input(game, "2");
+    wait_for_screen(game, shows_text, "SELECT DIFFICULTY");
+    send_input(game, difficulty_key);
+    wait_for_screen(game, board_is_empty, NULL);
+
+    for (int i = 0; i < samples; i++) {
+        ScreenPoint cell;
+        if (!find_board_cell(&game->screen, i % 9, &cell.x, &cell.y)) {
+            scenario->failures++;
+            continue;
+        }
+
+        double start = get_monotonic_time();
+        send_click(game, cell.x, cell.y);
+        record_latency(scenario, start, wait_for_screen(game, board_has_o, NULL));
+
+        send_input(game, "r");
+        wait_for_screen(game, board_is_empty, NULL);
+    }
+}
+
+int run_latency_benchmark(int samples) {
+    const char* names[] = {"menu transition", "cursor move", "place mark", "AI reply (easy)",
+                           "AI reply (medium)", "AI reply (hard)"};
+    const int scenario_count = (int)(sizeof(names) / sizeof(names[0]));
+
+    LatencyScenario scenarios[6];
+    double* storage = (double*)malloc(sizeof(double) * scenario_count * samples * 2);
+    if (!storage) return 1;
+
+    for (int i = 0; i < scenario_count; i++) {
+        scenarios[i].name = names[i];
+        scenarios[i].latencies = storage + i * samples * 2;
+        scenarios[i].count = 0;
+        scenarios[i].failures = 0;
+    }
+
+    printf("Latency benchmark: input to screen through a %dx%d pseudo-terminal, %d samples each\n",
+           LATENCY_SCREEN_WIDTH, LATENCY_SCREEN_HEIGHT, samples);
+
+    int result = 0;
+    for (int i = 0; i < scenario_count && result == 0; i++) {
+        GameProcess game;
+        if (!start_game_process(&game)) {
+            fprintf(stderr, "Failed to start the game in a pseudo-terminal\n");
+            result = 1;
+            break;
+        }
+
+        if (wait_for_screen(&game, shows_text, "TIC-TAC-TOE GAME") < 0.0) {
+            fprintf(stderr, "The game never drew its main menu\n");
+            result = 1;
+        } else if (i == 0) {
+            measure_menu_transitions(&game, &scenarios[i], samples);
+        } else if (i == 1) {
+            measure_cursor_moves(&game, &scenarios[i], samples);
+        } else if (i == 2) {
+            measure_mark_placement(&game, &scenarios[i], samples);
+        } else {
+            const char* keys[] = {"1", "2", "3"};
+            measure_ai_replies(&game, &scenarios[i], keys[i - 3], samples);
+        }
+
+        stop_game_process(&game);
+        report_scenario(&scenarios[i]);
+    }
+
+    free(storage);
+    return result;
+}
@@ -0,0 +1,16 @@
+#ifndef LATENCY_BENCH_H
+#define LATENCY_BENCH_H
+
+// Terminal size the benchmarked game runs at
+#define LATENCY_SCREEN_WIDTH 80
+#define LATENCY_SCREEN_HEIGHT 24
+
+// Give up on a sample after this long
+#define LATENCY_SAMPLE_TIMEOUT_SECONDS 2.0
+
+// Runs this binary interactively inside a pseudo-terminal, types scripted
+// keys and mouse clicks into it and times how long until the screen it
+// writes shows the result. Reports percentiles per scenario.
+int run_latency_benchmark(int samples);
+
+#endif
@@ -0,0 +1,226 @@
+#include "layout.h"
+#include "game.h"
+#include "games/tictactoe.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Menu contents; the renderer draws exactly these labels at the widget rects
+static const char* main_menu_labels[] = { "[N] New Game", "[G] More Games", "[Q] Quit" };
+static const char* main_menu_labels_with_continue[] = { "[N] New Game", "[C] Continue", "[G] More Games", "[Q] Quit" };
+static const char* game_labels[] = {
+    "[1] Tic-Tac-Toe",
+    "[2] Tetris",
+    "[3] Snake",
+    "[B] Back to Main Menu"
+};
+static const char* mode_labels[] = {
+    "[1] Two Player",
+    "[2] Single Player (vs AI)",
+    "[B] Back to Main Menu"
+};
+static const char* difficulty_labels[] = {
+    "[1] Easy (AI makes mistakes)",
+    "[2] Medium (Good AI)",
+    "[3] Hard (Unbeatable AI)",
+    "[B] Back to Mode Selection"
+};
+static const char* game_over_labels[] = { "[R] Restart Game", "[M] Main Menu", "[Q] Quit" };
+
+#define MENU_ITEMS_TOP 9
+#define GAME_OVER_TOP 16
+
+void init_layout(Layout* layout) {
+    layout->valid = false;
+    layout->app_state = -1;
+    layout->has_active_game = false;
+    layout->screen_width = 0;
+    layout->screen_height = 0;
+    layout->widget_count = 0;
+    layout->title_x = 0;
+    layout->title_y = 0;
+    layout->footer_y = 0;
+    layout->board_x = 0;
+    layout->board_y = 0;
+    layout->hit_grid = NULL;
+    layout->hit_grid_capacity = 0;
+}
+
+void cleanup_layout(Layout* layout) {
+    free(layout->hit_grid);
+    init_layout(layout);
+}
+
+static void add_widget(Layout* layout, WidgetKind kind, int index, const char* label,
+                       int x, int y, int width, int height) {
+    if (layout->widget_count >= LAYOUT_MAX_WIDGETS) return;
+
+    Widget* widget = &layout->widgets[layout->widget_count++];
+    widget->kind = kind;
+    widget->index = index;
+    widget->label = label;
+    widget->x = x;
+    widget->y = y;
+    widget->width = width;
+    widget->height = height;
+}
+
+// Stacks one label per row starting at (x, y); returns the row after the list
+static int add_label_list(Layout* layout, WidgetKind kind, const char** labels, int count, int x, int y) {
+    for (int i = 0; i < count; i++) {
+        add_widget(layout, kind, i, labels[i], x, y, (int)strlen(labels[i]), 1);
+        y++;
+    }
+    return y;
+}
+
+static void add_board_cells(Layout* layout) {
+    tictactoe_get_board_origin(layout->screen_width, &layout->board_x, &layout->board_y);
+
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            int cell_x, cell_y;
+            tictactoe_get_cell_center(layout->board_x, layout->board_y, col, row, &cell_x, &cell_y);
+            add_widget(layout, WIDGET_BOARD_CELL, row * 3 + col, NULL, cell_x - 1, cell_y, 3, 1);
+        }
+    }
+}
+
+static void build_widgets(Layout* layout) {
+    int x_center = layout->screen_width / 2;
+
+    layout->title_x = x_center - 8;
+    layout->title_y = 5;
+
+    switch (layout->app_state) {
+        case STATE_MAIN_MENU:
+            if (layout->has_active_game) {
+                layout->footer_y = add_label_list(layout, WIDGET_MENU_ITEM, main_menu_labels_with_continue, 4,
+                                                  x_center - 6, MENU_ITEMS_TOP);
+            } else {
+                layout->footer_y = add_label_list(layout, WIDGET_MENU_ITEM, main_menu_labels, 3,
+                                                  x_center - 6, MENU_ITEMS_TOP);
+            }
+            break;
+
+        case STATE_GAME_SELECTION:
+            layout->footer_y = add_label_list(layout, WIDGET_GAME_OPTION, game_labels, 4,
+                                              x_center - 8, MENU_ITEMS_TOP);
+            break;
+
+        case STATE_MODE_SELECTION:
+            layout->footer_y = add_label_list(layout, WIDGET_MODE_OPTION, mode_labels, 3,
+                                              x_center - 8, MENU_ITEMS_TOP);
+            break;
+
+        case STATE_DIFFICULTY_SELECTION:
+            layout->footer_y = add_label_list(layout, WIDGET_DIFFICULTY_OPTION, difficulty_labels, 4,
+                                              x_center - 8, MENU_ITEMS_TOP);
+            break;
+
+        case STATE_PLAYING:
+            add_board_cells(layout);
+            layout->footer_y = layout->board_y + TICTACTOE_BOARD_HEIGHT;
+            break;
+
+        case STATE_GAME_OVER:
+            // Board stays visible but is not interactive; options sit below the result
+            tictactoe_get_board_origin(layout->screen_width, &layout->board_x, &layout->board_y);
+            layout->footer_y = GAME_OVER_TOP;
+            add_label_list(layout, WIDGET_GAME_OVER_OPTION, game_over_labels, 3,
+                           x_center - 7, GAME_OVER_TOP + 6);
+            break;
+
+        default:
+            layout->footer_y = layout->title_y;
+            break;
+    }
+}
+
+static void fill_hit_grid(Layout* layout) {
+    memset(layout->hit_grid, -1, (size_t)(layout->screen_width * layout->screen_height));
+
+    for (int i = 0; i < layout->widget_count; i++) {
+        const Widget* widget = &layout->widgets[i];
+
+        for (int y = widget->y; y < widget->y + widget->height; y++) {
+            if (y < 0 || y >= layout->screen_height) continue;
+
+            for (int x = widget->x; x < widget->x + widget->width; x++) {
+                if (x < 0 || x >= layout->screen_width) continue;
+                layout->hit_grid[y * layout->screen_width + x] = (int8_t)i;
+            }
+        }
+    }
+}
+
+bool refresh_layout(Layout* layout, int app_state, bool has_active_game,
+                    int screen_width, int screen_height) {
+    if (layout->valid &&
+        layout->app_state == app_state &&
+        layout->has_active_game == has_active_game &&
+        layout->screen_width == screen_width &&
+        layout->screen_height == screen_height) {
+        return false;
+    }
+
+    int grid_size = (screen_width > 0 && screen_height > 0) ? screen_width * screen_height : 0;
+    if (grid_size > layout->hit_grid_capacity) {
+        int8_t* grid = (int8_t*)realloc(layout->hit_grid, (size_t)grid_size);
+        if (!grid) {
+            layout->valid = false;
+            return false;
+        }
+        layout->hit_grid = grid;
+        layout->hit_grid_capacity = grid_size;
+    }
+
+    layout->app_state = app_state;
+    layout->has_active_game = has_active_game;
+    layout->screen_width = screen_width;
+    layout->screen_height = screen_height;
+    layout->widget_count = 0;
+
+    build_widgets(layout);
+    if (grid_size > 0) {
+        fill_hit_grid(layout);
+    }
+    layout->valid = true;
+
+    return true;
+}
+
+const Widget* layout_hit_test(const Layout* layout, int x, int y) {
+    if (!layout->valid || x < 0 || y < 0 ||
+        x >= layout->screen_width || y >= layout->screen_height) {
+        return NULL;
+    }
+
+    int index = layout->hit_grid[y * layout->screen_width + x];
+    return (index >= 0) ? &layout->widgets[index] : NULL;
+}
+
+const Widget* layout_find_widget(const Layout* layout, WidgetKind kind, int index) {
+    for (int i = 0; i < layout->widget_count; i++) {
+        if (layout->widgets[i].kind == kind && layout->widgets[i].index == index) {
+            return &layout->widgets[i];
+        }
+    }
+    return NULL;
+}
+
+const Widget* layout_next_widget(const Layout* layout, int x, int y, int direction) {
+    if (!layout->valid || layout->widget_count == 0) {
+        return NULL;
+    }
+
+    const Widget* current = layout_hit_test(layout, x, y);
+    int count = layout->widget_count;
+
+    if (!current) {
+        return (direction > 0) ? &layout->widgets[0] : &layout->widgets[count - 1];
+    }
+
+    int current_index = (int)(current - layout->widgets);
+    int next_index = (current_index + (direction > 0 ? 1 : count - 1)) % count;
+    return &layout->widgets[next_index];
+}
@@ -0,0 +1,69 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LAYOUT_MAX_WIDGETS 32
+
+// Clickable screen elements; index meaning depends on the kind
+typedef enum {
+    WIDGET_MENU_ITEM,          // index = main menu item
+    WIDGET_GAME_OPTION,        // index = game selection item (GameType, then Back)
+    WIDGET_MODE_OPTION,        // index = mode selection item
+    WIDGET_DIFFICULTY_OPTION,  // index = difficulty selection item
+    WIDGET_BOARD_CELL,         // index = row * 3 + col
+    WIDGET_GAME_OVER_OPTION    // index = game over option
+} WidgetKind;
+
+typedef struct {
+    WidgetKind kind;
+    int index;
+    const char* label;  // Text drawn at (x, y), NULL for board cells
+    int x;
+    int y;
+    int width;
+    int height;
+} Widget;
+
+// Screen layout for one application state. Rebuilt only when the state,
+// the screen size or the menu contents change; the hit grid maps every
+// screen cell to the widget drawn there (-1 for none).
+typedef struct {
+    bool valid;
+    int app_state;
+    bool has_active_game;
+    int screen_width;
+    int screen_height;
+
+    Widget widgets[LAYOUT_MAX_WIDGETS];
+    int widget_count;
+
+    // Anchors shared with the renderer
+    int title_x;
+    int title_y;
+    int footer_y;   // First row below the widgets (controls, results)
+    int board_x;
+    int board_y;
+
+    int8_t* hit_grid;           // screen_width * screen_height entries
+    int hit_grid_capacity;
+} Layout;
+
+void init_layout(Layout* layout);
+void cleanup_layout(Layout* layout);
+
+// Recomputes the layout if any input changed; returns true if it did
+bool refresh_layout(Layout* layout, int app_state, bool has_active_game,
+                    int screen_width, int screen_height);
+
+// O(1) lookup of the widget under a screen cell, NULL if none
+const Widget* layout_hit_test(const Layout* layout, int x, int y);
+
+// Widget lookup by kind and index, NULL if not part of this layout
+const Widget* layout_find_widget(const Layout* layout, WidgetKind kind, int index);
+
+// Next (direction > 0) or previous widget after the one under (x, y)
+const Widget* layout_next_widget(const Layout* layout, int x, int y, int direction);
+
+#endif
@@ -2,9 +2,177 @@
 #include "game.h"
 #include "menu.h"
 #include "render.h"
+#include "render_target.h"
+#include "events.h"
+#include "input.h"
+#include "input_thread.h"
+#include "timing.h"
+#include "headless.h"
+#include "latency_bench.h"
+#include "ai_service.h"
+#include "analyze.h"
+#include "netplay.h"
+#include "game_plugins.h"
+#include "replay.h"
+#include "journal.h"
+#include "simulation.h"
+#include "spectator.h"
+#include "asciicast.h"
+#include "trace.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main() {
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [option]\n", program);
+    fprintf(stderr, "  (no option)                    Play in the terminal\n");
+    fprintf(stderr, "  --bench-render WxH [FRAMES]    Benchmark rendering into an in-memory framebuffer\n");
+    fprintf(stderr, "  --capture-frames WxH           Print every screen as text\n");
+    fprintf(stderr, "  --bench-sessions N [THREADS]   Benchmark N concurrent sessions with batched updates\n");
+    fprintf(stderr, "  --bench-dispatch N [THREADS]   Compare interface and static dispatch over N sessions\n");
+    fprintf(stderr, "  --bench-latency [SAMPLES]      Time input-to-screen latency through a pseudo-terminal\n");
+    fprintf(stderr, "  --serve-ai ADDRESS             Answer best-move queries (unix:PATH or tcp:PORT)\n");
+    fprintf(stderr, "  --bench-ai ADDRESS [QUERIES]   Load-test a running AI service\n");
+    fprintf(stderr, "  --analyze [FILE|-] [THREADS]   Score positions, one per line, from FILE or stdin\n");
+    fprintf(stderr, "  --host PORT                    Host a two-player game over TCP (you play X)\n");
+    fprintf(stderr, "  --join HOST:PORT               Join a hosted game (you play O)\n");
+    fprintf(stderr, "  --record FILE                  Play in the terminal, logging input for replay\n");
+    fprintf(stderr, "  --asciicast FILE               Play in the terminal, recording the screen for asciinema\n");
+    fprintf(stderr, "  --broadcast SOCKET             Play in the terminal, streaming the screen to spectators\n");
+    fprintf(stderr, "  --watch SOCKET                 Watch a broadcast game\n");
+    fprintf(stderr, "  --replay FILE                  Re-run a recorded session headless at full speed\n");
+}
+
+// Terminal-free modes; returns -1 if argv does not select one
+static int run_command_line_mode(int argc, char** argv) {
+    if (argc < 2) {
+        return -1;
+    }
+    
+    int width = 0;
+    int height = 0;
+    
+    if (strcmp(argv[1], "--bench-render") == 0 && argc >= 3 && parse_screen_size(argv[2], &width, &height)) {
+        int frames = (argc >= 4) ? atoi(argv[3]) : 1000;
+        return run_render_benchmark(width, height, frames > 0 ? frames : 1000);
+    }
+    
+    if (strcmp(argv[1], "--capture-frames") == 0 && argc >= 3 && parse_screen_size(argv[2], &width, &height)) {
+        return run_frame_capture(width, height, stdout);
+    }
+    
+    if (strcmp(argv[1], "--bench-sessions") == 0 && argc >= 3 && atoi(argv[2]) > 0) {
+        int workers = (argc >= 4) ? atoi(argv[3]) : 0;
+        return run_session_benchmark(atoi(argv[2]), workers > 0 ? workers : 0, 200);
+    }
+    
+    if (strcmp(argv[1], "--bench-dispatch") == 0 && argc >= 3 && atoi(argv[2]) > 0) {
+        int workers = (argc >= 4) ? atoi(argv[3]) : 0;
+        return run_dispatch_benchmark(atoi(argv[2]), workers > 0 ? workers : 0, 200);
+    }
+    
+    if (strcmp(argv[1], "--bench-latency") == 0) {
+        int samples = (argc >= 3) ? atoi(argv[2]) : 200;
+        return run_latency_benchmark(samples > 0 ? samples : 200);
+    }
+    
+    if (strcmp(argv[1], "--replay") == 0 && argc >= 3) {
+        return run_replay(argv[2]);
+    }
+    
+    if (strcmp(argv[1], "--serve-ai") == 0 && argc >= 3) {
+        return run_ai_server(argv[2]);
+    }
+    
+    if (strcmp(argv[1], "--bench-ai") == 0 && argc >= 3) {
+        int queries = (argc >= 4) ? atoi(argv[3]) : 1000000;
+        return run_ai_client_benchmark(argv[2], queries > 0 ? queries : 1000000);
+    }
+    
+    if (strcmp(argv[1], "--analyze") == 0) {
+        int workers = (argc >= 4) ? atoi(argv[3]) : 0;
+        return run_position_analysis(argc >= 3 ? argv[2] : NULL, workers > 0 ? workers : 0);
+    }
+    
+    print_usage(argv[0]);
+    return 2;
+}
+
+// Connects a networked game; returns -1 if argv does not ask for one,
+// 0 once connected, 1 on failure
+static int connect_netplay(int argc, char** argv, NetplaySession* session) {
+    if (argc < 3) {
+        return -1;
+    }
+    
+    if (strcmp(argv[1], "--host") == 0) {
+        return netplay_host(session, atoi(argv[2])) ? 0 : 1;
+    }
+    
+    if (strcmp(argv[1], "--join") == 0) {
+        char host[256];
+        const char* colon = strrchr(argv[2], ':');
+        size_t host_length = colon ? (size_t)(colon - argv[2]) : 0;
+        if (!colon || host_length == 0 || host_length >= sizeof(host)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        memcpy(host, argv[2], host_length);
+        host[host_length] = '\0';
+        return netplay_join(session, host, atoi(colon + 1)) ? 0 : 1;
+    }
+    
+    return -1;
+}
+
+// Tears down a terminal session in reverse order of setup; anything not
+// started yet is NULL (or a closed journal) and skipped. Used both on
+// normal exit and when startup fails part way.
+static void close_terminal_session(ApplicationState* app, SessionJournal* journal, ReplayRecorder* recorder,
+                                   SpectatorServer* spectators, AsciicastRecorder* cast) {
+    close_session_journal(journal, app);
+    
+    if (recorder) {
+        close_replay_recorder(recorder);
+        free(recorder);
+    }
+    
+    stop_spectator_server(spectators);
+    stop_asciicast_recording(cast);
+    
+    if (app->netplay) {
+        netplay_close(app->netplay);
+    }
+    cleanup_application_state(app);
+    unload_all_game_plugins();
+    tb_shutdown();
+}
+
+int main(int argc, char** argv) {
+    TRACE_START();
+    
+    // Before any mode runs, so replays map keys the way the recording did
+    load_keymap();
+    
+    NetplaySession netplay;
+    int netplay_result = connect_netplay(argc, argv, &netplay);
+    if (netplay_result > 0) {
+        return netplay_result;
+    }
+    
+    const char* record_path = (argc >= 3 && strcmp(argv[1], "--record") == 0) ? argv[2] : NULL;
+    const char* broadcast_path = (argc >= 3 && strcmp(argv[1], "--broadcast") == 0) ? argv[2] : NULL;
+    const char* cast_path = (argc >= 3 && strcmp(argv[1], "--asciicast") == 0) ? argv[2] : NULL;
+    
+    if (argc >= 3 && strcmp(argv[1], "--watch") == 0) {
+        return run_spectator_viewer(argv[2]);
+    }
+    
+    int mode_result = (netplay_result < 0 && !record_path && !broadcast_path && !cast_path) ? run_command_line_mode(argc, argv) : -1;
+    if (mode_result >= 0) {
+        return mode_result;
+    }
+    
     // Initialize termbox2
     if (tb_init() != 0) {
         fprintf(stderr, "Failed to initialize termbox\n");
@@ -15,132 +183,167 @@ int main() {
     tb_set_input_mode(TB_INPUT_ESC | TB_INPUT_MOUSE);
     tb_hide_cursor();
     
+    // Only lists plugin files; each is opened when its game is selected
+    discover_game_plugins(NULL);
+    
     ApplicationState app;
     init_application_state(&app);
     
+    if (netplay_result == 0) {
+        start_netplay_game(&app, &netplay);
+    }
+    
+    // Pick up a game a crash interrupted; networked games are not journaled.
+    // Neither are recorded ones: a replay starts from a fresh state, so a
+    // restored game would make it diverge. The journal keeps that game for
+    // the next unrecorded run.
+    SessionJournal journal;
+    journal.fd = -1;
+    if (!app.netplay && !record_path) {
+        open_session_journal(&journal, &app);
+    }
+    
+    // Optional outputs; the recorder is heap-allocated for its write buffer
+    ReplayRecorder* recorder = NULL;
+    SpectatorServer* spectators = NULL;
+    AsciicastRecorder* cast = NULL;
+    const char* failure = NULL;       // Message for the output that failed
+    const char* failed_path = NULL;
+    
+    if (record_path) {
+        recorder = (ReplayRecorder*)malloc(sizeof(ReplayRecorder));
+        if (!recorder || !open_replay_recorder(recorder, record_path, app.random_seed, tb_width(), tb_height())) {
+            free(recorder);
+            recorder = NULL;
+            failure = "Cannot record to";
+            failed_path = record_path;
+        }
+    }
+    
+    if (!failure && broadcast_path) {
+        spectators = start_spectator_server(broadcast_path);
+        if (!spectators) {
+            failure = "Cannot serve spectators on";
+            failed_path = broadcast_path;
+        }
+    }
+    
+    if (!failure && cast_path) {
+        cast = start_asciicast_recording(cast_path, tb_width(), tb_height());
+        if (!cast) {
+            failure = "Cannot record to";
+            failed_path = cast_path;
+        }
+    }
+    
+    // Whatever did start is torn down again
+    if (failure) {
+        close_terminal_session(&app, &journal, recorder, spectators, cast);
+        fprintf(stderr, "%s %s\n", failure, failed_path);
+        return 1;
+    }
+    
+    // Decode and timestamp input off the main thread; without it the loop
+    // polls termbox itself
+    start_input_thread();
+    
+    // Game updates and AI searches run beside the frame loop. Recordings
+    // keep them inline so each result lands on the frame the log replays
+    // it on; network games have no AI.
+    if (!recorder && !app.netplay) {
+        app.simulation = start_simulation_thread();
+    }
+    
+    double last_present_time = 0.0;
+    double pending_input_arrival = 0.0;
+    
     // Main game loop
     while (app.current_state != STATE_QUIT) {
-        clear_screen();
-        
-        // Update hover state before rendering
-        update_hover_state(&app);
+        // The input thread only waits for this while the frame is drawn,
+        // not during input waits or AI searches
+        lock_terminal();
         
-        // Update game state if there's an active game
-        if (has_active_game_session(&app)) {
-            update_game_state(&app, 0.016); // Assume 60fps for timing
-        }
+        // Hover, animations and game update for this frame's time
+        double frame_time = get_monotonic_time();
+        update_frame(&app, frame_time);
         
         // Render current state
-        switch (app.current_state) {
-            case STATE_MAIN_MENU:
-                render_main_menu_with_hover(&app);
-                break;
-                
-            case STATE_GAME_SELECTION:
-                // Render game selection menu (placeholder for now)
-                render_main_menu_with_hover(&app); // Fallback to main menu
-                break;
-                
-            case STATE_MODE_SELECTION:
-                render_mode_selection_with_hover(&app);
-                break;
-                
-            case STATE_DIFFICULTY_SELECTION:
-                render_difficulty_selection_with_hover(&app);
-                break;
-                
-            case STATE_PLAYING:
-                render_game_ui(&app.game);
-                render_game_board_with_hover(&app);
-                
-                // Render AI-specific elements for single player mode
-                if (app.game_mode == MODE_SINGLE_PLAYER) {
-                    render_player_indicators(&app);
-                    render_ai_turn_indicator(&app);
-                    render_ai_thinking_animation(&app);
-                }
-                
-                render_controls(STATE_PLAYING);
-                break;
-                
-            case STATE_GAME_OVER:
-                render_game_ui(&app.game);
-                render_game_board_with_hover(&app);
-                
-                // Render AI-specific elements for single player mode
-                if (app.game_mode == MODE_SINGLE_PLAYER) {
-                    render_player_indicators(&app);
-                }
-                
-                render_game_over_with_hover(&app);
-                break;
-                
-            case STATE_QUIT:
-                break;
-        }
-        
-        // Render global cursor on top of everything
-        render_global_cursor(&app);
+        double render_begin = perf_hud_begin(&app.perf_hud);
+        render_application(&app);
+        perf_hud_end(&app.perf_hud, PERF_PHASE_RENDER, render_begin);
         
+        double present_begin = perf_hud_begin(&app.perf_hud);
         present_screen();
+        perf_hud_end(&app.perf_hud, PERF_PHASE_PRESENT, present_begin);
+        perf_hud_record_input_latency(&app.perf_hud, pending_input_arrival);
+        last_present_time = get_monotonic_time();
+        if (spectators) {
+            publish_spectator_frame(spectators, render_target_cells(), render_target_width(), render_target_height());
+        }
+        if (cast) {
+            record_asciicast_frame(cast, render_target_cells(), render_target_width(), render_target_height(),
+                                   last_present_time);
+        }
+        unlock_terminal();
         
-        // Handle input
-        struct tb_event event;
-        if (tb_poll_event(&event) == TB_OK) {
-            if (event.type == TB_EVENT_MOUSE) {
-                // Update cursor position to mouse coordinates
-                set_cursor_position(&app, event.x, event.y);
-                
-                // Handle mouse clicks
-                if (event.key == TB_KEY_MOUSE_LEFT) {
-                    handle_cursor_click(&app);
-                }
-            } else if (event.type == TB_EVENT_KEY) {
-                switch (app.current_state) {
-                    case STATE_MAIN_MENU:
-                        handle_menu_input(&app, &event);
-                        break;
-                        
-                    case STATE_GAME_SELECTION:
-                        // Handle game selection input (placeholder for now)
-                        handle_menu_input(&app, &event); // Fallback to main menu handler
-                        break;
-                        
-                    case STATE_MODE_SELECTION:
-                        handle_mode_selection_input(&app, &event);
-                        break;
-                        
-                    case STATE_DIFFICULTY_SELECTION:
-                        handle_difficulty_selection_input(&app, &event);
-                        break;
-                        
-                    case STATE_PLAYING:
-                        handle_game_input(&app, &event);
-                        break;
-                        
-                    case STATE_GAME_OVER:
-                        // Game over has its own input handling
-                        handle_game_over_input(&app, &event);
-                        break;
-                        
-                    case STATE_QUIT:
-                        break;
-                }
+        // Handle input: drain everything pending so that a burst of mouse
+        // motion or held keys costs one frame instead of one frame per event.
+        // Running animations and due game updates bound the wait, and a
+        // new simulation frame ends it; with none of these, the loop sleeps.
+        InputBatch batch;
+        double wake_deadline = animation_next_deadline(&app.animations, frame_time);
+        if (is_game_session_running(&app) && !is_simulated_game(&app)) {
+            double game_deadline = get_current_game_deadline(&app.game_manager, frame_time);
+            if (game_deadline >= 0.0 && (wake_deadline < 0.0 || game_deadline < wake_deadline)) {
+                wake_deadline = game_deadline;
             }
         }
+        int watch_fd = -1;
+        if (app.netplay && app.netplay->connected) {
+            watch_fd = app.netplay->fd;
+        } else if (app.simulation) {
+            watch_fd = get_simulation_wake_fd(app.simulation);
+        }
+        bool collected;
+        {
+            TRACE_SCOPE("collect_input_batch");
+            double poll_begin = perf_hud_begin(&app.perf_hud);
+            collected = collect_input_batch(&batch, last_present_time, wake_deadline, watch_fd);
+            perf_hud_end(&app.perf_hud, PERF_PHASE_POLL, poll_begin);
+        }
+        if (!collected) {
+            init_input_batch(&batch);
+        }
+        if (recorder) {
+            record_replay_frame(recorder, frame_time, get_monotonic_time(), &batch);
+        }
+        pending_input_arrival = batch.first_arrival_time;
+        {
+            TRACE_SCOPE("apply_input_batch");
+            lock_terminal();
+            apply_input_batch(&app, &batch);
+            unlock_terminal();
+        }
         
-        // Process AI turn if needed
-        if (app.current_state == STATE_PLAYING && app.game_mode == MODE_SINGLE_PLAYER) {
-            if (app.game.current_player == app.ai_player && app.game.game_active && !app.ai_thinking) {
-                trigger_ai_move(&app);
-            }
-            
-            if (app.ai_thinking) {
-                process_ai_turn(&app);
+        // Peer moves; leaving the match for the menu ends a networked game
+        if (app.netplay) {
+            netplay_poll(&app);
+            if (app.current_state == STATE_MAIN_MENU) {
+                app.current_state = STATE_QUIT;
             }
         }
+        
+        // Process AI turn if needed
+        process_pending_ai_turn(&app);
+        
+        // Log what this frame changed before anything else can go wrong
+        sync_session_journal(&journal, &app);
+        perf_hud_end_frame(&app.perf_hud);
     }
     
-    tb_shutdown();
+    stop_input_thread();
+    stop_simulation_thread(app.simulation);
+    app.simulation = NULL;
+    close_terminal_session(&app, &journal, recorder, spectators, cast);
     return 0;
-}
\ No newline at end of file
+}
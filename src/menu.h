@@ -5,17 +5,15 @@
 
 #include "../lib/termbox2/termbox2.h"
 
-// Menu functions
+// Menu functions; key handling lives in input.cpp
 void init_application(ApplicationState* app);
-void handle_menu_input(ApplicationState* app, const struct tb_event* event);
-void handle_mode_selection_input(ApplicationState* app, const struct tb_event* event);
-void handle_difficulty_selection_input(ApplicationState* app, const struct tb_event* event);
-void handle_game_input(ApplicationState* app, const struct tb_event* event);
-void handle_game_over_input(ApplicationState* app, const struct tb_event* event);
 void start_single_player_game(ApplicationState* app);
 
-// New architecture integration functions
-void handle_game_selection_input(ApplicationState* app, const struct tb_event* event);
+// Tic-tac-toe's mode selection, after dropping any game from the game list
+void open_board_game_setup(ApplicationState* app);
+
+// Starts the game at app->game_selection; on failure stays on the game
+// list with app->game_selection_error set
 void setup_game_from_selection(ApplicationState* app);
 
 #endif
\ No newline at end of file
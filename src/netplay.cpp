@@ -0,0 +1,306 @@
+#include "netplay.h"
+#include "timing.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Weight of the newest sample in the round-trip average
+#define NETPLAY_RTT_SMOOTHING 0.2
+
+static void init_netplay_session(NetplaySession* session, int fd, bool is_host) {
+    memset(session, 0, sizeof(*session));
+    session->fd = fd;
+    session->is_host = is_host;
+    session->connected = true;
+    session->local_player = is_host ? CELL_X : CELL_O;
+    session->next_sequence = 1;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+bool netplay_host(NetplaySession* session, int port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) return false;
+
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listen_fd, 1) != 0) {
+        perror("netplay");
+        close(listen_fd);
+        return false;
+    }
+
+    printf("Waiting for an opponent on port %d...\n", port);
+    fflush(stdout);
+
+    int fd = accept(listen_fd, NULL, NULL);
+    close(listen_fd);
+    if (fd < 0) {
+        perror("netplay");
+        return false;
+    }
+
+    init_netplay_session(session, fd, true);
+    return true;
+}
+
+bool netplay_join(NetplaySession* session, const char* host, int port) {
+    char port_text[16];
+    snprintf(port_text, sizeof(port_text), "%d", port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* results = NULL;
+    if (getaddrinfo(host, port_text, &hints, &results) != 0) {
+        fprintf(stderr, "netplay: cannot resolve %s\n", host);
+        return false;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* info = results; info; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, info->ai_addr, info->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(results);
+
+    if (fd < 0) {
+        fprintf(stderr, "netplay: cannot connect to %s:%d\n", host, port);
+        return false;
+    }
+
+    init_netplay_session(session, fd, false);
+    return true;
+}
+
+static uint32_t get_timestamp_us(void) {
+    return (uint32_t)(uint64_t)(get_monotonic_time() * 1e6);
+}
+
+static void send_frame(NetplaySession* session, uint8_t type, uint8_t cell, uint16_t sequence, uint32_t timestamp) {
+    if (!session->connected) return;
+
+    unsigned char frame[NETPLAY_FRAME_SIZE];
+    frame[0] = type;
+    frame[1] = cell;
+    frame[2] = (unsigned char)(sequence & 0xff);
+    frame[3] = (unsigned char)(sequence >> 8);
+    frame[4] = (unsigned char)(timestamp & 0xff);
+    frame[5] = (unsigned char)((timestamp >> 8) & 0xff);
+    frame[6] = (unsigned char)((timestamp >> 16) & 0xff);
+    frame[7] = (unsigned char)((timestamp >> 24) & 0xff);
+    frame[8] = (unsigned char)(session->reset_epoch & 0xff);
+    frame[9] = (unsigned char)(session->reset_epoch >> 8);
+
+    // Frames are tiny, so a full socket buffer means the peer is gone
+    if (send(session->fd, frame, sizeof(frame), MSG_NOSIGNAL) != (ssize_t)sizeof(frame)) {
+        session->connected = false;
+    }
+}
+
+void netplay_close(NetplaySession* session) {
+    if (session->fd < 0) return;
+
+    send_frame(session, NETPLAY_BYE, 0, 0, 0);
+    close(session->fd);
+    session->fd = -1;
+    session->connected = false;
+}
+
+void start_netplay_game(ApplicationState* app, NetplaySession* session) {
+    app->netplay = session;
+    app->game_mode = MODE_TWO_PLAYER;
+    reset_board(&app->game);
+    app->game.game_active = true;
+    app->current_state = STATE_PLAYING;
+    app->has_active_game = true;
+    app->winner = CELL_EMPTY;
+    app->is_draw = false;
+}
+
+void netplay_send_move(NetplaySession* session, const GameState* before, int cell, double input_time) {
+    session->has_pending_move = true;
+    session->pending_sequence = session->next_sequence++;
+    session->pending_rollback = *before;
+    session->last_local_apply = get_monotonic_time() - input_time;
+    session->moves_sent++;
+
+    send_frame(session, NETPLAY_MOVE, (uint8_t)cell, session->pending_sequence, get_timestamp_us());
+}
+
+void netplay_send_reset(NetplaySession* session) {
+    session->has_pending_move = false;
+    session->reset_epoch++;
+    send_frame(session, NETPLAY_RESET, 0, 0, get_timestamp_us());
+}
+
+// Keeps the app's game-over state in line with the board
+static void sync_game_result(ApplicationState* app) {
+    if (!app->game.game_active) {
+        app->winner = check_winner(&app->game);
+        app->is_draw = (app->winner == CELL_EMPTY);
+        app->current_state = STATE_GAME_OVER;
+    } else {
+        app->winner = CELL_EMPTY;
+        app->is_draw = false;
+        app->current_state = STATE_PLAYING;
+    }
+}
+
+static void roll_back_pending_move(ApplicationState* app) {
+    NetplaySession* session = app->netplay;
+    app->game = session->pending_rollback;
+    session->has_pending_move = false;
+    session->moves_rolled_back++;
+    sync_game_result(app);
+}
+
+static void record_round_trip(NetplaySession* session, uint32_t echoed_timestamp) {
+    double round_trip = (double)(uint32_t)(get_timestamp_us() - echoed_timestamp) / 1e6;
+    session->last_round_trip = round_trip;
+    session->average_round_trip = (session->average_round_trip == 0.0)
+        ? round_trip
+        : session->average_round_trip + NETPLAY_RTT_SMOOTHING * (round_trip - session->average_round_trip);
+}
+
+static void handle_peer_move(ApplicationState* app, int cell, uint16_t sequence, uint32_t timestamp, double read_time) {
+    NetplaySession* session = app->netplay;
+    CellState peer_player = (session->local_player == CELL_X) ? CELL_O : CELL_X;
+
+    // Both sides moved at once: the host's move stands
+    if (session->has_pending_move) {
+        if (session->is_host) {
+            send_frame(session, NETPLAY_NACK, (uint8_t)cell, sequence, timestamp);
+            return;
+        }
+        roll_back_pending_move(app);
+    }
+
+    int x = cell % 3;
+    int y = cell / 3;
+    if (cell < 0 || cell > 8 || app->game.current_player != peer_player ||
+        !app->game.game_active || !make_move(&app->game, x, y)) {
+        send_frame(session, NETPLAY_NACK, (uint8_t)cell, sequence, timestamp);
+        return;
+    }
+
+    sync_game_result(app);
+    session->last_remote_apply = get_monotonic_time() - read_time;
+    send_frame(session, NETPLAY_ACK, (uint8_t)cell, sequence, timestamp);
+}
+
+static void handle_frame(ApplicationState* app, const unsigned char* frame, double read_time) {
+    NetplaySession* session = app->netplay;
+    uint8_t type = frame[0];
+    uint8_t cell = frame[1];
+    uint16_t sequence = (uint16_t)(frame[2] | (frame[3] << 8));
+    uint32_t timestamp = (uint32_t)frame[4] | ((uint32_t)frame[5] << 8) |
+                         ((uint32_t)frame[6] << 16) | ((uint32_t)frame[7] << 24);
+    uint16_t epoch = (uint16_t)(frame[8] | (frame[9] << 8));
+    int16_t epoch_delta = (int16_t)(uint16_t)(epoch - session->reset_epoch);
+
+    switch (type) {
+        case NETPLAY_MOVE:
+            // Made before our last reset; the sender drops it when our
+            // RESET arrives, so it gets neither ACK nor NACK
+            if (epoch_delta < 0) break;
+            handle_peer_move(app, cell, sequence, timestamp, read_time);
+            break;
+
+        case NETPLAY_ACK:
+            record_round_trip(session, timestamp);
+            if (session->has_pending_move && sequence == session->pending_sequence) {
+                session->has_pending_move = false;
+            }
+            break;
+
+        case NETPLAY_NACK:
+            record_round_trip(session, timestamp);
+            if (session->has_pending_move && sequence == session->pending_sequence) {
+                roll_back_pending_move(app);
+            }
+            break;
+
+        case NETPLAY_RESET:
+            // Both sides reset at once: each already has a fresh board,
+            // and any move made on it since must stand
+            if (epoch_delta <= 0) break;
+            session->reset_epoch = epoch;
+            session->has_pending_move = false;
+            reset_board(&app->game);
+            app->game.game_active = true;
+            sync_game_result(app);
+            break;
+
+        case NETPLAY_BYE:
+            session->connected = false;
+            break;
+    }
+}
+
+void netplay_poll(ApplicationState* app) {
+    NetplaySession* session = app->netplay;
+    if (!session || !session->connected) return;
+
+    for (;;) {
+        ssize_t result = read(session->fd, session->in + session->in_length,
+                              sizeof(session->in) - session->in_length);
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (result <= 0) {
+            session->connected = false;
+            return;
+        }
+
+        double read_time = get_monotonic_time();
+        session->in_length += (size_t)result;
+
+        size_t offset = 0;
+        while (session->in_length - offset >= NETPLAY_FRAME_SIZE) {
+            handle_frame(app, session->in + offset, read_time);
+            offset += NETPLAY_FRAME_SIZE;
+        }
+        memmove(session->in, session->in + offset, session->in_length - offset);
+        session->in_length -= offset;
+    }
+}
+
+void format_netplay_status(const NetplaySession* session, const GameState* game, char* buffer, size_t size) {
+    const char* side = (session->local_player == CELL_X) ? "X" : "O";
+
+    if (!session->connected) {
+        snprintf(buffer, size, "Online as %s | opponent disconnected", side);
+        return;
+    }
+
+    const char* turn = !game->game_active ? "game over"
+                     : (game->current_player == session->local_player) ? "your turn" : "their turn";
+
+    snprintf(buffer, size,
+             "Online as %s | %s%s | RTT %.1f ms (avg %.1f) | apply: own %.0f us, peer %.0f us | rollbacks %lu",
+             side, turn, session->has_pending_move ? " (unconfirmed)" : "",
+             session->last_round_trip * 1e3, session->average_round_trip * 1e3,
+             session->last_local_apply * 1e6, session->last_remote_apply * 1e6,
+             session->moves_rolled_back);
+}
@@ -0,0 +1,67 @@
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include "game.h"
+#include <stdint.h>
+
+// Wire format: fixed 10-byte frames, integers little-endian.
+//   u8  type        NETPLAY_*
+//   u8  cell        row * 3 + col (NETPLAY_MOVE)
+//   u16 sequence    move number; echoed by ACK/NACK
+//   u32 timestamp   sender clock in microseconds; echoed by ACK/NACK
+//   u16 epoch       resets the sender has made or seen
+// Only moves travel; each side keeps its own copy of the board. A MOVE
+// from an older epoch was made on a board the receiver has since reset.
+#define NETPLAY_FRAME_SIZE 10
+
+#define NETPLAY_MOVE 1
+#define NETPLAY_ACK 2
+#define NETPLAY_NACK 3     // Move rejected; the sender rolls it back
+#define NETPLAY_RESET 4
+#define NETPLAY_BYE 5
+
+typedef struct NetplaySession {
+    int fd;
+    bool is_host;            // Host plays X and wins move conflicts
+    bool connected;
+    CellState local_player;
+
+    // Local move applied ahead of the peer's acknowledgement
+    bool has_pending_move;
+    uint16_t pending_sequence;
+    GameState pending_rollback;   // Board before the predicted move
+    uint16_t next_sequence;
+    uint16_t reset_epoch;
+
+    unsigned char in[256];
+    size_t in_length;
+
+    // Latency stats shown in the HUD
+    double last_round_trip;        // Seconds, from the last ACK/NACK
+    double average_round_trip;     // Exponential moving average
+    double last_local_apply;       // Input to board update for own move
+    double last_remote_apply;      // Frame read to board update for peer move
+    unsigned long moves_sent;
+    unsigned long moves_rolled_back;
+} NetplaySession;
+
+// Connection setup (blocking, before the terminal is initialized)
+bool netplay_host(NetplaySession* session, int port);
+bool netplay_join(NetplaySession* session, const char* host, int port);
+void netplay_close(NetplaySession* session);
+
+// Starts a two-player match with the session attached to the app
+void start_netplay_game(ApplicationState* app, NetplaySession* session);
+
+// Local actions: the move is already on the board, before is the
+// board it was made on
+void netplay_send_move(NetplaySession* session, const GameState* before, int cell, double input_time);
+void netplay_send_reset(NetplaySession* session);
+
+// Reads and applies every frame the peer has sent; never blocks
+void netplay_poll(ApplicationState* app);
+
+// One-line connection and latency summary
+void format_netplay_status(const NetplaySession* session, const GameState* game, char* buffer, size_t size);
+
+#endif
@@ -0,0 +1,88 @@
+#include "perf_hud.h"
+#include "timing.h"
+#include <string.h>
+
+static const char* const perf_phase_names[PERF_PHASE_COUNT] = {
+    "poll",
+    "hover",
+    "update",
+    "render",
+    "present"
+};
+
+const char* get_perf_phase_name(PerfPhase phase) {
+    return perf_phase_names[phase];
+}
+
+void init_perf_hud(PerfHud* hud) {
+    memset(hud, 0, sizeof(*hud));
+}
+
+void toggle_perf_hud(PerfHud* hud) {
+    bool visible = !hud->visible;
+
+    // Start from a clean slate so stale frames do not skew the first view
+    init_perf_hud(hud);
+    hud->visible = visible;
+}
+
+// The real clock even during replay, since the HUD measures this process
+double perf_hud_begin(const PerfHud* hud) {
+    return hud->visible ? get_system_monotonic_time() : 0.0;
+}
+
+void perf_hud_end(PerfHud* hud, PerfPhase phase, double begin) {
+    if (begin > 0.0) {
+        hud->phase_time[phase] = get_system_monotonic_time() - begin;
+    }
+}
+
+void perf_hud_record_ai_search(PerfHud* hud, double begin) {
+    if (begin > 0.0) {
+        perf_hud_record_ai_search_time(hud, get_system_monotonic_time() - begin);
+    }
+}
+
+void perf_hud_record_ai_search_time(PerfHud* hud, double seconds) {
+    if (!hud->visible) return;
+
+    hud->last_ai_search = seconds;
+    hud->ai_this_frame = true;
+    hud->frames_since_ai = 0;
+}
+
+// arrival_time is on the real clock; 0 means no input was applied
+void perf_hud_record_input_latency(PerfHud* hud, double arrival_time) {
+    if (!hud->visible || arrival_time <= 0.0) return;
+
+    hud->input_latency = get_system_monotonic_time() - arrival_time;
+    if (hud->input_latency > hud->input_latency_peak) {
+        hud->input_latency_peak = hud->input_latency;
+    }
+}
+
+void perf_hud_end_frame(PerfHud* hud) {
+    if (!hud->visible) return;
+
+    double now = get_system_monotonic_time();
+    if (hud->last_frame_end > 0.0 && now > hud->last_frame_end) {
+        hud->fps = 1.0 / (now - hud->last_frame_end);
+        hud->average_fps = (hud->average_fps == 0.0)
+            ? hud->fps
+            : hud->average_fps + PERF_HUD_SMOOTHING * (hud->fps - hud->average_fps);
+    }
+    hud->last_frame_end = now;
+
+    double busy = 0.0;
+    for (int i = PERF_PHASE_POLL + 1; i < PERF_PHASE_COUNT; i++) {
+        busy += hud->phase_time[i];
+    }
+
+    hud->busy_history[hud->history_next] = (float)busy;
+    hud->ai_history[hud->history_next] = hud->ai_this_frame;
+    hud->history_next = (hud->history_next + 1) % PERF_HUD_HISTORY;
+    if (hud->history_count < PERF_HUD_HISTORY) hud->history_count++;
+
+    if (!hud->ai_this_frame) hud->frames_since_ai++;
+    hud->ai_this_frame = false;
+}
@@ -0,0 +1,62 @@
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <stdbool.h>
+
+// Frames kept for the sparkline; all HUD storage is fixed-size
+#define PERF_HUD_HISTORY 32
+
+// Weight of the newest frame in the FPS average
+#define PERF_HUD_SMOOTHING 0.05
+
+typedef enum {
+    PERF_PHASE_POLL,       // Waiting for and reading input
+    PERF_PHASE_HOVER,
+    PERF_PHASE_UPDATE,
+    PERF_PHASE_RENDER,
+    PERF_PHASE_PRESENT,
+    PERF_PHASE_COUNT
+} PerfPhase;
+
+typedef struct {
+    bool visible;
+
+    double phase_time[PERF_PHASE_COUNT];   // Seconds, latest frame
+    double last_frame_end;
+    double fps;
+    double average_fps;
+
+    // Busy time (every phase but the poll) per frame, oldest first from
+    // history_next, and whether that frame ran an AI search
+    float busy_history[PERF_HUD_HISTORY];
+    bool ai_history[PERF_HUD_HISTORY];
+    int history_next;
+    int history_count;
+
+    bool ai_this_frame;
+    double last_ai_search;                 // Seconds
+    unsigned long frames_since_ai;
+
+    // From an event's arrival to the present of the first frame showing it
+    double input_latency;                  // Seconds, latest input
+    double input_latency_peak;             // Seconds, since the HUD was shown
+} PerfHud;
+
+void init_perf_hud(PerfHud* hud);
+void toggle_perf_hud(PerfHud* hud);
+
+// Phase timing. While the HUD is hidden perf_hud_begin returns 0 and
+// nothing reads the clock.
+double perf_hud_begin(const PerfHud* hud);
+void perf_hud_end(PerfHud* hud, PerfPhase phase, double begin);
+void perf_hud_record_ai_search(PerfHud* hud, double begin);
+
+// A search timed elsewhere (the simulation thread), credited to the frame
+// that plays its move
+void perf_hud_record_ai_search_time(PerfHud* hud, double seconds);
+void perf_hud_record_input_latency(PerfHud* hud, double arrival_time);
+void perf_hud_end_frame(PerfHud* hud);
+
+const char* get_perf_phase_name(PerfPhase phase);
+
+#endif
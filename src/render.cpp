@@ -1,56 +1,58 @@
 #include "render.h"
+#include "render_target.h"
+#include "sprite.h"
+#include "netplay.h"
+#include "trace.h"
+#include "games/tictactoe.h"
 #include "../lib/termbox2/termbox2.h"
 
 void clear_screen() {
-    tb_clear();
+    render_target_clear();
 }
 
 void present_screen() {
-    tb_present();
+    TRACE_SCOPE("present_screen");
+    render_target_present();
 }
 
 void render_main_menu(const ApplicationState* app) {
+    TRACE_SCOPE("render_main_menu");
     int y = 5;
-    int x_center = tb_width() / 2;
+    int x_center = render_target_width() / 2;
     
     // Title
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "TIC-TAC-TOE GAME");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "================");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "TIC-TAC-TOE GAME");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "================");
     y += 2;
     
     // Menu options
     const char* new_game_prefix = (app->menu_selection == 0) ? " > " : "   ";
-    tb_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[N] New Game", new_game_prefix);
+    render_target_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[N] New Game", new_game_prefix);
     
     if (app->has_active_game) {
         const char* continue_prefix = (app->menu_selection == 1) ? " > " : "   ";
-        tb_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[C] Continue", continue_prefix);
+        render_target_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[C] Continue", continue_prefix);
         
         const char* quit_prefix = (app->menu_selection == 2) ? " > " : "   ";
-        tb_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[Q] Quit", quit_prefix);
+        render_target_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[Q] Quit", quit_prefix);
     } else {
         const char* quit_prefix = (app->menu_selection == 1) ? " > " : "   ";
-        tb_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[Q] Quit", quit_prefix);
+        render_target_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "%s[Q] Quit", quit_prefix);
     }
     
     y += 3;
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓ or W/S - Navigate");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓ or W/S - Navigate");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
 }
 
 void render_game_board(const GameState* game) {
-    int start_x = tb_width() / 2 - 6;
+    TRACE_SCOPE("render_game_board");
+    int start_x = render_target_width() / 2 - 6;
     int start_y = 8;
     
     // Draw board frame
-    tb_printf(start_x, start_y, TB_DEFAULT, TB_DEFAULT, "┌───┬───┬───┐");
-    tb_printf(start_x, start_y + 1, TB_DEFAULT, TB_DEFAULT, "│   │   │   │");
-    tb_printf(start_x, start_y + 2, TB_DEFAULT, TB_DEFAULT, "├───┼───┼───┤");
-    tb_printf(start_x, start_y + 3, TB_DEFAULT, TB_DEFAULT, "│   │   │   │");
-    tb_printf(start_x, start_y + 4, TB_DEFAULT, TB_DEFAULT, "├───┼───┼───┤");
-    tb_printf(start_x, start_y + 5, TB_DEFAULT, TB_DEFAULT, "│   │   │   │");
-    tb_printf(start_x, start_y + 6, TB_DEFAULT, TB_DEFAULT, "└───┴───┴───┘");
+    blit_sprite(tictactoe_get_board_frame(), start_x, start_y);
     
     // Draw game pieces and cursor
     for (int row = 0; row < 3; row++) {
@@ -67,67 +69,100 @@ void render_game_board(const GameState* game) {
             
             // Highlight cursor position
             if (game->cursor_x == col && game->cursor_y == row) {
-                tb_set_cell(cell_x - 1, cell_y, '[', TB_WHITE | TB_BOLD, TB_DEFAULT);
-                tb_set_cell(cell_x, cell_y, symbol, TB_WHITE | TB_BOLD, TB_DEFAULT);
-                tb_set_cell(cell_x + 1, cell_y, ']', TB_WHITE | TB_BOLD, TB_DEFAULT);
+                render_target_set_cell(cell_x - 1, cell_y, '[', TB_WHITE | TB_BOLD, TB_DEFAULT);
+                render_target_set_cell(cell_x, cell_y, symbol, TB_WHITE | TB_BOLD, TB_DEFAULT);
+                render_target_set_cell(cell_x + 1, cell_y, ']', TB_WHITE | TB_BOLD, TB_DEFAULT);
             } else {
-                tb_set_cell(cell_x, cell_y, symbol, TB_DEFAULT, TB_DEFAULT);
+                render_target_set_cell(cell_x, cell_y, symbol, TB_DEFAULT, TB_DEFAULT);
             }
         }
     }
 }
 
 void render_game_ui(const GameState* game) {
-    int x_center = tb_width() / 2;
+    TRACE_SCOPE("render_game_ui");
+    int x_center = render_target_width() / 2;
     
     // Current player
+    static CachedText player_text;
     const char* player = (game->current_player == CELL_X) ? "X" : "O";
-    tb_printf(x_center - 8, 5, TB_DEFAULT, TB_DEFAULT, "Current Player: %s", player);
+    blit_sprite(update_cached_text(&player_text, game->current_player, "Current Player: %s", player), x_center - 8, 5);
 }
 
 void render_game_over(const ApplicationState* app) {
-    int x_center = tb_width() / 2;
+    TRACE_SCOPE("render_game_over");
+    int x_center = render_target_width() / 2;
     int y = 16;
     
-    tb_printf(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "GAME OVER");
-    tb_printf(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "=========");
+    render_target_printf(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "GAME OVER");
+    render_target_printf(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "=========");
     y++;
     
     if (app->is_draw) {
-        tb_printf(x_center - 4, y++, TB_DEFAULT, TB_DEFAULT, "It's a Draw!");
+        render_target_printf(x_center - 4, y++, TB_DEFAULT, TB_DEFAULT, "It's a Draw!");
     } else {
         const char* winner = (app->winner == CELL_X) ? "X" : "O";
-        tb_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "Player %s Wins!", winner);
+        render_target_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "Player %s Wins!", winner);
     }
     
     y += 2;
-    tb_printf(x_center - 7, y++, TB_DEFAULT, TB_DEFAULT, "[R] Restart Game");
-    tb_printf(x_center - 7, y++, TB_DEFAULT, TB_DEFAULT, "[M] Main Menu");
-    tb_printf(x_center - 7, y++, TB_DEFAULT, TB_DEFAULT, "[Q] Quit");
+    render_target_printf(x_center - 7, y++, TB_DEFAULT, TB_DEFAULT, "[R] Restart Game");
+    render_target_printf(x_center - 7, y++, TB_DEFAULT, TB_DEFAULT, "[M] Main Menu");
+    render_target_printf(x_center - 7, y++, TB_DEFAULT, TB_DEFAULT, "[Q] Quit");
 }
 
 void render_controls(AppState state) {
-    int y = tb_height() - 4;
+    TRACE_SCOPE("render_controls");
+    int y = render_target_height() - 4;
     int x = 2;
     
-    tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
     
     if (state == STATE_PLAYING) {
-        tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
-        tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Place mark  [R] Restart  [M] Menu  [Q] Quit");
+        blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+        blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Place  [U/Y] Undo/Redo  [H] Hints  [R] Restart  [M] Menu  [Q] Quit");
     } else if (state == STATE_MAIN_MENU) {
-        tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
-        tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+        blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+        blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
     } else if (state == STATE_GAME_OVER) {
-        tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
-        tb_printf(x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select  [R] Restart  [M] Main Menu  [Q] Quit");
+        blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+        blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select  [U] Undo  [R] Restart  [M] Main Menu  [Q] Quit");
+    }
+}
+
+// Games from the game list take the movement keys themselves
+static void render_loaded_game_controls() {
+    int y = render_target_height() - 4;
+    int x = 2;
+    
+    blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Play");
+    blit_static_text(x, y++, TB_DEFAULT, TB_DEFAULT, "[R] Restart  [M] Menu  [Q] Quit");
+}
+
+// Draws every widget of a kind at its layout position, highlighting the hovered one
+static void render_widget_labels(const Layout* layout, WidgetKind kind, int hovered_index) {
+    for (int i = 0; i < layout->widget_count; i++) {
+        const Widget* widget = &layout->widgets[i];
+        if (widget->kind != kind || !widget->label) continue;
+        
+        uintattr_t bg = (widget->index == hovered_index) ? TB_CYAN : TB_DEFAULT;
+        uintattr_t fg = (widget->index == hovered_index) ? TB_BLACK : TB_DEFAULT;
+        blit_static_text(widget->x, widget->y, fg, bg, widget->label);
     }
 }
 
 void render_global_cursor(const ApplicationState* app) {
+    TRACE_SCOPE("render_global_cursor");
     // Get the current character at cursor position
-    struct tb_cell* buffer = tb_cell_buffer();
-    int width = tb_width();
+    struct tb_cell* buffer = render_target_cells();
+    int width = render_target_width();
+    
+    if (app->cursor.screen_x < 0 || app->cursor.screen_x >= width ||
+        app->cursor.screen_y < 0 || app->cursor.screen_y >= render_target_height()) {
+        return;
+    }
+    
     int cursor_pos = app->cursor.screen_y * width + app->cursor.screen_x;
     
     // Get current cell content
@@ -136,61 +171,87 @@ void render_global_cursor(const ApplicationState* app) {
     // Render cursor with inverted colors (Stone Story RPG style)
     // White background, black foreground to invert whatever is there
     char symbol = (current_cell.ch != 0) ? (char)current_cell.ch : ' ';
-    tb_set_cell(app->cursor.screen_x, app->cursor.screen_y, symbol, TB_BLACK, TB_WHITE);
+    render_target_set_cell(app->cursor.screen_x, app->cursor.screen_y, symbol, TB_BLACK, TB_WHITE);
 }
 
 void render_main_menu_with_hover(const ApplicationState* app) {
-    int y = 5;
-    int x_center = tb_width() / 2;
+    TRACE_SCOPE("render_main_menu_with_hover");
+    const Layout* layout = &app->layout;
+    int y = layout->title_y;
     
     // Title
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "TIC-TAC-TOE GAME");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "================");
-    y += 2;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "TIC-TAC-TOE GAME");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "================");
     
     // Menu options with hover highlighting
-    uintattr_t new_game_bg = (app->cursor.hovered_menu_item == 0) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t new_game_fg = (app->cursor.hovered_menu_item == 0) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 6, y++, new_game_fg, new_game_bg, "[N] New Game");
+    render_widget_labels(layout, WIDGET_MENU_ITEM, app->cursor.hovered_menu_item);
     
-    if (app->has_active_game) {
-        uintattr_t continue_bg = (app->cursor.hovered_menu_item == 1) ? TB_CYAN : TB_DEFAULT;
-        uintattr_t continue_fg = (app->cursor.hovered_menu_item == 1) ? TB_BLACK : TB_DEFAULT;
-        tb_printf(x_center - 6, y++, continue_fg, continue_bg, "[C] Continue");
-        
-        uintattr_t quit_bg = (app->cursor.hovered_menu_item == 2) ? TB_CYAN : TB_DEFAULT;
-        uintattr_t quit_fg = (app->cursor.hovered_menu_item == 2) ? TB_BLACK : TB_DEFAULT;
-        tb_printf(x_center - 6, y++, quit_fg, quit_bg, "[Q] Quit");
-    } else {
-        uintattr_t quit_bg = (app->cursor.hovered_menu_item == 1) ? TB_CYAN : TB_DEFAULT;
-        uintattr_t quit_fg = (app->cursor.hovered_menu_item == 1) ? TB_BLACK : TB_DEFAULT;
-        tb_printf(x_center - 6, y++, quit_fg, quit_bg, "[Q] Quit");
+    y = layout->footer_y + 3;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+}
+
+void render_game_selection_with_hover(const ApplicationState* app) {
+    TRACE_SCOPE("render_game_selection_with_hover");
+    const Layout* layout = &app->layout;
+    int y = layout->title_y;
+    
+    // Title
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "SELECT GAME");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "===========");
+    
+    // Game options with hover highlighting
+    render_widget_labels(layout, WIDGET_GAME_OPTION, app->cursor.hovered_game_selection);
+    
+    // Why the last pick did not start
+    y = layout->footer_y + 1;
+    if (app->game_selection_error) {
+        render_target_print(layout->title_x, y, TB_RED | TB_BOLD, TB_DEFAULT, app->game_selection_error);
     }
     
-    y += 3;
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+    y += 2;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+}
+
+// Win green, draw blue, loss red; bright when the result is at most two
+// plies away. The digit is the plies left (for a draw, until the board fills).
+static void render_cell_hint(int8_t value, int empty_cells, char* symbol, uintattr_t* fg, uintattr_t* bg) {
+    if (value == HINT_NONE) return;
+    
+    static const uintattr_t outcome_colors[] = {TB_RED, TB_BLUE, TB_GREEN};
+    HintOutcome outcome = get_hint_outcome(value);
+    int distance = (outcome == HINT_OUTCOME_DRAW) ? empty_cells : get_hint_distance(value);
+    
+    *symbol = (char)('0' + distance);
+    *fg = TB_BLACK;
+    *bg = outcome_colors[outcome] | (distance <= 2 ? TB_BRIGHT : 0);
 }
 
 void render_game_board_with_hover(const ApplicationState* app) {
-    int start_x = tb_width() / 2 - 6;
-    int start_y = 8;
+    TRACE_SCOPE("render_game_board_with_hover");
+    int start_x = app->layout.board_x;
+    int start_y = app->layout.board_y;
     
     // Draw board frame
-    tb_printf(start_x, start_y, TB_DEFAULT, TB_DEFAULT, "┌───┬───┬───┐");
-    tb_printf(start_x, start_y + 1, TB_DEFAULT, TB_DEFAULT, "│   │   │   │");
-    tb_printf(start_x, start_y + 2, TB_DEFAULT, TB_DEFAULT, "├───┼───┼───┤");
-    tb_printf(start_x, start_y + 3, TB_DEFAULT, TB_DEFAULT, "│   │   │   │");
-    tb_printf(start_x, start_y + 4, TB_DEFAULT, TB_DEFAULT, "├───┼───┼───┤");
-    tb_printf(start_x, start_y + 5, TB_DEFAULT, TB_DEFAULT, "│   │   │   │");
-    tb_printf(start_x, start_y + 6, TB_DEFAULT, TB_DEFAULT, "└───┴───┴───┘");
+    blit_sprite(tictactoe_get_board_frame(), start_x, start_y);
+    
+    // Hints are for the human, and only for values of the board on screen
+    const MoveHints* hints = &app->move_hints;
+    bool show_hints = hints->visible && app->current_state == STATE_PLAYING && app->game.game_active &&
+                      !(app->game_mode == MODE_SINGLE_PLAYER && app->game.current_player == app->ai_player);
+    int empty_cells = 0;
+    for (int i = 0; i < 9; i++) {
+        if (app->game.board[i / 3][i % 3] == CELL_EMPTY) empty_cells++;
+    }
     
     // Draw game pieces with hover highlighting
     for (int row = 0; row < 3; row++) {
         for (int col = 0; col < 3; col++) {
-            int cell_x = start_x + 2 + col * 4;
-            int cell_y = start_y + 1 + row * 2;
+            int cell_x, cell_y;
+            tictactoe_get_cell_center(start_x, start_y, col, row, &cell_x, &cell_y);
             
             char symbol = ' ';
             if (app->game.board[row][col] == CELL_X) {
@@ -203,203 +264,201 @@ void render_game_board_with_hover(const ApplicationState* app) {
             uintattr_t bg = TB_DEFAULT;
             uintattr_t fg = TB_DEFAULT;
             
+            int cell_index = row * 3 + col;
             if (app->cursor.hovered_game_cell_x == col && app->cursor.hovered_game_cell_y == row) {
                 bg = TB_YELLOW;
                 fg = TB_BLACK;
+            } else if (show_hints && symbol == ' ') {
+                render_cell_hint(app->move_hints.values[cell_index], empty_cells, &symbol, &fg, &bg);
+            } else if (symbol != ' ') {
+                // Fresh marks: the AI's blinks, the player's is briefly bold
+                if (animation_target(&app->animations, ANIMATION_AI_MOVE_FLASH) == cell_index &&
+                    animation_step(&app->animations, ANIMATION_AI_MOVE_FLASH) % 2 == 0) {
+                    fg = TB_BLACK;
+                    bg = TB_GREEN;
+                } else if (animation_target(&app->animations, ANIMATION_MOVE_HIGHLIGHT) == cell_index) {
+                    fg = TB_BLUE | TB_BOLD;
+                }
             }
             
-            tb_set_cell(cell_x, cell_y, symbol, fg, bg);
+            render_target_set_cell(cell_x, cell_y, symbol, fg, bg);
         }
     }
 }
 
 void render_game_over_with_hover(const ApplicationState* app) {
-    int x_center = tb_width() / 2;
-    int y = 16;
+    TRACE_SCOPE("render_game_over_with_hover");
+    int x_center = render_target_width() / 2;
+    int y = app->layout.footer_y;
     
-    tb_printf(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "GAME OVER");
-    tb_printf(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "=========");
+    blit_static_text(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "GAME OVER");
+    blit_static_text(x_center - 5, y++, TB_DEFAULT, TB_DEFAULT, "=========");
     y++;
     
     if (app->is_draw) {
-        tb_printf(x_center - 4, y++, TB_DEFAULT, TB_DEFAULT, "It's a Draw!");
+        blit_static_text(x_center - 4, y++, TB_DEFAULT, TB_DEFAULT, "It's a Draw!");
     } else {
+        static CachedText winner_text;
         const char* winner = (app->winner == CELL_X) ? "X" : "O";
-        tb_printf(x_center - 6, y++, TB_DEFAULT, TB_DEFAULT, "Player %s Wins!", winner);
+        blit_sprite(update_cached_text(&winner_text, app->winner, "Player %s Wins!", winner), x_center - 6, y++);
     }
     
-    y += 2;
-    
     // Game over options with hover highlighting
-    uintattr_t restart_bg = (app->cursor.hovered_game_over_option && app->cursor.game_over_option_index == 0) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t restart_fg = (app->cursor.hovered_game_over_option && app->cursor.game_over_option_index == 0) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 7, y++, restart_fg, restart_bg, "[R] Restart Game");
-    
-    uintattr_t menu_bg = (app->cursor.hovered_game_over_option && app->cursor.game_over_option_index == 1) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t menu_fg = (app->cursor.hovered_game_over_option && app->cursor.game_over_option_index == 1) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 7, y++, menu_fg, menu_bg, "[M] Main Menu");
-    
-    uintattr_t quit_bg = (app->cursor.hovered_game_over_option && app->cursor.game_over_option_index == 2) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t quit_fg = (app->cursor.hovered_game_over_option && app->cursor.game_over_option_index == 2) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 7, y++, quit_fg, quit_bg, "[Q] Quit");
+    int hovered = app->cursor.hovered_game_over_option ? app->cursor.game_over_option_index : -1;
+    render_widget_labels(&app->layout, WIDGET_GAME_OVER_OPTION, hovered);
 }
 
 // Mode Selection Screen
 void render_mode_selection(const ApplicationState* app) {
+    TRACE_SCOPE("render_mode_selection");
     int y = 5;
-    int x_center = tb_width() / 2;
+    int x_center = render_target_width() / 2;
     
     // Title
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "SELECT GAME MODE");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "=================");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "SELECT GAME MODE");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "=================");
     y += 2;
     
     // Mode options
     const char* two_player_prefix = (app->mode_selection == 0) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[1] Two Player", two_player_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[1] Two Player", two_player_prefix);
     
     const char* single_player_prefix = (app->mode_selection == 1) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[2] Single Player (vs AI)", single_player_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[2] Single Player (vs AI)", single_player_prefix);
     
     const char* back_prefix = (app->mode_selection == 2) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[B] Back to Main Menu", back_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[B] Back to Main Menu", back_prefix);
     
     y += 3;
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓ or W/S - Navigate");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓ or W/S - Navigate");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
 }
 
 void render_mode_selection_with_hover(const ApplicationState* app) {
-    int y = 5;
-    int x_center = tb_width() / 2;
+    TRACE_SCOPE("render_mode_selection_with_hover");
+    const Layout* layout = &app->layout;
+    int y = layout->title_y;
     
     // Title
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "SELECT GAME MODE");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "=================");
-    y += 2;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "SELECT GAME MODE");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "=================");
     
     // Mode options with hover highlighting
-    uintattr_t two_player_bg = (app->cursor.hovered_mode_selection == 0) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t two_player_fg = (app->cursor.hovered_mode_selection == 0) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, two_player_fg, two_player_bg, "[1] Two Player");
-    
-    uintattr_t single_player_bg = (app->cursor.hovered_mode_selection == 1) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t single_player_fg = (app->cursor.hovered_mode_selection == 1) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, single_player_fg, single_player_bg, "[2] Single Player (vs AI)");
+    render_widget_labels(layout, WIDGET_MODE_OPTION, app->cursor.hovered_mode_selection);
     
-    uintattr_t back_bg = (app->cursor.hovered_mode_selection == 2) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t back_fg = (app->cursor.hovered_mode_selection == 2) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, back_fg, back_bg, "[B] Back to Main Menu");
-    
-    y += 3;
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+    y = layout->footer_y + 3;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
 }
 
 // Difficulty Selection Screen
 void render_difficulty_selection(const ApplicationState* app) {
+    TRACE_SCOPE("render_difficulty_selection");
     int y = 5;
-    int x_center = tb_width() / 2;
+    int x_center = render_target_width() / 2;
     
     // Title
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "SELECT DIFFICULTY");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "=================");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "SELECT DIFFICULTY");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "=================");
     y += 2;
     
     // Difficulty options
     const char* easy_prefix = (app->difficulty_selection == 0) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[1] Easy (AI makes mistakes)", easy_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[1] Easy (AI makes mistakes)", easy_prefix);
     
     const char* medium_prefix = (app->difficulty_selection == 1) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[2] Medium (Good AI)", medium_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[2] Medium (Good AI)", medium_prefix);
     
     const char* hard_prefix = (app->difficulty_selection == 2) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[3] Hard (Unbeatable AI)", hard_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[3] Hard (Unbeatable AI)", hard_prefix);
     
     const char* back_prefix = (app->difficulty_selection == 3) ? " > " : "   ";
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[B] Back to Mode Selection", back_prefix);
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "%s[B] Back to Mode Selection", back_prefix);
     
     y += 3;
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓ or W/S - Navigate");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓ or W/S - Navigate");
+    render_target_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
 }
 
 void render_difficulty_selection_with_hover(const ApplicationState* app) {
-    int y = 5;
-    int x_center = tb_width() / 2;
+    TRACE_SCOPE("render_difficulty_selection_with_hover");
+    const Layout* layout = &app->layout;
+    int y = layout->title_y;
     
     // Title
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "SELECT DIFFICULTY");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "=================");
-    y += 2;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "SELECT DIFFICULTY");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "=================");
     
     // Difficulty options with hover highlighting
-    uintattr_t easy_bg = (app->cursor.hovered_difficulty_selection == 0) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t easy_fg = (app->cursor.hovered_difficulty_selection == 0) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, easy_fg, easy_bg, "[1] Easy (AI makes mistakes)");
-    
-    uintattr_t medium_bg = (app->cursor.hovered_difficulty_selection == 1) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t medium_fg = (app->cursor.hovered_difficulty_selection == 1) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, medium_fg, medium_bg, "[2] Medium (Good AI)");
-    
-    uintattr_t hard_bg = (app->cursor.hovered_difficulty_selection == 2) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t hard_fg = (app->cursor.hovered_difficulty_selection == 2) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, hard_fg, hard_bg, "[3] Hard (Unbeatable AI)");
+    render_widget_labels(layout, WIDGET_DIFFICULTY_OPTION, app->cursor.hovered_difficulty_selection);
     
-    uintattr_t back_bg = (app->cursor.hovered_difficulty_selection == 3) ? TB_CYAN : TB_DEFAULT;
-    uintattr_t back_fg = (app->cursor.hovered_difficulty_selection == 3) ? TB_BLACK : TB_DEFAULT;
-    tb_printf(x_center - 8, y++, back_fg, back_bg, "[B] Back to Mode Selection");
-    
-    y += 3;
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
-    tb_printf(x_center - 8, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
+    y = layout->footer_y + 3;
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Controls:");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "↑↓←→ or WASD - Move cursor");
+    blit_static_text(layout->title_x, y++, TB_DEFAULT, TB_DEFAULT, "Enter - Select");
 }
 
 // AI Visual Feedback Functions
 void render_ai_thinking_animation(const ApplicationState* app) {
+    TRACE_SCOPE("render_ai_thinking_animation");
     if (!app->ai_thinking) return;
     
-    int x_center = tb_width() / 2;
+    int x_center = render_target_width() / 2;
     int y = 6;
     
-    // Simple thinking animation with dots
-    static int animation_frame = 0;
-    animation_frame = (animation_frame + 1) % 20; // Cycle every 20 frames
-    
-    const char* animation_states[] = {
+    // Simple thinking animation with dots, one state per timeline step
+    static const char* const animation_states[] = {
         "AI is thinking   ",
         "AI is thinking.  ",
         "AI is thinking.. ",
         "AI is thinking..."
     };
     
-    int state_index = animation_frame / 5; // Change state every 5 frames
-    tb_printf(x_center - 8, y, TB_YELLOW | TB_BOLD, TB_DEFAULT, "%s", animation_states[state_index]);
+    int state_index = animation_step(&app->animations, ANIMATION_AI_THINKING) % 4;
+    blit_static_text(x_center - 8, y, TB_YELLOW | TB_BOLD, TB_DEFAULT, animation_states[state_index]);
+}
+
+// Bottom-row connection and latency line for networked games
+void render_netplay_status(const ApplicationState* app) {
+    TRACE_SCOPE("render_netplay_status");
+    if (!app->netplay) return;
+    
+    char status[160];
+    format_netplay_status(app->netplay, &app->game, status, sizeof(status));
+    
+    uintattr_t fg = app->netplay->connected ? TB_CYAN : TB_RED;
+    render_target_print(2, render_target_height() - 1, fg, TB_DEFAULT, status);
 }
 
 void render_ai_turn_indicator(const ApplicationState* app) {
+    TRACE_SCOPE("render_ai_turn_indicator");
     if (app->game_mode != MODE_SINGLE_PLAYER) return;
     
-    int x_center = tb_width() / 2;
+    int x_center = render_target_width() / 2;
     int y = 7;
     
+    static CachedText ai_turn_text;
+    static CachedText human_turn_text;
+    
     if (app->game.current_player == app->ai_player) {
         const char* ai_symbol = (app->ai_player == CELL_X) ? "X" : "O";
-        tb_printf(x_center - 6, y, TB_GREEN | TB_BOLD, TB_DEFAULT, "AI Turn (%s)", ai_symbol);
+        const Sprite* text = update_cached_text(&ai_turn_text, app->ai_player, "AI Turn (%s)", ai_symbol);
+        blit_sprite_with_attrs(text, x_center - 6, y, TB_GREEN | TB_BOLD, TB_DEFAULT);
     } else {
         const char* human_symbol = (app->human_player == CELL_X) ? "X" : "O";
-        tb_printf(x_center - 7, y, TB_BLUE | TB_BOLD, TB_DEFAULT, "Your Turn (%s)", human_symbol);
+        const Sprite* text = update_cached_text(&human_turn_text, app->human_player, "Your Turn (%s)", human_symbol);
+        blit_sprite_with_attrs(text, x_center - 7, y, TB_BLUE | TB_BOLD, TB_DEFAULT);
     }
 }
 
 void render_player_indicators(const ApplicationState* app) {
+    TRACE_SCOPE("render_player_indicators");
     if (app->game_mode != MODE_SINGLE_PLAYER) return;
     
-    int x_center = tb_width() / 2;
+    int x_center = render_target_width() / 2;
     int y = 3;
     
     const char* human_symbol = (app->human_player == CELL_X) ? "X" : "O";
@@ -421,5 +480,142 @@ void render_player_indicators(const ApplicationState* app) {
             break;
     }
     
-    tb_printf(x_center - 12, y++, TB_DEFAULT, TB_DEFAULT, "You: %s  |  AI: %s (%s)", human_symbol, ai_symbol, difficulty_name);
-}
\ No newline at end of file
+    // Rebuilt only when a player or the difficulty changes
+    static CachedText indicator_text;
+    uint64_t key = (uint64_t)app->human_player | ((uint64_t)app->ai_player << 8) | ((uint64_t)app->ai_difficulty << 16);
+    const Sprite* text = update_cached_text(&indicator_text, key, "You: %s  |  AI: %s (%s)",
+                                            human_symbol, ai_symbol, difficulty_name);
+    blit_sprite(text, x_center - 12, y++);
+}
+
+// F2 overlay in the top-right corner
+#define PERF_HUD_WIDTH (PERF_HUD_HISTORY + 2)
+#define PERF_HUD_HEIGHT (PERF_PHASE_COUNT + 5)
+
+void render_perf_hud(const ApplicationState* app) {
+    TRACE_SCOPE("render_perf_hud");
+    const PerfHud* hud = &app->perf_hud;
+    int x = render_target_width() - PERF_HUD_WIDTH - 1;
+    int y = 0;
+    if (x < 0) x = 0;
+    
+    for (int row = 0; row < PERF_HUD_HEIGHT; row++) {
+        for (int col = 0; col < PERF_HUD_WIDTH; col++) {
+            render_target_set_cell(x + col, y + row, ' ', TB_WHITE, TB_BLACK);
+        }
+    }
+    
+    render_target_printf(x + 1, y++, TB_WHITE | TB_BOLD, TB_BLACK, "%6.1f fps  avg %6.1f", hud->fps, hud->average_fps);
+    for (int i = 0; i < PERF_PHASE_COUNT; i++) {
+        render_target_printf(x + 1, y++, TB_WHITE, TB_BLACK, "%-8s %9.3f ms",
+                             get_perf_phase_name((PerfPhase)i), hud->phase_time[i] * 1e3);
+    }
+    
+    // Busy time per frame, scaled to the slowest one shown; AI frames in red
+    float peak = 0.0f;
+    for (int i = 0; i < hud->history_count; i++) {
+        if (hud->busy_history[i] > peak) peak = hud->busy_history[i];
+    }
+    
+    int oldest = (hud->history_count < PERF_HUD_HISTORY) ? 0 : hud->history_next;
+    for (int i = 0; i < hud->history_count; i++) {
+        int index = (oldest + i) % PERF_HUD_HISTORY;
+        int level = (peak > 0.0f) ? (int)(hud->busy_history[index] / peak * 7.0f + 0.5f) : 0;
+        uintattr_t fg = hud->ai_history[index] ? TB_RED : TB_GREEN;
+        render_target_set_cell(x + 1 + i, y, 0x2581 + (uint32_t)level, fg, TB_BLACK);
+    }
+    y++;
+    
+    render_target_printf(x + 1, y++, TB_WHITE, TB_BLACK, "busy peak %8.3f ms", peak * 1e3);
+    render_target_printf(x + 1, y++, TB_WHITE, TB_BLACK, "input %7.2f ms max %7.2f",
+                         hud->input_latency * 1e3, hud->input_latency_peak * 1e3);
+    if (hud->last_ai_search > 0.0) {
+        render_target_printf(x + 1, y, TB_RED, TB_BLACK, "AI %.3f ms, %lu frames ago",
+                             hud->last_ai_search * 1e3, hud->frames_since_ai);
+    }
+}
+
+// Full frame for the current application state (without presenting it)
+void render_application(const ApplicationState* app) {
+    TRACE_SCOPE("render_application");
+    clear_screen();
+    
+    switch (app->current_state) {
+        case STATE_MAIN_MENU:
+            render_main_menu_with_hover(app);
+            break;
+            
+        case STATE_GAME_SELECTION:
+            render_game_selection_with_hover(app);
+            break;
+            
+        case STATE_MODE_SELECTION:
+            render_mode_selection_with_hover(app);
+            break;
+            
+        case STATE_DIFFICULTY_SELECTION:
+            render_difficulty_selection_with_hover(app);
+            break;
+            
+        case STATE_PLAYING:
+            if (has_active_game_session(app)) {
+                render_current_game(app);
+                render_loaded_game_controls();
+                break;
+            }
+            
+            render_game_ui(&app->game);
+            render_game_board_with_hover(app);
+            
+            // Render AI-specific elements for single player mode
+            if (app->game_mode == MODE_SINGLE_PLAYER) {
+                render_player_indicators(app);
+                render_ai_turn_indicator(app);
+                render_ai_thinking_animation(app);
+            }
+            
+            render_netplay_status(app);
+            render_controls(STATE_PLAYING);
+            break;
+            
+        case STATE_GAME_OVER:
+            render_game_ui(&app->game);
+            render_game_board_with_hover(app);
+            
+            // Render AI-specific elements for single player mode
+            if (app->game_mode == MODE_SINGLE_PLAYER) {
+                render_player_indicators(app);
+            }
+            
+            render_game_over_with_hover(app);
+            render_netplay_status(app);
+            break;
+            
+        case STATE_QUIT:
+            break;
+    }
+    
+    // Render global cursor on top of everything
+    render_global_cursor(app);
+    
+    // Only the overlay goes above the cursor
+    if (app->perf_hud.visible) {
+        render_perf_hud(app);
+    }
+}
+
+// Draws the game loaded in the game manager through its interface hooks
+void render_current_game(const ApplicationState* app) {
+    TRACE_SCOPE("render_current_game");
+    const GameInterface* interface = get_current_game_interface(&app->game_manager);
+    const void* state = get_current_game_state(&app->game_manager);
+    
+    if (!interface || !state) return;
+    
+    if (interface->render_game) {
+        interface->render_game(state, render_target_width(), render_target_height());
+    }
+    if (interface->render_game_ui) {
+        interface->render_game_ui(state);
+    }
+}
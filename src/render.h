@@ -22,8 +22,10 @@ void render_difficulty_selection_with_hover(const ApplicationState* app);
 void render_game_board_with_hover(const ApplicationState* app);
 void render_game_over_with_hover(const ApplicationState* app);
 void render_ai_thinking_animation(const ApplicationState* app);
+void render_netplay_status(const ApplicationState* app);
 void render_ai_turn_indicator(const ApplicationState* app);
 void render_player_indicators(const ApplicationState* app);
+void render_perf_hud(const ApplicationState* app);
 
 // New generic rendering functions
 void render_application(const ApplicationState* app);
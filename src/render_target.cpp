@@ -0,0 +1,196 @@
+#include "render_target.h"
+#include <stdarg.h>
+#include <stdlib.h>
+
+#define PRINTF_BUFFER_SIZE 1024
+
+// Termbox backend
+static struct tb_cell* termbox_get_cells(void* context) {
+    (void)context;
+    return tb_cell_buffer();
+}
+
+static int termbox_get_width(void* context) {
+    (void)context;
+    return tb_width();
+}
+
+static int termbox_get_height(void* context) {
+    (void)context;
+    return tb_height();
+}
+
+static void termbox_clear(void* context) {
+    (void)context;
+    tb_clear();
+}
+
+static void termbox_present(void* context) {
+    (void)context;
+    tb_present();
+}
+
+static const RenderTarget termbox_target = {
+    .backend_name = "termbox",
+    .context = NULL,
+    .get_cells = termbox_get_cells,
+    .get_width = termbox_get_width,
+    .get_height = termbox_get_height,
+    .clear = termbox_clear,
+    .present = termbox_present
+};
+
+static const RenderTarget* bound_target = &termbox_target;
+
+const RenderTarget* get_termbox_render_target(void) {
+    return &termbox_target;
+}
+
+// Memory backend
+static struct tb_cell* memory_get_cells(void* context) {
+    return ((MemoryFramebuffer*)context)->cells;
+}
+
+static int memory_get_width(void* context) {
+    return ((MemoryFramebuffer*)context)->width;
+}
+
+static int memory_get_height(void* context) {
+    return ((MemoryFramebuffer*)context)->height;
+}
+
+static void memory_clear(void* context) {
+    MemoryFramebuffer* framebuffer = (MemoryFramebuffer*)context;
+    int count = framebuffer->width * framebuffer->height;
+
+    for (int i = 0; i < count; i++) {
+        framebuffer->cells[i].ch = ' ';
+        framebuffer->cells[i].fg = TB_DEFAULT;
+        framebuffer->cells[i].bg = TB_DEFAULT;
+    }
+}
+
+static void memory_present(void* context) {
+    ((MemoryFramebuffer*)context)->frames_presented++;
+}
+
+bool init_memory_framebuffer(MemoryFramebuffer* framebuffer, int width, int height) {
+    framebuffer->width = 0;
+    framebuffer->height = 0;
+    framebuffer->frames_presented = 0;
+    framebuffer->cells = NULL;
+
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    framebuffer->cells = (struct tb_cell*)calloc((size_t)width * (size_t)height, sizeof(struct tb_cell));
+    if (!framebuffer->cells) {
+        return false;
+    }
+
+    framebuffer->width = width;
+    framebuffer->height = height;
+    memory_clear(framebuffer);
+    return true;
+}
+
+void cleanup_memory_framebuffer(MemoryFramebuffer* framebuffer) {
+    free(framebuffer->cells);
+    framebuffer->cells = NULL;
+    framebuffer->width = 0;
+    framebuffer->height = 0;
+}
+
+void make_memory_render_target(RenderTarget* target, MemoryFramebuffer* framebuffer) {
+    target->backend_name = "memory";
+    target->context = framebuffer;
+    target->get_cells = memory_get_cells;
+    target->get_width = memory_get_width;
+    target->get_height = memory_get_height;
+    target->clear = memory_clear;
+    target->present = memory_present;
+}
+
+// Bound target access
+void bind_render_target(const RenderTarget* target) {
+    bound_target = target ? target : &termbox_target;
+}
+
+const RenderTarget* get_bound_render_target(void) {
+    return bound_target;
+}
+
+int render_target_width(void) {
+    return bound_target->get_width(bound_target->context);
+}
+
+int render_target_height(void) {
+    return bound_target->get_height(bound_target->context);
+}
+
+struct tb_cell* render_target_cells(void) {
+    return bound_target->get_cells(bound_target->context);
+}
+
+void render_target_clear(void) {
+    bound_target->clear(bound_target->context);
+}
+
+void render_target_present(void) {
+    bound_target->present(bound_target->context);
+}
+
+void render_target_set_cell(int x, int y, uint32_t ch, uintattr_t fg, uintattr_t bg) {
+    int width = render_target_width();
+    struct tb_cell* cells = render_target_cells();
+
+    if (!cells || x < 0 || y < 0 || x >= width || y >= render_target_height()) {
+        return;
+    }
+
+    struct tb_cell* cell = &cells[y * width + x];
+    cell->ch = ch;
+    cell->fg = fg;
+    cell->bg = bg;
+}
+
+void render_target_print(int x, int y, uintattr_t fg, uintattr_t bg, const char* text) {
+    while (*text) {
+        uint32_t codepoint;
+        int bytes = tb_utf8_char_to_unicode(&codepoint, text);
+        if (bytes <= 0) break;
+
+        render_target_set_cell(x++, y, codepoint, fg, bg);
+        text += bytes;
+    }
+}
+
+void render_target_printf(int x, int y, uintattr_t fg, uintattr_t bg, const char* format, ...) {
+    char buffer[PRINTF_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    render_target_print(x, y, fg, bg, buffer);
+}
+
+void write_framebuffer_text(const MemoryFramebuffer* framebuffer, FILE* out) {
+    for (int y = 0; y < framebuffer->height; y++) {
+        const struct tb_cell* row = framebuffer->cells + y * framebuffer->width;
+
+        int length = framebuffer->width;
+        while (length > 0 && (row[length - 1].ch == ' ' || row[length - 1].ch == 0)) {
+            length--;
+        }
+
+        for (int x = 0; x < length; x++) {
+            char utf8[8];
+            uint32_t ch = row[x].ch ? row[x].ch : ' ';
+            int bytes = tb_utf8_unicode_to_char(utf8, ch);
+            fwrite(utf8, 1, (size_t)bytes, out);
+        }
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../lib/termbox2/termbox2.h"
+
+// Drawing surface: a grid of termbox cells plus backend hooks
+typedef struct RenderTarget {
+    const char* backend_name;
+    void* context;
+
+    struct tb_cell* (*get_cells)(void* context);
+    int (*get_width)(void* context);
+    int (*get_height)(void* context);
+    void (*clear)(void* context);
+    void (*present)(void* context);
+} RenderTarget;
+
+// In-memory backend, usable without a terminal
+typedef struct {
+    int width;
+    int height;
+    struct tb_cell* cells;
+    unsigned long frames_presented;
+} MemoryFramebuffer;
+
+// Backends
+const RenderTarget* get_termbox_render_target(void);
+bool init_memory_framebuffer(MemoryFramebuffer* framebuffer, int width, int height);
+void cleanup_memory_framebuffer(MemoryFramebuffer* framebuffer);
+void make_memory_render_target(RenderTarget* target, MemoryFramebuffer* framebuffer);
+
+// All rendering and screen-size queries go to the bound target
+// (the termbox backend unless another one is bound)
+void bind_render_target(const RenderTarget* target);
+const RenderTarget* get_bound_render_target(void);
+
+int render_target_width(void);
+int render_target_height(void);
+struct tb_cell* render_target_cells(void);
+void render_target_clear(void);
+void render_target_present(void);
+void render_target_set_cell(int x, int y, uint32_t ch, uintattr_t fg, uintattr_t bg);
+void render_target_print(int x, int y, uintattr_t fg, uintattr_t bg, const char* text);
+void render_target_printf(int x, int y, uintattr_t fg, uintattr_t bg, const char* format, ...)
+    __attribute__((format(printf, 5, 6)));
+
+// Frame capture: one UTF-8 line per screen row, trailing spaces trimmed
+void write_framebuffer_text(const MemoryFramebuffer* framebuffer, FILE* out);
+
+#endif
@@ -0,0 +1,298 @@
+#include "replay.h"
+#include "render.h"
+#include "render_target.h"
+#include "timing.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Largest encoded frame header and event: a tag plus up to six varints
+#define REPLAY_MAX_RECORD_SIZE (1 + 6 * 10)
+
+// Encoding
+static size_t put_varint(unsigned char* out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint64_t to_microseconds(double seconds) {
+    return (seconds > 0.0) ? (uint64_t)(seconds * 1e6 + 0.5) : 0;
+}
+
+// Recording
+static void flush_recorder(ReplayRecorder* recorder) {
+    if (recorder->length > 0) {
+        fwrite(recorder->buffer, 1, recorder->length, recorder->file);
+        recorder->length = 0;
+    }
+}
+
+static unsigned char* reserve_record(ReplayRecorder* recorder) {
+    if (REPLAY_BUFFER_SIZE - recorder->length < REPLAY_MAX_RECORD_SIZE) {
+        flush_recorder(recorder);
+    }
+    return recorder->buffer + recorder->length;
+}
+
+bool open_replay_recorder(ReplayRecorder* recorder, const char* path, unsigned int seed, int width, int height) {
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) {
+        return false;
+    }
+
+    recorder->length = 0;
+    recorder->start_time = get_monotonic_time();
+    recorder->last_frame_time = recorder->start_time;
+    recorder->frames = 0;
+    recorder->events = 0;
+
+    unsigned char* out = reserve_record(recorder);
+    size_t length = 0;
+    memcpy(out, REPLAY_MAGIC, 4);
+    length += 4;
+    out[length++] = REPLAY_VERSION;
+    length += put_varint(out + length, seed);
+    length += put_varint(out + length, zigzag(width));
+    length += put_varint(out + length, zigzag(height));
+    recorder->length += length;
+    return true;
+}
+
+void record_replay_frame(ReplayRecorder* recorder, double frame_time, double input_time,
+                         const InputBatch* batch) {
+    int count = batch->raw_event_count < INPUT_RAW_CAPACITY ? batch->raw_event_count : INPUT_RAW_CAPACITY;
+
+    unsigned char* out = reserve_record(recorder);
+    size_t length = 0;
+    out[length++] = REPLAY_FRAME;
+    length += put_varint(out + length, to_microseconds(frame_time - recorder->last_frame_time));
+    length += put_varint(out + length, to_microseconds(input_time - frame_time));
+    length += put_varint(out + length, (uint64_t)count);
+    recorder->length += length;
+    recorder->last_frame_time = frame_time;
+
+    for (int i = 0; i < count; i++) {
+        const struct tb_event* event = &batch->raw_events[i];
+
+        out = reserve_record(recorder);
+        length = 0;
+        out[length++] = event->type;
+        length += put_varint(out + length, event->mod);
+        length += put_varint(out + length, event->key);
+        length += put_varint(out + length, event->ch);
+        if (event->type == TB_EVENT_RESIZE) {
+            length += put_varint(out + length, zigzag(event->w));
+            length += put_varint(out + length, zigzag(event->h));
+        } else if (event->type == TB_EVENT_MOUSE) {
+            length += put_varint(out + length, zigzag(event->x));
+            length += put_varint(out + length, zigzag(event->y));
+        }
+        recorder->length += length;
+    }
+
+    recorder->frames++;
+    recorder->events += (unsigned long)count;
+}
+
+void close_replay_recorder(ReplayRecorder* recorder) {
+    if (!recorder->file) return;
+
+    unsigned char* out = reserve_record(recorder);
+    out[0] = REPLAY_END;
+    recorder->length++;
+    flush_recorder(recorder);
+    fclose(recorder->file);
+    recorder->file = NULL;
+}
+
+// Playback
+typedef struct {
+    const unsigned char* data;
+    size_t length;
+    size_t offset;
+    bool failed;
+} ReplayReader;
+
+static uint64_t get_varint(ReplayReader* reader) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (reader->offset >= reader->length) break;
+        unsigned char byte = reader->data[reader->offset++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->failed = true;
+    return 0;
+}
+
+static int get_byte(ReplayReader* reader) {
+    if (reader->offset >= reader->length) {
+        reader->failed = true;
+        return -1;
+    }
+    return reader->data[reader->offset++];
+}
+
+static void read_replay_event(ReplayReader* reader, struct tb_event* event) {
+    memset(event, 0, sizeof(*event));
+    event->type = (uint8_t)get_byte(reader);
+    event->mod = (uint8_t)get_varint(reader);
+    event->key = (uint16_t)get_varint(reader);
+    event->ch = (uint32_t)get_varint(reader);
+    if (event->type == TB_EVENT_RESIZE) {
+        event->w = (int32_t)unzigzag(get_varint(reader));
+        event->h = (int32_t)unzigzag(get_varint(reader));
+    } else if (event->type == TB_EVENT_MOUSE) {
+        event->x = (int32_t)unzigzag(get_varint(reader));
+        event->y = (int32_t)unzigzag(get_varint(reader));
+    }
+}
+
+static unsigned char* read_whole_file(const char* path, size_t* length) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    unsigned char* data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = (unsigned char*)malloc((size_t)size);
+            if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+                free(data);
+                data = NULL;
+            }
+            *length = (size_t)size;
+        }
+    }
+
+    fclose(file);
+    return data;
+}
+
+// The terminal resized: follow it with a framebuffer of the new size
+static bool resize_replay_framebuffer(MemoryFramebuffer* framebuffer, RenderTarget* target, int width, int height) {
+    if (width <= 0 || height <= 0 || (width == framebuffer->width && height == framebuffer->height)) {
+        return true;
+    }
+
+    cleanup_memory_framebuffer(framebuffer);
+    if (!init_memory_framebuffer(framebuffer, width, height)) {
+        return false;
+    }
+    make_memory_render_target(target, framebuffer);
+    bind_render_target(target);
+    return true;
+}
+
+int run_replay(const char* path) {
+    size_t length = 0;
+    unsigned char* data = read_whole_file(path, &length);
+    if (!data) {
+        fprintf(stderr, "Cannot read replay %s\n", path);
+        return 1;
+    }
+
+    ReplayReader reader = {data, length, 0, false};
+    if (length < 5 || memcmp(data, REPLAY_MAGIC, 4) != 0 || data[4] != REPLAY_VERSION) {
+        fprintf(stderr, "%s is not a version %d replay\n", path, REPLAY_VERSION);
+        free(data);
+        return 1;
+    }
+    reader.offset = 5;
+
+    unsigned int seed = (unsigned int)get_varint(&reader);
+    int width = (int)unzigzag(get_varint(&reader));
+    int height = (int)unzigzag(get_varint(&reader));
+
+    MemoryFramebuffer framebuffer;
+    if (reader.failed || !init_memory_framebuffer(&framebuffer, width, height)) {
+        fprintf(stderr, "Bad replay header in %s\n", path);
+        free(data);
+        return 1;
+    }
+
+    RenderTarget target;
+    make_memory_render_target(&target, &framebuffer);
+    bind_render_target(&target);
+
+    ApplicationState app;
+    init_application_state(&app);
+    app.random_seed = seed;
+    srand(seed);
+
+    unsigned long frames = 0;
+    unsigned long events = 0;
+    double frame_time = 0.0;
+    bool complete = false;
+    double start = get_system_monotonic_time();
+
+    while (app.current_state != STATE_QUIT && !reader.failed) {
+        int tag = get_byte(&reader);
+        if (tag == REPLAY_END) {
+            complete = true;
+            break;
+        }
+        if (tag != REPLAY_FRAME) {
+            reader.failed = true;
+            break;
+        }
+
+        frame_time += (double)get_varint(&reader) / 1e6;
+        double input_time = frame_time + (double)get_varint(&reader) / 1e6;
+        uint64_t count = get_varint(&reader);
+
+        // Same order as the terminal loop
+        set_virtual_time(frame_time);
+        update_frame(&app, frame_time);
+        render_application(&app);
+        present_screen();
+
+        set_virtual_time(input_time);
+        InputBatch batch;
+        init_input_batch(&batch);
+        for (uint64_t i = 0; i < count && !reader.failed; i++) {
+            struct tb_event event;
+            read_replay_event(&reader, &event);
+            if (event.type == TB_EVENT_RESIZE &&
+                !resize_replay_framebuffer(&framebuffer, &target, event.w, event.h)) {
+                reader.failed = true;
+                break;
+            }
+            append_input_event(&batch, &event);
+        }
+        apply_input_batch(&app, &batch);
+        process_pending_ai_turn(&app);
+
+        frames++;
+        events += count;
+    }
+
+    double elapsed = get_system_monotonic_time() - start;
+    set_virtual_time(-1.0);
+
+    // A log cut short by a crash still replays up to the last full frame
+    if (!complete && app.current_state != STATE_QUIT) {
+        fprintf(stderr, "Replay ended early after %lu frames\n", frames);
+    }
+
+    printf("Replay %s: %lu frames, %lu events, %.0f s recorded\n", path, frames, events, frame_time);
+    printf("  %10.3f ms total, %.2f us/frame\n", elapsed * 1e3, frames ? elapsed * 1e6 / frames : 0.0);
+
+    cleanup_application_state(&app);
+    bind_render_target(NULL);
+    cleanup_memory_framebuffer(&framebuffer);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "events.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Binary input log. Unsigned values are LEB128 varints; signed ones
+// (coordinates and sizes) are zigzag-encoded first.
+//   header  "TTTR" u8 version, seed, screen width, screen height
+//   frame   u8 REPLAY_FRAME, frame time, input time, event count, events
+//   event   u8 type, mod, key, ch, then w h (resize) or x y (mouse)
+//   end     u8 REPLAY_END
+// Frame time is microseconds since the previous frame started (the first
+// counts from when recording began); input time is microseconds from the
+// frame's start until its input was applied.
+#define REPLAY_MAGIC "TTTR"
+#define REPLAY_VERSION 1
+#define REPLAY_FRAME 1
+#define REPLAY_END 2
+
+// Writes are buffered; the file sees one write per REPLAY_BUFFER_SIZE
+#define REPLAY_BUFFER_SIZE 65536
+
+typedef struct {
+    FILE* file;
+    unsigned char buffer[REPLAY_BUFFER_SIZE];
+    size_t length;
+    double start_time;
+    double last_frame_time;
+    unsigned long frames;
+    unsigned long events;
+} ReplayRecorder;
+
+bool open_replay_recorder(ReplayRecorder* recorder, const char* path, unsigned int seed, int width, int height);
+
+// One main loop iteration: when it started, when its input was applied,
+// and the raw events in that input
+void record_replay_frame(ReplayRecorder* recorder, double frame_time, double input_time,
+                         const InputBatch* batch);
+void close_replay_recorder(ReplayRecorder* recorder);
+
+// Re-runs a log through the same loop steps as the terminal, rendering
+// into memory, as fast as possible; prints the total time
+int run_replay(const char* path);
+
+#endif
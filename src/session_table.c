@@ -0,0 +1,439 @@
+#include "session_table.h"
+#include "timing.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Persistent threads woken once per batched update
+struct SessionWorkers {
+    pthread_t threads[SESSION_MAX_WORKERS];
+    int thread_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    unsigned long batch_id;
+    int busy_count;
+    bool stopping;
+
+    // Current batch
+    SessionTable* table;
+    SessionRangeFunction range_function;
+    void* context;
+    int next_slot;         // Claimed atomically, SESSION_UPDATE_BATCH at a time
+};
+
+// Slab
+static size_t align_state_size(size_t size) {
+    size_t alignment = sizeof(max_align_t);
+    if (size == 0) size = 1;
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static void init_state_slab(StateSlab* slab) {
+    slab->state_size = 0;
+    slab->chunks = NULL;
+    slab->chunk_count = 0;
+    slab->chunk_capacity = 0;
+    slab->free_states = NULL;
+    slab->free_count = 0;
+    slab->free_capacity = 0;
+}
+
+static void cleanup_state_slab(StateSlab* slab) {
+    for (int i = 0; i < slab->chunk_count; i++) {
+        free(slab->chunks[i]);
+    }
+    free(slab->chunks);
+    free(slab->free_states);
+    init_state_slab(slab);
+}
+
+static bool grow_state_slab(StateSlab* slab) {
+    if (slab->chunk_count == slab->chunk_capacity) {
+        int capacity = slab->chunk_capacity ? slab->chunk_capacity * 2 : 8;
+        unsigned char** chunks = (unsigned char**)realloc(slab->chunks, sizeof(unsigned char*) * capacity);
+        if (!chunks) return false;
+        slab->chunks = chunks;
+        slab->chunk_capacity = capacity;
+    }
+
+    int free_needed = slab->free_count + SESSION_SLAB_CHUNK_STATES;
+    if (free_needed > slab->free_capacity) {
+        int capacity = slab->free_capacity ? slab->free_capacity : SESSION_SLAB_CHUNK_STATES;
+        while (capacity < free_needed) capacity *= 2;
+        void** free_states = (void**)realloc(slab->free_states, sizeof(void*) * capacity);
+        if (!free_states) return false;
+        slab->free_states = free_states;
+        slab->free_capacity = capacity;
+    }
+
+    unsigned char* chunk = (unsigned char*)malloc(slab->state_size * SESSION_SLAB_CHUNK_STATES);
+    if (!chunk) return false;
+    slab->chunks[slab->chunk_count++] = chunk;
+
+    // Push in reverse so states are handed out in address order
+    for (int i = SESSION_SLAB_CHUNK_STATES - 1; i >= 0; i--) {
+        slab->free_states[slab->free_count++] = chunk + (size_t)i * slab->state_size;
+    }
+    return true;
+}
+
+static void* acquire_slab_state(StateSlab* slab, size_t state_size) {
+    if (slab->state_size == 0) {
+        slab->state_size = align_state_size(state_size);
+    }
+    if (slab->free_count == 0 && !grow_state_slab(slab)) {
+        return NULL;
+    }
+    return slab->free_states[--slab->free_count];
+}
+
+static void release_slab_state(StateSlab* slab, void* state) {
+    // The free list always has room for every state the slab owns
+    slab->free_states[slab->free_count++] = state;
+}
+
+// Workers
+static void run_batches(SessionWorkers* workers) {
+    SessionTable* table = workers->table;
+    int slot_count = table->slot_count;
+
+    for (;;) {
+        int begin = __atomic_fetch_add(&workers->next_slot, SESSION_UPDATE_BATCH, __ATOMIC_RELAXED);
+        if (begin >= slot_count) break;
+
+        int end = begin + SESSION_UPDATE_BATCH;
+        TRACE_SCOPE("session_batch");
+        workers->range_function(table, begin, end < slot_count ? end : slot_count, workers->context);
+    }
+}
+
+static void* session_worker_main(void* arg) {
+    SessionWorkers* workers = (SessionWorkers*)arg;
+    unsigned long seen_batch = 0;
+    TRACE_THREAD_NAME("session worker");
+
+    for (;;) {
+        pthread_mutex_lock(&workers->lock);
+        while (!workers->stopping && workers->batch_id == seen_batch) {
+            pthread_cond_wait(&workers->work_ready, &workers->lock);
+        }
+        if (workers->stopping) {
+            pthread_mutex_unlock(&workers->lock);
+            return NULL;
+        }
+        seen_batch = workers->batch_id;
+        pthread_mutex_unlock(&workers->lock);
+
+        run_batches(workers);
+
+        pthread_mutex_lock(&workers->lock);
+        if (--workers->busy_count == 0) {
+            pthread_cond_signal(&workers->work_done);
+        }
+        pthread_mutex_unlock(&workers->lock);
+    }
+}
+
+static void stop_session_workers(SessionWorkers* workers) {
+    pthread_mutex_lock(&workers->lock);
+    workers->stopping = true;
+    pthread_cond_broadcast(&workers->work_ready);
+    pthread_mutex_unlock(&workers->lock);
+
+    for (int i = 0; i < workers->thread_count; i++) {
+        pthread_join(workers->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&workers->work_done);
+    pthread_cond_destroy(&workers->work_ready);
+    pthread_mutex_destroy(&workers->lock);
+    free(workers);
+}
+
+static SessionWorkers* start_session_workers(int worker_count) {
+    SessionWorkers* workers = (SessionWorkers*)calloc(1, sizeof(SessionWorkers));
+    if (!workers) return NULL;
+
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->work_ready, NULL);
+    pthread_cond_init(&workers->work_done, NULL);
+
+    for (int i = 0; i < worker_count; i++) {
+        if (pthread_create(&workers->threads[i], NULL, session_worker_main, workers) != 0) {
+            break;
+        }
+        workers->thread_count++;
+    }
+
+    return workers;
+}
+
+// Table
+bool init_session_table(SessionTable* table, int worker_count) {
+    table->slots = NULL;
+    table->slot_count = 0;
+    table->slot_capacity = 0;
+    table->free_head = -1;
+    table->active_count = 0;
+    table->workers = NULL;
+    table->next_wake = -1.0;
+
+    for (int i = 0; i < GAME_TYPE_COUNT; i++) {
+        init_state_slab(&table->slabs[i]);
+    }
+
+    if (worker_count > SESSION_MAX_WORKERS) worker_count = SESSION_MAX_WORKERS;
+    if (worker_count > 0) {
+        table->workers = start_session_workers(worker_count);
+        if (!table->workers) return false;
+    }
+
+    return true;
+}
+
+void cleanup_session_table(SessionTable* table) {
+    if (table->workers) {
+        stop_session_workers(table->workers);
+        table->workers = NULL;
+    }
+
+    for (int i = 0; i < table->slot_count; i++) {
+        SessionSlot* slot = &table->slots[i];
+        if (slot->in_use && slot->interface->cleanup_game) {
+            slot->interface->cleanup_game(slot->state);
+        }
+    }
+
+    for (int i = 0; i < GAME_TYPE_COUNT; i++) {
+        cleanup_state_slab(&table->slabs[i]);
+    }
+
+    free(table->slots);
+    table->slots = NULL;
+    table->slot_count = 0;
+    table->slot_capacity = 0;
+    table->free_head = -1;
+    table->active_count = 0;
+}
+
+static SessionSlot* resolve_slot(const SessionTable* table, SessionHandle handle) {
+    if (handle.generation == 0 || handle.index >= (uint32_t)table->slot_count) {
+        return NULL;
+    }
+
+    SessionSlot* slot = &table->slots[handle.index];
+    return (slot->in_use && slot->generation == handle.generation) ? slot : NULL;
+}
+
+static int acquire_slot_index(SessionTable* table) {
+    if (table->free_head >= 0) {
+        int index = table->free_head;
+        table->free_head = table->slots[index].next_free;
+        return index;
+    }
+
+    if (table->slot_count == table->slot_capacity) {
+        int capacity = table->slot_capacity ? table->slot_capacity * 2 : 1024;
+        SessionSlot* slots = (SessionSlot*)realloc(table->slots, sizeof(SessionSlot) * capacity);
+        if (!slots) return -1;
+        table->slots = slots;
+        table->slot_capacity = capacity;
+    }
+
+    int index = table->slot_count++;
+    table->slots[index].generation = 0;
+    table->slots[index].in_use = false;
+    return index;
+}
+
+SessionHandle create_session(SessionTable* table, GameType game_type) {
+    SessionHandle invalid = {0, 0};
+
+    const GameInterface* interface = get_game_interface(game_type);
+    if (!interface || !interface->init_game) {
+        return invalid;
+    }
+
+    void* state = acquire_slab_state(&table->slabs[game_type], interface->game_state_size);
+    if (!state) {
+        return invalid;
+    }
+
+    int index = acquire_slot_index(table);
+    if (index < 0) {
+        release_slab_state(&table->slabs[game_type], state);
+        return invalid;
+    }
+
+    SessionSlot* slot = &table->slots[index];
+    slot->state = state;
+    slot->interface = interface;
+    slot->game_type = game_type;
+    slot->generation++;
+    if (slot->generation == 0) slot->generation = 1;
+    slot->in_use = true;
+    slot->next_free = -1;
+    slot->wake_time = 0.0;   // Let the first update decide
+    table->next_wake = 0.0;
+    table->active_count++;
+
+    memset(state, 0, interface->game_state_size);
+    interface->init_game(state);
+
+    SessionHandle handle = {(uint32_t)index, slot->generation};
+    return handle;
+}
+
+bool destroy_session(SessionTable* table, SessionHandle handle) {
+    SessionSlot* slot = resolve_slot(table, handle);
+    if (!slot) {
+        return false;
+    }
+
+    if (slot->interface->cleanup_game) {
+        slot->interface->cleanup_game(slot->state);
+    }
+    release_slab_state(&table->slabs[slot->game_type], slot->state);
+
+    slot->state = NULL;
+    slot->interface = NULL;
+    slot->in_use = false;
+    slot->next_free = table->free_head;
+    table->free_head = (int)handle.index;
+    table->active_count--;
+    return true;
+}
+
+bool is_valid_session(const SessionTable* table, SessionHandle handle) {
+    return resolve_slot(table, handle) != NULL;
+}
+
+void* get_session_state(const SessionTable* table, SessionHandle handle) {
+    SessionSlot* slot = resolve_slot(table, handle);
+    return slot ? slot->state : NULL;
+}
+
+const GameInterface* get_session_interface(const SessionTable* table, SessionHandle handle) {
+    SessionSlot* slot = resolve_slot(table, handle);
+    return slot ? slot->interface : NULL;
+}
+
+int get_active_session_count(const SessionTable* table) {
+    return table->active_count;
+}
+
+void run_session_batches(SessionTable* table, SessionRangeFunction range_function, void* context) {
+    SessionWorkers* workers = table->workers;
+
+    // Small tables are not worth waking anyone for
+    if (!workers || workers->thread_count == 0 || table->slot_count <= SESSION_UPDATE_BATCH) {
+        range_function(table, 0, table->slot_count, context);
+        return;
+    }
+
+    pthread_mutex_lock(&workers->lock);
+    workers->table = table;
+    workers->range_function = range_function;
+    workers->context = context;
+    workers->next_slot = 0;
+    workers->busy_count = workers->thread_count;
+    workers->batch_id++;
+    pthread_cond_broadcast(&workers->work_ready);
+    pthread_mutex_unlock(&workers->lock);
+
+    // The caller claims batches too rather than just waiting
+    run_batches(workers);
+
+    pthread_mutex_lock(&workers->lock);
+    while (workers->busy_count > 0) {
+        pthread_cond_wait(&workers->work_done, &workers->lock);
+    }
+    pthread_mutex_unlock(&workers->lock);
+}
+
+// Sentinel for "no deadline yet". Non-negative doubles order the same as
+// their bit patterns, so the minimum can be kept with integer atomics.
+#define NO_SESSION_WAKE UINT64_MAX
+
+void note_session_wake(SessionUpdatePass* pass, double wake_time) {
+    if (wake_time < 0.0) return;
+
+    uint64_t bits;
+    memcpy(&bits, &wake_time, sizeof(bits));
+
+    uint64_t current = __atomic_load_n(&pass->earliest_wake, __ATOMIC_RELAXED);
+    while (bits < current &&
+           !__atomic_compare_exchange_n(&pass->earliest_wake, &current, bits, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void run_session_update(SessionTable* table, SessionRangeFunction range_function, double delta_time) {
+    SessionUpdatePass pass;
+    pass.delta_time = delta_time;
+    pass.now = get_monotonic_time();
+    pass.earliest_wake = NO_SESSION_WAKE;
+
+    // Nothing due: skip the scan entirely
+    if (table->next_wake < 0.0 || table->next_wake > pass.now) {
+        return;
+    }
+
+    run_session_batches(table, range_function, &pass);
+
+    if (pass.earliest_wake == NO_SESSION_WAKE) {
+        table->next_wake = -1.0;
+    } else {
+        memcpy(&table->next_wake, &pass.earliest_wake, sizeof(table->next_wake));
+    }
+}
+
+// Update through the GameInterface table, one indirect call per due session
+static void update_slot_range(SessionTable* table, int begin, int end, void* context) {
+    SessionUpdatePass* pass = (SessionUpdatePass*)context;
+    double earliest = -1.0;
+
+    for (int i = begin; i < end; i++) {
+        SessionSlot* slot = &table->slots[i];
+        if (!slot->in_use || slot->wake_time < 0.0) continue;
+
+        if (slot->wake_time <= pass->now) {
+            if (slot->interface->update_game) {
+                slot->interface->update_game(slot->state, pass->delta_time);
+            }
+            slot->wake_time = get_game_update_deadline(slot->interface, slot->state, pass->now);
+        }
+
+        if (slot->wake_time >= 0.0 && (earliest < 0.0 || slot->wake_time < earliest)) {
+            earliest = slot->wake_time;
+        }
+    }
+
+    note_session_wake(pass, earliest);
+}
+
+void update_all_sessions(SessionTable* table, double delta_time) {
+    run_session_update(table, update_slot_range, delta_time);
+}
+
+void wake_session(SessionTable* table, SessionHandle handle) {
+    SessionSlot* slot = resolve_slot(table, handle);
+    if (!slot) return;
+
+    slot->wake_time = 0.0;
+    table->next_wake = 0.0;
+}
+
+void wake_all_sessions(SessionTable* table) {
+    for (int i = 0; i < table->slot_count; i++) {
+        table->slots[i].wake_time = 0.0;
+    }
+    table->next_wake = (table->active_count > 0) ? 0.0 : -1.0;
+}
+
+double get_next_session_wake(const SessionTable* table) {
+    return table->next_wake;
+}
@@ -0,0 +1,107 @@
+#ifndef SESSION_TABLE_H
+#define SESSION_TABLE_H
+
+#include "games/game_interface.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// States per slab chunk; chunks never move, so state pointers stay valid
+#define SESSION_SLAB_CHUNK_STATES 256
+
+// Sessions a worker claims at a time during a batched update
+#define SESSION_UPDATE_BATCH 64
+
+#define SESSION_MAX_WORKERS 32
+
+// Stable session reference. A destroyed session's slot is reused with a
+// new generation, so old handles stop resolving instead of aliasing.
+typedef struct {
+    uint32_t index;
+    uint32_t generation;   // 0 is never issued
+} SessionHandle;
+
+// Per-game storage for fixed-size states
+typedef struct {
+    size_t state_size;
+    unsigned char** chunks;
+    int chunk_count;
+    int chunk_capacity;
+    void** free_states;
+    int free_count;
+    int free_capacity;
+} StateSlab;
+
+typedef struct {
+    void* state;
+    const GameInterface* interface;
+    GameType game_type;
+    uint32_t generation;
+    bool in_use;
+    double wake_time;      // Next update deadline; -1 while idle
+    int next_free;         // Free-list link while unused
+} SessionSlot;
+
+typedef struct SessionWorkers SessionWorkers;
+struct SessionTable;
+
+// Processes slots [begin, end); may run on any worker thread
+typedef void (*SessionRangeFunction)(struct SessionTable* table, int begin, int end, void* context);
+
+typedef struct SessionTable {
+    SessionSlot* slots;
+    int slot_count;        // Slots ever handed out (high-water mark)
+    int slot_capacity;
+    int free_head;
+    int active_count;
+    StateSlab slabs[GAME_TYPE_COUNT];
+    SessionWorkers* workers;
+    double next_wake;      // Earliest wake_time; -1 when every session is idle
+} SessionTable;
+
+// One scheduled update over the table, shared by all range functions
+typedef struct {
+    double delta_time;
+    double now;
+    uint64_t earliest_wake;   // Bits of the earliest deadline seen, see note_session_wake
+} SessionUpdatePass;
+
+// Table lifecycle; worker_count extra threads help with batched updates
+bool init_session_table(SessionTable* table, int worker_count);
+void cleanup_session_table(SessionTable* table);
+
+// Sessions
+SessionHandle create_session(SessionTable* table, GameType game_type);
+bool destroy_session(SessionTable* table, SessionHandle handle);
+bool is_valid_session(const SessionTable* table, SessionHandle handle);
+void* get_session_state(const SessionTable* table, SessionHandle handle);
+const GameInterface* get_session_interface(const SessionTable* table, SessionHandle handle);
+int get_active_session_count(const SessionTable* table);
+
+// Splits the slot range into SESSION_UPDATE_BATCH pieces and runs them on
+// the workers (and the caller). Sessions must not be created or destroyed
+// while this runs.
+void run_session_batches(SessionTable* table, SessionRangeFunction range_function, void* context);
+
+// Scheduled updates: runs range_function only if some session is due, then
+// records the earliest deadline the ranges reported. Range functions get
+// the SessionUpdatePass as context and should update only slots whose
+// wake_time has passed, refresh their wake_time, and report the minimum
+// through note_session_wake.
+void run_session_update(SessionTable* table, SessionRangeFunction range_function, double delta_time);
+void note_session_wake(SessionUpdatePass* pass, double wake_time);
+
+// Updates every session whose next_update deadline has passed. An idle
+// table costs nothing.
+void update_all_sessions(SessionTable* table, double delta_time);
+
+// Changing a session's state from outside (input, a bot) may make it due;
+// wake it so the next update looks at it again
+void wake_session(SessionTable* table, SessionHandle handle);
+void wake_all_sessions(SessionTable* table);
+
+// Earliest deadline across all sessions; -1 when all are idle. A host can
+// sleep until then.
+double get_next_session_wake(const SessionTable* table);
+
+#endif
@@ -0,0 +1,542 @@
+#include "simulation.h"
+#include "timing.h"
+#include "trace.h"
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// Slot indices of a triple buffer, packed so the shared one can be swapped
+// atomically. The writer fills its back slot and swaps it into the middle,
+// marked fresh; the reader swaps the middle slot for its front one only
+// when it is fresh. Each side always owns one slot, so neither waits.
+#define TRIPLE_SLOT_MASK 3
+#define TRIPLE_FRESH 4
+
+typedef struct {
+    uint8_t middle;     // Shared
+    uint8_t back;       // Writer only
+    uint8_t front;      // Reader only
+} TripleIndex;
+
+// Main thread to simulation: everything it should be working on. Each
+// request replaces the previous one.
+typedef struct {
+    uint64_t ticket;                  // Increases with every request
+    uint64_t game_generation;         // GameManager state_generation of state
+    const GameInterface* interface;   // NULL: no game to step
+    size_t state_size;
+    unsigned char state[SIMULATION_STATE_CAPACITY];
+
+    uint64_t ai_job;                  // Board to search, 0 for none
+    GameState board;
+    CellState ai_player;
+    AIDifficulty ai_difficulty;
+
+    uint64_t ponder_job;              // Human-to-move board to ponder, 0 for none
+    GameState ponder_board;
+} SimulationRequest;
+
+// Simulation to main thread: the latest stepped state and AI answer
+typedef struct {
+    uint64_t game_generation;
+    unsigned long steps;              // update_game calls since that generation
+    const GameInterface* interface;
+    size_t state_size;
+    unsigned char state[SIMULATION_STATE_CAPACITY];
+
+    uint64_t ai_job;                  // Search the move answers, 0 for none yet
+    int ai_move;
+    double ai_search_time;            // Seconds, real clock; the ponder time if pondered
+
+    // The AI's answer to each human reply on the pondered board, by cell:
+    // PONDER_PENDING until searched, -1 if the reply ends the game
+    uint64_t ponder_job;
+    int ponder_moves[9];
+    double ponder_times[9];           // Seconds each of those searches took
+} SimulationFrame;
+
+#define PONDER_PENDING -2
+
+struct SimulationThread {
+    SimulationRequest requests[3];
+    TripleIndex request_index;
+    SimulationFrame frames[3];
+    TripleIndex frame_index;
+
+    pthread_t thread;
+    int request_fd;                   // Wakes the simulation thread
+    int wake_fd;                      // Wakes the frame loop
+    bool stopping;
+    uint64_t acknowledged_ticket;     // Newest request the thread has taken
+
+    // Simulation thread only
+    SimulationFrame working;
+
+    // Main thread only
+    uint64_t next_ticket;
+    bool submitted;
+    uint64_t submitted_generation;
+    const GameInterface* submitted_interface;
+    uint64_t next_ai_job;
+    uint64_t ai_job;                  // Outstanding search, 0 for none
+    GameState ai_job_board;
+    CellState ai_player;
+    AIDifficulty ai_difficulty;
+    uint64_t answered_ai_job;
+    int answered_ai_move;
+    double answered_ai_search_time;
+
+    bool pondering;
+    uint64_t next_ponder_job;
+    uint64_t ponder_job;              // Board being pondered, 0 for none
+    GameState ponder_board;
+    int pondered_moves[9];            // Latest results for ponder_job
+    double pondered_times[9];
+};
+
+static void init_triple_index(TripleIndex* index) {
+    index->front = 0;
+    index->middle = 1;
+    index->back = 2;
+}
+
+static void publish_triple_slot(TripleIndex* index) {
+    uint8_t previous = __atomic_exchange_n(&index->middle, (uint8_t)(index->back | TRIPLE_FRESH), __ATOMIC_ACQ_REL);
+    index->back = previous & TRIPLE_SLOT_MASK;
+}
+
+static bool acquire_triple_slot(TripleIndex* index) {
+    if (!(__atomic_load_n(&index->middle, __ATOMIC_ACQUIRE) & TRIPLE_FRESH)) {
+        return false;
+    }
+
+    uint8_t previous = __atomic_exchange_n(&index->middle, index->front, __ATOMIC_ACQ_REL);
+    index->front = previous & TRIPLE_SLOT_MASK;
+    return true;
+}
+
+static void signal_fd(int fd) {
+    uint64_t one = 1;
+    ssize_t written = write(fd, &one, sizeof(one));
+    (void)written;
+}
+
+static void clear_fd(int fd) {
+    uint64_t count;
+    ssize_t bytes = read(fd, &count, sizeof(count));
+    (void)bytes;
+}
+
+static bool same_board(const GameState* a, const GameState* b) {
+    return memcmp(a->board, b->board, sizeof(a->board)) == 0 &&
+           a->current_player == b->current_player &&
+           a->game_active == b->game_active;
+}
+
+// Simulation thread
+
+static void publish_frame(SimulationThread* simulation) {
+    const SimulationFrame* working = &simulation->working;
+    SimulationFrame* frame = &simulation->frames[simulation->frame_index.back];
+
+    frame->game_generation = working->game_generation;
+    frame->steps = working->steps;
+    frame->interface = working->interface;
+    frame->state_size = working->state_size;
+    memcpy(frame->state, working->state, working->state_size);
+    frame->ai_job = working->ai_job;
+    frame->ai_move = working->ai_move;
+    frame->ai_search_time = working->ai_search_time;
+    frame->ponder_job = working->ponder_job;
+    memcpy(frame->ponder_moves, working->ponder_moves, sizeof(frame->ponder_moves));
+    memcpy(frame->ponder_times, working->ponder_times, sizeof(frame->ponder_times));
+
+    publish_triple_slot(&simulation->frame_index);
+    signal_fd(simulation->wake_fd);
+}
+
+// Restarts from the request's state unless it is the one already running
+static void take_request(SimulationFrame* working, const SimulationRequest* request) {
+    if (request->game_generation == working->game_generation && request->interface == working->interface) {
+        return;
+    }
+
+    working->game_generation = request->game_generation;
+    working->steps = 0;
+    working->interface = request->interface;
+    working->state_size = request->interface ? request->state_size : 0;
+    memcpy(working->state, request->state, working->state_size);
+}
+
+// Sleeps until a request arrives or the deadline passes (never if negative)
+static void wait_for_request(SimulationThread* simulation, double deadline) {
+    int timeout_ms = -1;
+    if (deadline >= 0.0) {
+        double remaining = deadline - get_monotonic_time();
+        timeout_ms = (remaining > 0.0) ? (int)(remaining * 1000.0 + 0.999) : 0;
+    }
+
+    struct pollfd fd = { simulation->request_fd, POLLIN, 0 };
+    if (poll(&fd, 1, timeout_ms) > 0) {
+        clear_fd(simulation->request_fd);
+    }
+}
+
+// The cell where `after` has one more mark than `before`, or -1
+static int find_reply_cell(const GameState* before, const GameState* after) {
+    int cell = -1;
+    for (int i = 0; i < 9; i++) {
+        CellState old_cell = before->board[i / 3][i % 3];
+        CellState new_cell = after->board[i / 3][i % 3];
+        if (old_cell == new_cell) continue;
+        if (old_cell != CELL_EMPTY || cell >= 0) return -1;
+        cell = i;
+    }
+    return cell;
+}
+
+// Likelier human replies first: a win, a block, the center, the corners,
+// then the edges
+static int rank_human_reply(const GameState* board, int cell, CellState human_player, CellState ai_player) {
+    int x = cell % 3;
+    int y = cell / 3;
+    GameState trial = *board;
+
+    simulate_move(&trial, x, y, human_player);
+    if (check_winner(&trial) == human_player) return 0;
+
+    trial.board[y][x] = ai_player;
+    if (check_winner(&trial) == ai_player) return 1;
+
+    if (cell == 4) return 2;
+    return (x != 1 && y != 1) ? 3 : 4;
+}
+
+// Starts on a new board: every legal reply, ordered by rank
+static int order_human_replies(const GameState* board, CellState ai_player, int* order) {
+    CellState human_player = (ai_player == CELL_X) ? CELL_O : CELL_X;
+    int count = 0;
+
+    for (int rank = 0; rank <= 4; rank++) {
+        for (int cell = 0; cell < 9; cell++) {
+            if (board->board[cell / 3][cell % 3] == CELL_EMPTY &&
+                rank_human_reply(board, cell, human_player, ai_player) == rank) {
+                order[count++] = cell;
+            }
+        }
+    }
+    return count;
+}
+
+// The AI's answer to the human playing `cell` on the pondered board
+static int ponder_reply(const SimulationRequest* request, int cell) {
+    GameState board = request->ponder_board;
+    if (!make_move(&board, cell % 3, cell / 3) || !board.game_active) {
+        return -1;
+    }
+    return get_ai_move(&board, request->ai_player, request->ai_difficulty);
+}
+
+// A search pondering already did, or PONDER_PENDING; *search_time gets
+// how long that search took
+static int find_pondered_move(const SimulationFrame* working, const SimulationRequest* request,
+                              double* search_time) {
+    if (working->ponder_job == 0 || working->ponder_job != request->ponder_job) {
+        return PONDER_PENDING;
+    }
+
+    int cell = find_reply_cell(&request->ponder_board, &request->board);
+    if (cell < 0) {
+        return PONDER_PENDING;
+    }
+    *search_time = working->ponder_times[cell];
+    return working->ponder_moves[cell];
+}
+
+static void* run_simulation_thread(void* arg) {
+    SimulationThread* simulation = (SimulationThread*)arg;
+    SimulationFrame* working = &simulation->working;
+    const SimulationRequest* request = NULL;
+    uint64_t searched_job = 0;
+    double next_step = 0.0;
+    int ponder_order[9];
+    int ponder_count = 0;
+    int ponder_next = 0;
+    TRACE_THREAD_NAME("simulation");
+
+    while (!__atomic_load_n(&simulation->stopping, __ATOMIC_ACQUIRE)) {
+        // The front slot stays ours until the next acquire
+        if (acquire_triple_slot(&simulation->request_index)) {
+            request = &simulation->requests[simulation->request_index.front];
+            take_request(working, request);
+            __atomic_store_n(&simulation->acknowledged_ticket, request->ticket, __ATOMIC_RELEASE);
+        }
+
+        bool changed = false;
+        if (request && request->ai_job != 0 && request->ai_job != searched_job) {
+            TRACE_SCOPE("ai_search");
+            double search_time = 0.0;
+            int pondered = find_pondered_move(working, request, &search_time);
+            if (pondered != PONDER_PENDING) {
+                working->ai_move = pondered;
+            } else {
+                double search_begin = get_system_monotonic_time();
+                working->ai_move = get_ai_move(&request->board, request->ai_player, request->ai_difficulty);
+                search_time = get_system_monotonic_time() - search_begin;
+            }
+            working->ai_search_time = search_time;
+            working->ai_job = request->ai_job;
+            searched_job = request->ai_job;
+            changed = true;
+
+            // The human has moved; the other replies no longer matter
+            ponder_next = ponder_count;
+        }
+
+        if (request && request->ponder_job != working->ponder_job) {
+            working->ponder_job = request->ponder_job;
+            for (int i = 0; i < 9; i++) {
+                working->ponder_moves[i] = PONDER_PENDING;
+                working->ponder_times[i] = 0.0;
+            }
+            ponder_count = request->ponder_job ? order_human_replies(&request->ponder_board, request->ai_player, ponder_order) : 0;
+            ponder_next = 0;
+        }
+
+        // Fixed-rate steps while the game wants updates; after a stall the
+        // schedule restarts instead of replaying every missed step
+        double wake_at = -1.0;
+        if (working->interface) {
+            double now = get_monotonic_time();
+            double deadline = get_game_update_deadline(working->interface, working->state, now);
+            if (deadline >= 0.0) {
+                if (next_step < now - 4 * SIMULATION_STEP_SECONDS) {
+                    next_step = now;
+                }
+                double due = (deadline > next_step) ? deadline : next_step;
+                if (due <= now) {
+                    TRACE_SCOPE("simulation_step");
+                    working->interface->update_game(working->state, SIMULATION_STEP_SECONDS);
+                    working->steps++;
+                    next_step = due + SIMULATION_STEP_SECONDS;
+                    changed = true;
+                    wake_at = now;
+                } else {
+                    wake_at = due;
+                }
+            }
+        }
+
+        // Idle time goes to pondering, one reply per pass so new requests
+        // are picked up between searches
+        if (!changed && ponder_next < ponder_count) {
+            TRACE_SCOPE("ponder");
+            int cell = ponder_order[ponder_next++];
+            double search_begin = get_system_monotonic_time();
+            working->ponder_moves[cell] = ponder_reply(request, cell);
+            working->ponder_times[cell] = get_system_monotonic_time() - search_begin;
+            changed = true;
+            wake_at = get_monotonic_time();
+        }
+
+        if (changed) {
+            publish_frame(simulation);
+        }
+        if (wake_at < 0.0 || wake_at > get_monotonic_time()) {
+            wait_for_request(simulation, wake_at);
+        }
+    }
+
+    return NULL;
+}
+
+SimulationThread* start_simulation_thread(void) {
+    SimulationThread* simulation = (SimulationThread*)calloc(1, sizeof(SimulationThread));
+    if (!simulation) return NULL;
+
+    init_triple_index(&simulation->request_index);
+    init_triple_index(&simulation->frame_index);
+    simulation->request_fd = eventfd(0, EFD_NONBLOCK);
+    simulation->wake_fd = eventfd(0, EFD_NONBLOCK);
+
+    const char* ponder = getenv(SIMULATION_PONDER_ENV);
+    simulation->pondering = ponder && ponder[0] && strcmp(ponder, "0") != 0;
+
+    if (simulation->request_fd < 0 || simulation->wake_fd < 0 ||
+        pthread_create(&simulation->thread, NULL, run_simulation_thread, simulation) != 0) {
+        if (simulation->request_fd >= 0) close(simulation->request_fd);
+        if (simulation->wake_fd >= 0) close(simulation->wake_fd);
+        free(simulation);
+        return NULL;
+    }
+
+    return simulation;
+}
+
+void stop_simulation_thread(SimulationThread* simulation) {
+    if (!simulation) return;
+
+    __atomic_store_n(&simulation->stopping, true, __ATOMIC_RELEASE);
+    signal_fd(simulation->request_fd);
+    pthread_join(simulation->thread, NULL);
+
+    close(simulation->request_fd);
+    close(simulation->wake_fd);
+    free(simulation);
+}
+
+int get_simulation_wake_fd(const SimulationThread* simulation) {
+    return simulation->wake_fd;
+}
+
+// Main thread
+
+bool is_simulated_game(const ApplicationState* app) {
+    if (!app->simulation || !is_game_session_running(app)) {
+        return false;
+    }
+
+    const GameInterface* interface = get_current_game_interface(&app->game_manager);
+    return interface->update_game && interface->game_state_size <= SIMULATION_STATE_CAPACITY;
+}
+
+static uint64_t send_request(SimulationThread* simulation, uint64_t generation,
+                             const GameInterface* interface, const void* state) {
+    SimulationRequest* request = &simulation->requests[simulation->request_index.back];
+
+    request->ticket = ++simulation->next_ticket;
+    request->game_generation = generation;
+    request->interface = interface;
+    request->state_size = interface ? interface->game_state_size : 0;
+    if (interface) {
+        memcpy(request->state, state, request->state_size);
+    }
+
+    request->ai_job = simulation->ai_job;
+    request->board = simulation->ai_job_board;
+    request->ai_player = simulation->ai_player;
+    request->ai_difficulty = simulation->ai_difficulty;
+    request->ponder_job = simulation->ponder_job;
+    request->ponder_board = simulation->ponder_board;
+
+    publish_triple_slot(&simulation->request_index);
+    signal_fd(simulation->request_fd);
+
+    simulation->submitted = true;
+    simulation->submitted_generation = generation;
+    simulation->submitted_interface = interface;
+    return request->ticket;
+}
+
+void adopt_simulation_frame(ApplicationState* app) {
+    SimulationThread* simulation = app->simulation;
+    clear_fd(simulation->wake_fd);
+
+    if (acquire_triple_slot(&simulation->frame_index)) {
+        const SimulationFrame* frame = &simulation->frames[simulation->frame_index.front];
+        GameManager* manager = &app->game_manager;
+
+        // Only a frame stepped from the state the main thread still has
+        if (frame->interface && frame->interface == get_current_game_interface(manager) &&
+            frame->game_generation == manager->state_generation &&
+            frame->state_size == frame->interface->game_state_size) {
+            memcpy(manager->current_game_state, frame->state, frame->state_size);
+        }
+
+        if (frame->ai_job != 0 && frame->ai_job == simulation->ai_job) {
+            simulation->answered_ai_job = frame->ai_job;
+            simulation->answered_ai_move = frame->ai_move;
+            simulation->answered_ai_search_time = frame->ai_search_time;
+        }
+
+        if (frame->ponder_job != 0 && frame->ponder_job == simulation->ponder_job) {
+            memcpy(simulation->pondered_moves, frame->ponder_moves, sizeof(simulation->pondered_moves));
+            memcpy(simulation->pondered_times, frame->ponder_times, sizeof(simulation->pondered_times));
+        }
+    }
+
+    // Play a finished search once its board is back in play, unchanged
+    if (simulation->ai_job != 0 && simulation->answered_ai_job == simulation->ai_job &&
+        app->ai_thinking && app->current_state == STATE_PLAYING && app->game_mode == MODE_SINGLE_PLAYER &&
+        same_board(&app->game, &simulation->ai_job_board)) {
+        simulation->ai_job = 0;
+        perf_hud_record_ai_search_time(&app->perf_hud, simulation->answered_ai_search_time);
+        apply_ai_move(app, simulation->answered_ai_move);
+    }
+}
+
+void submit_simulation_work(ApplicationState* app) {
+    SimulationThread* simulation = app->simulation;
+    const GameManager* manager = &app->game_manager;
+
+    // A new search whenever the AI is to move on a board not yet asked about
+    bool ai_wanted = app->ai_thinking && app->current_state == STATE_PLAYING && app->game_mode == MODE_SINGLE_PLAYER;
+    bool new_job = ai_wanted && (simulation->ai_job == 0 || !same_board(&app->game, &simulation->ai_job_board));
+    if (new_job) {
+        simulation->ai_job = ++simulation->next_ai_job;
+        simulation->ai_job_board = app->game;
+        simulation->ai_player = app->ai_player;
+        simulation->ai_difficulty = app->ai_difficulty;
+    }
+
+    // Ponder whenever the human is to move on a board not yet pondered
+    bool ponder_wanted = simulation->pondering && app->current_state == STATE_PLAYING &&
+                         app->game_mode == MODE_SINGLE_PLAYER && !app->ai_thinking &&
+                         app->game.game_active && app->game.current_player == app->human_player;
+    bool new_ponder = ponder_wanted &&
+                      (simulation->ponder_job == 0 || !same_board(&app->game, &simulation->ponder_board) ||
+                       simulation->ai_player != app->ai_player || simulation->ai_difficulty != app->ai_difficulty);
+    if (new_ponder) {
+        simulation->ponder_job = ++simulation->next_ponder_job;
+        simulation->ponder_board = app->game;
+        simulation->ai_player = app->ai_player;
+        simulation->ai_difficulty = app->ai_difficulty;
+        for (int i = 0; i < 9; i++) {
+            simulation->pondered_moves[i] = PONDER_PENDING;
+        }
+    }
+
+    const GameInterface* interface = is_simulated_game(app) ? get_current_game_interface(manager) : NULL;
+    bool game_changed = !simulation->submitted ||
+                        simulation->submitted_generation != manager->state_generation ||
+                        simulation->submitted_interface != interface;
+
+    if (new_job || new_ponder || game_changed) {
+        send_request(simulation, manager->state_generation, interface, get_current_game_state(manager));
+    }
+}
+
+bool play_pondered_ai_move(ApplicationState* app) {
+    SimulationThread* simulation = app->simulation;
+    if (!simulation->ponder_job || !app->ai_thinking || app->ai_player != simulation->ai_player ||
+        app->ai_difficulty != simulation->ai_difficulty) {
+        return false;
+    }
+
+    int cell = find_reply_cell(&simulation->ponder_board, &app->game);
+    if (cell < 0 || simulation->pondered_moves[cell] == PONDER_PENDING) {
+        return false;
+    }
+
+    int move = simulation->pondered_moves[cell];
+    simulation->ponder_job = 0;
+    perf_hud_record_ai_search_time(&app->perf_hud, simulation->pondered_times[cell]);
+    apply_ai_move(app, move);
+    return true;
+}
+
+void release_simulation_game(SimulationThread* simulation) {
+    uint64_t ticket = send_request(simulation, simulation->submitted_generation, NULL, NULL);
+
+    // The thread takes requests between steps, so this waits for one step
+    // or one search at most
+    struct timespec pause = { 0, 100000 };
+    while (__atomic_load_n(&simulation->acknowledged_ticket, __ATOMIC_ACQUIRE) < ticket) {
+        nanosleep(&pause, NULL);
+    }
+}
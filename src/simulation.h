@@ -0,0 +1,51 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "game.h"
+#include <stdbool.h>
+
+// Fixed step of the simulation thread for games that update every frame
+#define SIMULATION_RATE_HZ 120
+#define SIMULATION_STEP_SECONDS (1.0 / SIMULATION_RATE_HZ)
+
+// Largest game state the thread carries; larger games update inline
+#define SIMULATION_STATE_CAPACITY 16384
+
+// Set to 1 to let the AI ponder: while the human is to move, the thread
+// searches its answer to every reply the human could make, likeliest
+// first, so the answer to the move actually made is usually ready
+#define SIMULATION_PONDER_ENV "TICTACTOE_PONDER"
+
+// The loaded game's update_game and the board's AI searches, on their own
+// thread. The main thread keeps the authoritative ApplicationState; the
+// two exchange whole states through a pair of lock-free triple buffers
+// (requests one way, completed frames the other), so neither waits for
+// the other. A frame built on a state the main thread has since changed
+// is ignored, and the thread restarts from the newer state.
+typedef struct SimulationThread SimulationThread;
+
+SimulationThread* start_simulation_thread(void);
+void stop_simulation_thread(SimulationThread* simulation);
+
+// Readable once a new frame has been published; the frame loop wakes on it
+int get_simulation_wake_fd(const SimulationThread* simulation);
+
+// True when the simulation thread, not update_frame, steps the loaded game;
+// false while it is paused off screen
+bool is_simulated_game(const ApplicationState* app);
+
+// Frame loop steps, main thread only: take the newest frame (and play a
+// finished AI move) before the frame is drawn, and send the state input
+// produced once it has been applied
+void adopt_simulation_frame(ApplicationState* app);
+void submit_simulation_work(ApplicationState* app);
+
+// Plays the AI's answer to the human's last move if pondering already
+// found it; returns false if the search still has to run
+bool play_pondered_ai_move(ApplicationState* app);
+
+// Blocks until the thread no longer runs the loaded game's code, so the
+// game can be unloaded. Only game switches wait.
+void release_simulation_game(SimulationThread* simulation);
+
+#endif
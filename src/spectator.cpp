@@ -0,0 +1,591 @@
+#include "spectator.h"
+#include "events.h"
+#include "render_target.h"
+#include "trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Largest encoded run: five varints of up to ten bytes
+#define SPECTATOR_MAX_RUN_SIZE 50
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+} SpectatorBuffer;
+
+typedef struct {
+    int width;
+    int height;
+    struct tb_cell* cells;
+} SpectatorScreen;
+
+typedef struct {
+    int fd;
+    SpectatorBuffer backlog;
+    size_t partial_length;   // Unsent tail of a message cut short at the front of the backlog
+} SpectatorViewer;
+
+struct SpectatorServer {
+    // Player thread: the last published frame
+    SpectatorScreen previous;
+
+    // Encoded messages waiting for the broadcast thread
+    pthread_mutex_t lock;
+    SpectatorBuffer pending;
+    int wake_fd;
+
+    // Broadcast thread
+    pthread_t thread;
+    bool stopping;
+    int listen_fd;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    SpectatorBuffer batch;       // Swapped with pending each round
+    SpectatorScreen mirror;      // The stream applied so far, for keyframes
+    SpectatorBuffer keyframe;
+    bool keyframe_current;       // keyframe matches mirror
+    SpectatorViewer viewers[SPECTATOR_MAX_VIEWERS];
+    int viewer_count;
+};
+
+// Buffers and encoding
+static bool reserve_buffer(SpectatorBuffer* buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) return true;
+
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+    while (capacity < buffer->length + extra) capacity *= 2;
+    unsigned char* data = (unsigned char*)realloc(buffer->data, capacity);
+    if (!data) return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool append_buffer(SpectatorBuffer* buffer, const unsigned char* data, size_t length) {
+    if (!reserve_buffer(buffer, length)) return false;
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    return true;
+}
+
+static void free_buffer(SpectatorBuffer* buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+static size_t put_varint(unsigned char* out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+static bool get_varint(const unsigned char** in, const unsigned char* end, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; *in < end && shift < 64; shift += 7) {
+        unsigned char byte = *(*in)++;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static void write_u16(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value & 0xff);
+    out[1] = (unsigned char)((value >> 8) & 0xff);
+}
+
+static void write_u32(unsigned char* out, uint32_t value) {
+    write_u16(out, value & 0xffff);
+    write_u16(out + 2, value >> 16);
+}
+
+static uint32_t read_u16(const unsigned char* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8);
+}
+
+static uint32_t read_u32(const unsigned char* in) {
+    return read_u16(in) | (read_u16(in + 2) << 16);
+}
+
+static size_t get_message_size(const unsigned char* message) {
+    return SPECTATOR_HEADER_SIZE + read_u32(message + 5);
+}
+
+static const struct tb_cell blank_cell = {' ', TB_DEFAULT, TB_DEFAULT};
+
+static bool same_cell(const struct tb_cell* a, const struct tb_cell* b) {
+    return a->ch == b->ch && a->fg == b->fg && a->bg == b->bg;
+}
+
+// Appends one message. With previous == NULL the frame is encoded as a
+// keyframe; otherwise only cells that differ from previous are, and
+// previous is updated to match. Returns the number of runs written.
+static int encode_spectator_frame(SpectatorBuffer* out, const struct tb_cell* cells,
+                                  struct tb_cell* previous, int width, int height) {
+    size_t cell_count = (size_t)width * (size_t)height;
+    if (!reserve_buffer(out, SPECTATOR_HEADER_SIZE)) return 0;
+
+    size_t header = out->length;
+    out->data[header] = previous ? SPECTATOR_DIFF : SPECTATOR_KEYFRAME;
+    write_u16(out->data + header + 1, (uint32_t)width);
+    write_u16(out->data + header + 3, (uint32_t)height);
+    out->length += SPECTATOR_HEADER_SIZE;
+
+    int runs = 0;
+    size_t skip = 0;
+    size_t i = 0;
+    while (i < cell_count) {
+        const struct tb_cell* base = previous ? &previous[i] : &blank_cell;
+        if (same_cell(&cells[i], base)) {
+            skip++;
+            i++;
+            continue;
+        }
+
+        // One run covers every following copy of this cell, changed or not
+        size_t count = 1;
+        while (i + count < cell_count && same_cell(&cells[i + count], &cells[i])) {
+            count++;
+        }
+
+        if (!reserve_buffer(out, SPECTATOR_MAX_RUN_SIZE)) break;
+        unsigned char* run = out->data + out->length;
+        size_t length = put_varint(run, skip);
+        length += put_varint(run + length, count);
+        length += put_varint(run + length, cells[i].ch);
+        length += put_varint(run + length, (uint64_t)cells[i].fg);
+        length += put_varint(run + length, (uint64_t)cells[i].bg);
+        out->length += length;
+        runs++;
+
+        if (previous) {
+            for (size_t j = 0; j < count; j++) previous[i + j] = cells[i];
+        }
+        skip = 0;
+        i += count;
+    }
+
+    write_u32(out->data + header + 5, (uint32_t)(out->length - header - SPECTATOR_HEADER_SIZE));
+    return runs;
+}
+
+static bool resize_screen(SpectatorScreen* screen, int width, int height) {
+    size_t cell_count = (size_t)width * (size_t)height;
+    if (width != screen->width || height != screen->height) {
+        struct tb_cell* cells = (struct tb_cell*)realloc(screen->cells, sizeof(struct tb_cell) * (cell_count ? cell_count : 1));
+        if (!cells) return false;
+        screen->cells = cells;
+        screen->width = width;
+        screen->height = height;
+    }
+    for (size_t i = 0; i < cell_count; i++) screen->cells[i] = blank_cell;
+    return true;
+}
+
+// Applies one complete message; false if it is malformed
+static bool apply_spectator_message(SpectatorScreen* screen, const unsigned char* message) {
+    int width = (int)read_u16(message + 1);
+    int height = (int)read_u16(message + 3);
+
+    if (message[0] == SPECTATOR_KEYFRAME) {
+        if (!resize_screen(screen, width, height)) return false;
+    } else if (message[0] != SPECTATOR_DIFF || width != screen->width || height != screen->height) {
+        return false;
+    }
+
+    size_t cell_count = (size_t)width * (size_t)height;
+    size_t position = 0;
+    const unsigned char* in = message + SPECTATOR_HEADER_SIZE;
+    const unsigned char* end = in + read_u32(message + 5);
+    while (in < end) {
+        uint64_t skip, count, ch, fg, bg;
+        if (!get_varint(&in, end, &skip) || !get_varint(&in, end, &count) || !get_varint(&in, end, &ch) ||
+            !get_varint(&in, end, &fg) || !get_varint(&in, end, &bg)) {
+            return false;
+        }
+        if (skip > cell_count - position || count > cell_count - position - skip) return false;
+
+        position += skip;
+        struct tb_cell cell = blank_cell;
+        cell.ch = (uint32_t)ch;
+        cell.fg = (uintattr_t)fg;
+        cell.bg = (uintattr_t)bg;
+        for (uint64_t i = 0; i < count; i++) screen->cells[position++] = cell;
+    }
+    return true;
+}
+
+// Broadcast thread
+static void drop_viewer(SpectatorServer* server, int index) {
+    close(server->viewers[index].fd);
+    free_buffer(&server->viewers[index].backlog);
+    server->viewers[index] = server->viewers[--server->viewer_count];
+}
+
+static const SpectatorBuffer* get_current_keyframe(SpectatorServer* server) {
+    if (!server->keyframe_current) {
+        server->keyframe.length = 0;
+        encode_spectator_frame(&server->keyframe, server->mirror.cells, NULL,
+                               server->mirror.width, server->mirror.height);
+        server->keyframe_current = true;
+    }
+    return &server->keyframe;
+}
+
+// Sends straight from the message when nothing is queued, so a viewer
+// that keeps up costs one send() and no copy. Returns false to drop.
+static bool queue_for_viewer(SpectatorServer* server, SpectatorViewer* viewer,
+                             const unsigned char* message, size_t length) {
+    if (viewer->backlog.length == 0) {
+        ssize_t sent = send(viewer->fd, message, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+            sent = 0;
+        }
+        if ((size_t)sent == length) return true;
+
+        viewer->partial_length = sent > 0 ? length - (size_t)sent : 0;
+        return append_buffer(&viewer->backlog, message + sent, length - (size_t)sent);
+    }
+
+    if (viewer->backlog.length + length <= SPECTATOR_BACKLOG_LIMIT) {
+        return append_buffer(&viewer->backlog, message, length);
+    }
+
+    // Too far behind: finish the message in flight, then skip to the
+    // current frame
+    const SpectatorBuffer* keyframe = get_current_keyframe(server);
+    if (viewer->partial_length + keyframe->length > SPECTATOR_BACKLOG_LIMIT) return false;
+    viewer->backlog.length = viewer->partial_length;
+    return append_buffer(&viewer->backlog, keyframe->data, keyframe->length);
+}
+
+static bool flush_viewer(SpectatorViewer* viewer) {
+    ssize_t sent = send(viewer->fd, viewer->backlog.data, viewer->backlog.length, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    // Find where the new front of the backlog falls within its message
+    size_t count = (size_t)sent;
+    if (count < viewer->partial_length) {
+        viewer->partial_length -= count;
+    } else {
+        size_t position = viewer->partial_length;
+        while (position < count) position += get_message_size(viewer->backlog.data + position);
+        viewer->partial_length = position - count;
+    }
+
+    memmove(viewer->backlog.data, viewer->backlog.data + count, viewer->backlog.length - count);
+    viewer->backlog.length -= count;
+    return true;
+}
+
+static void accept_viewers(SpectatorServer* server) {
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) return;
+
+        if (server->viewer_count == SPECTATOR_MAX_VIEWERS) {
+            close(fd);
+            continue;
+        }
+
+        SpectatorViewer* viewer = &server->viewers[server->viewer_count++];
+        memset(viewer, 0, sizeof(*viewer));
+        viewer->fd = fd;
+
+        // Until the first frame is published the stream itself starts with one
+        if (server->mirror.cells) {
+            const SpectatorBuffer* keyframe = get_current_keyframe(server);
+            if (!queue_for_viewer(server, viewer, keyframe->data, keyframe->length)) {
+                drop_viewer(server, server->viewer_count - 1);
+            }
+        }
+    }
+}
+
+static void broadcast_batch(SpectatorServer* server) {
+    size_t offset = 0;
+    while (offset + SPECTATOR_HEADER_SIZE <= server->batch.length) {
+        const unsigned char* message = server->batch.data + offset;
+        size_t length = get_message_size(message);
+
+        apply_spectator_message(&server->mirror, message);
+        server->keyframe_current = false;
+
+        for (int i = server->viewer_count - 1; i >= 0; i--) {
+            if (!queue_for_viewer(server, &server->viewers[i], message, length)) {
+                drop_viewer(server, i);
+            }
+        }
+        offset += length;
+    }
+    server->batch.length = 0;
+}
+
+static void* spectator_thread_main(void* argument) {
+    SpectatorServer* server = (SpectatorServer*)argument;
+    TRACE_THREAD_NAME("spectator broadcast");
+
+    struct pollfd fds[2 + SPECTATOR_MAX_VIEWERS];
+    while (!__atomic_load_n(&server->stopping, __ATOMIC_ACQUIRE)) {
+        fds[0].fd = server->listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = server->wake_fd;
+        fds[1].events = POLLIN;
+        int viewer_count = server->viewer_count;
+        for (int i = 0; i < viewer_count; i++) {
+            fds[2 + i].fd = server->viewers[i].fd;
+            fds[2 + i].events = POLLIN | (server->viewers[i].backlog.length ? POLLOUT : 0);
+        }
+
+        if (poll(fds, 2 + viewer_count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Viewers never send; readable means closed
+        for (int i = viewer_count - 1; i >= 0; i--) {
+            short revents = fds[2 + i].revents;
+            if ((revents & (POLLIN | POLLHUP | POLLERR)) ||
+                ((revents & POLLOUT) && !flush_viewer(&server->viewers[i]))) {
+                drop_viewer(server, i);
+            }
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            (void)!read(server->wake_fd, &count, sizeof(count));
+
+            pthread_mutex_lock(&server->lock);
+            SpectatorBuffer swap = server->pending;
+            server->pending = server->batch;
+            server->batch = swap;
+            pthread_mutex_unlock(&server->lock);
+
+            TRACE_SCOPE("spectator_broadcast");
+            broadcast_batch(server);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            accept_viewers(server);
+        }
+    }
+    return NULL;
+}
+
+// Player side
+SpectatorServer* start_spectator_server(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    if (strlen(path) == 0 || strlen(path) >= sizeof(address.sun_path)) {
+        return NULL;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    SpectatorServer* server = (SpectatorServer*)calloc(1, sizeof(SpectatorServer));
+    if (!server) return NULL;
+    strcpy(server->path, path);
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    server->wake_fd = eventfd(0, EFD_NONBLOCK);
+
+    // Only a stale socket is replaced; any other file makes bind fail
+    struct stat info;
+    if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path);
+    }
+    if (server->listen_fd < 0 || server->wake_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(server->listen_fd, SOMAXCONN) != 0) {
+        if (server->listen_fd >= 0) close(server->listen_fd);
+        if (server->wake_fd >= 0) close(server->wake_fd);
+        free(server);
+        return NULL;
+    }
+
+    pthread_mutex_init(&server->lock, NULL);
+    if (pthread_create(&server->thread, NULL, spectator_thread_main, server) != 0) {
+        pthread_mutex_destroy(&server->lock);
+        close(server->listen_fd);
+        close(server->wake_fd);
+        unlink(path);
+        free(server);
+        return NULL;
+    }
+    return server;
+}
+
+void publish_spectator_frame(SpectatorServer* server, const struct tb_cell* cells, int width, int height) {
+    TRACE_SCOPE("publish_spectator_frame");
+    if (!server || !cells || width <= 0 || height <= 0 || width > 0xffff || height > 0xffff) return;
+
+    bool keyframe = width != server->previous.width || height != server->previous.height;
+    if (keyframe && !resize_screen(&server->previous, width, height)) return;
+
+    // Encoded in place; the broadcast thread holds the lock only to swap buffers
+    pthread_mutex_lock(&server->lock);
+    size_t start = server->pending.length;
+    int runs = encode_spectator_frame(&server->pending, cells, keyframe ? NULL : server->previous.cells,
+                                      width, height);
+    if (keyframe) {
+        memcpy(server->previous.cells, cells, sizeof(struct tb_cell) * (size_t)width * (size_t)height);
+    } else if (runs == 0) {
+        server->pending.length = start;
+    }
+    bool wake = start == 0 && server->pending.length > 0;
+    pthread_mutex_unlock(&server->lock);
+
+    if (wake) {
+        uint64_t one = 1;
+        (void)!write(server->wake_fd, &one, sizeof(one));
+    }
+}
+
+void stop_spectator_server(SpectatorServer* server) {
+    if (!server) return;
+
+    __atomic_store_n(&server->stopping, true, __ATOMIC_RELEASE);
+    uint64_t one = 1;
+    (void)!write(server->wake_fd, &one, sizeof(one));
+    pthread_join(server->thread, NULL);
+
+    while (server->viewer_count > 0) drop_viewer(server, server->viewer_count - 1);
+    close(server->listen_fd);
+    close(server->wake_fd);
+    unlink(server->path);
+    pthread_mutex_destroy(&server->lock);
+
+    free(server->previous.cells);
+    free(server->mirror.cells);
+    free_buffer(&server->pending);
+    free_buffer(&server->batch);
+    free_buffer(&server->keyframe);
+    free(server);
+}
+
+// Viewer
+static void draw_spectator_screen(const SpectatorScreen* screen) {
+    render_target_clear();
+    int width = screen->width < render_target_width() ? screen->width : render_target_width();
+    int height = screen->height < render_target_height() ? screen->height : render_target_height();
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const struct tb_cell* cell = &screen->cells[y * screen->width + x];
+            render_target_set_cell(x, y, cell->ch, cell->fg, cell->bg);
+        }
+    }
+    render_target_present();
+}
+
+static bool wants_to_stop_watching(const InputBatch* batch) {
+    for (int i = 0; i < batch->raw_event_count; i++) {
+        const struct tb_event* event = &batch->raw_events[i];
+        if (event->type == TB_EVENT_KEY &&
+            (event->key == TB_KEY_ESC || event->ch == 'q' || event->ch == 'Q')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int run_spectator_viewer(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    if (strlen(path) == 0 || strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Invalid socket path '%s'\n", path);
+        return 2;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        perror("watch");
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    if (tb_init() != 0) {
+        fprintf(stderr, "Failed to initialize termbox\n");
+        close(fd);
+        return 1;
+    }
+    tb_hide_cursor();
+
+    SpectatorScreen screen = {0, 0, NULL};
+    SpectatorBuffer in = {NULL, 0, 0};
+    const char* ending = NULL;
+
+    while (!ending) {
+        InputBatch batch;
+        if (!collect_input_batch(&batch, 0.0, -1.0, fd)) {
+            ending = "Input failed";
+            break;
+        }
+        if (wants_to_stop_watching(&batch)) break;
+
+        bool redraw = batch.raw_event_count > 0;   // e.g. a resize
+        for (;;) {
+            if (!reserve_buffer(&in, 65536)) {
+                ending = "Out of memory";
+                break;
+            }
+            ssize_t count = recv(fd, in.data + in.length, in.capacity - in.length, MSG_DONTWAIT);
+            if (count == 0) {
+                ending = "The game ended the stream";
+                break;
+            }
+            if (count < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) ending = "Connection lost";
+                break;
+            }
+            in.length += (size_t)count;
+        }
+
+        size_t offset = 0;
+        while (in.length - offset >= SPECTATOR_HEADER_SIZE &&
+               in.length - offset >= get_message_size(in.data + offset)) {
+            if (!apply_spectator_message(&screen, in.data + offset)) {
+                ending = "Malformed stream";
+                break;
+            }
+            offset += get_message_size(in.data + offset);
+            redraw = true;
+        }
+        memmove(in.data, in.data + offset, in.length - offset);
+        in.length -= offset;
+
+        if (redraw && screen.cells) {
+            draw_spectator_screen(&screen);
+        }
+    }
+
+    tb_shutdown();
+    close(fd);
+    free(screen.cells);
+    free_buffer(&in);
+    if (ending) {
+        fprintf(stderr, "%s\n", ending);
+    }
+    return 0;
+}
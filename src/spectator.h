@@ -0,0 +1,41 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "../lib/termbox2/termbox2.h"
+#include <stdbool.h>
+
+// Stream format: messages back to back, integers little-endian.
+//   header   u8 type, u16 width, u16 height, u32 payload length
+//   payload  runs until the length is used up, each five LEB128 varints:
+//            skip, count, ch, fg, bg
+// A run leaves `skip` cells alone, then writes `count` copies of one cell,
+// walking the screen row by row. A keyframe starts from a blank screen of
+// its size; a diff changes the previous frame.
+#define SPECTATOR_KEYFRAME 'K'
+#define SPECTATOR_DIFF 'D'
+#define SPECTATOR_HEADER_SIZE 9
+
+// A viewer whose unsent backlog would grow past this is resynced: its
+// queued diffs are dropped for one keyframe. If even that does not fit,
+// the viewer is disconnected.
+#define SPECTATOR_BACKLOG_LIMIT (256 * 1024)
+#define SPECTATOR_MAX_VIEWERS 64
+
+typedef struct SpectatorServer SpectatorServer;
+
+// Listens on a Unix socket; viewers are served from a background thread.
+// Returns NULL if the socket cannot be opened.
+SpectatorServer* start_spectator_server(const char* path);
+
+// Called once per presented frame. Diffs against the last published frame
+// and queues the encoded diff for the broadcast thread; the cost does not
+// depend on how many viewers are connected.
+void publish_spectator_frame(SpectatorServer* server, const struct tb_cell* cells, int width, int height);
+
+void stop_spectator_server(SpectatorServer* server);
+
+// Connects to a spectator socket and draws the stream in this terminal
+// until it ends or Q/Esc is pressed
+int run_spectator_viewer(const char* path);
+
+#endif
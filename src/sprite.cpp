@@ -0,0 +1,184 @@
+#include "sprite.h"
+#include "render_target.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATIC_TEXT_CACHE_SIZE 128  // Power of two
+#define CACHED_TEXT_MAX_LENGTH 256
+
+typedef struct {
+    const char* text;
+    Sprite sprite;
+} StaticTextEntry;
+
+static StaticTextEntry static_text_cache[STATIC_TEXT_CACHE_SIZE];
+
+// Number of codepoints in one line of UTF-8 text
+static int utf8_length(const char* text) {
+    int length = 0;
+    while (*text) {
+        int bytes = tb_utf8_char_length(*text);
+        for (int i = 0; i < bytes && *text; i++) {
+            text++;
+        }
+        length++;
+    }
+    return length;
+}
+
+void init_sprite(Sprite* sprite) {
+    sprite->width = 0;
+    sprite->height = 0;
+    sprite->glyphs = NULL;
+    sprite->fg = NULL;
+    sprite->bg = NULL;
+}
+
+void free_sprite(Sprite* sprite) {
+    free(sprite->glyphs);
+    free(sprite->fg);
+    free(sprite->bg);
+    init_sprite(sprite);
+}
+
+bool build_sprite(Sprite* sprite, const char* const* lines, int line_count, uintattr_t fg, uintattr_t bg) {
+    free_sprite(sprite);
+
+    int width = 0;
+    for (int i = 0; i < line_count; i++) {
+        int length = utf8_length(lines[i]);
+        if (length > width) width = length;
+    }
+
+    size_t cell_count = (size_t)width * (size_t)line_count;
+    if (cell_count == 0) {
+        return true;
+    }
+
+    sprite->glyphs = (uint32_t*)malloc(cell_count * sizeof(uint32_t));
+    sprite->fg = (uintattr_t*)malloc(cell_count * sizeof(uintattr_t));
+    sprite->bg = (uintattr_t*)malloc(cell_count * sizeof(uintattr_t));
+    if (!sprite->glyphs || !sprite->fg || !sprite->bg) {
+        free_sprite(sprite);
+        return false;
+    }
+
+    sprite->width = width;
+    sprite->height = line_count;
+
+    for (int row = 0; row < line_count; row++) {
+        const char* text = lines[row];
+        uint32_t* glyphs = sprite->glyphs + row * width;
+
+        int col = 0;
+        while (*text && col < width) {
+            uint32_t codepoint;
+            int bytes = tb_utf8_char_to_unicode(&codepoint, text);
+            if (bytes <= 0) break;
+            glyphs[col++] = codepoint;
+            text += bytes;
+        }
+        while (col < width) {
+            glyphs[col++] = ' ';
+        }
+    }
+
+    for (size_t i = 0; i < cell_count; i++) {
+        sprite->fg[i] = fg;
+        sprite->bg[i] = bg;
+    }
+
+    return true;
+}
+
+// Shared clipping loop; attrs_override selects sprite or caller attributes
+static void blit_cells(const Sprite* sprite, int x, int y, bool attrs_override,
+                       uintattr_t fg, uintattr_t bg) {
+    struct tb_cell* buffer = render_target_cells();
+    int screen_width = render_target_width();
+    int screen_height = render_target_height();
+
+    if (!buffer || !sprite->glyphs) return;
+
+    int col_start = (x < 0) ? -x : 0;
+    int col_end = sprite->width;
+    if (x + col_end > screen_width) col_end = screen_width - x;
+
+    for (int row = 0; row < sprite->height; row++) {
+        int screen_y = y + row;
+        if (screen_y < 0) continue;
+        if (screen_y >= screen_height) break;
+
+        struct tb_cell* row_cells = buffer + screen_y * screen_width;
+        int src_offset = row * sprite->width;
+
+        for (int col = col_start; col < col_end; col++) {
+            struct tb_cell* dst = &row_cells[x + col];
+            dst->ch = sprite->glyphs[src_offset + col];
+            dst->fg = attrs_override ? fg : sprite->fg[src_offset + col];
+            dst->bg = attrs_override ? bg : sprite->bg[src_offset + col];
+        }
+    }
+}
+
+void blit_sprite(const Sprite* sprite, int x, int y) {
+    blit_cells(sprite, x, y, false, TB_DEFAULT, TB_DEFAULT);
+}
+
+void blit_sprite_with_attrs(const Sprite* sprite, int x, int y, uintattr_t fg, uintattr_t bg) {
+    blit_cells(sprite, x, y, true, fg, bg);
+}
+
+static const Sprite* lookup_static_text(const char* text) {
+    uintptr_t hash = ((uintptr_t)text >> 3) * 2654435761u;
+
+    for (int probe = 0; probe < STATIC_TEXT_CACHE_SIZE; probe++) {
+        StaticTextEntry* entry = &static_text_cache[(hash + probe) & (STATIC_TEXT_CACHE_SIZE - 1)];
+
+        if (entry->text == text) {
+            return &entry->sprite;
+        }
+        if (!entry->text) {
+            init_sprite(&entry->sprite);
+            if (!build_sprite(&entry->sprite, &text, 1, TB_DEFAULT, TB_DEFAULT)) {
+                return NULL;
+            }
+            entry->text = text;
+            return &entry->sprite;
+        }
+    }
+
+    return NULL;  // Cache full
+}
+
+void blit_static_text(int x, int y, uintattr_t fg, uintattr_t bg, const char* text) {
+    const Sprite* sprite = lookup_static_text(text);
+    if (sprite) {
+        blit_sprite_with_attrs(sprite, x, y, fg, bg);
+    } else {
+        render_target_print(x, y, fg, bg, text);
+    }
+}
+
+const Sprite* update_cached_text(CachedText* cache, uint64_t key, const char* format, ...) {
+    if (cache->valid && cache->key == key) {
+        return &cache->sprite;
+    }
+
+    char buffer[CACHED_TEXT_MAX_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    const char* line = buffer;
+    if (!cache->valid) {
+        init_sprite(&cache->sprite);
+    }
+    cache->valid = build_sprite(&cache->sprite, &line, 1, TB_DEFAULT, TB_DEFAULT);
+    cache->key = key;
+
+    return &cache->sprite;
+}
@@ -0,0 +1,41 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../lib/termbox2/termbox2.h"
+
+// Pre-decoded block of text: one codepoint and attribute pair per cell
+typedef struct {
+    int width;
+    int height;
+    uint32_t* glyphs;   // width * height codepoints, rows padded with spaces
+    uintattr_t* fg;
+    uintattr_t* bg;
+} Sprite;
+
+// Formatted text that is re-decoded only when its key changes
+typedef struct {
+    bool valid;
+    uint64_t key;
+    Sprite sprite;
+} CachedText;
+
+// Sprite construction (decodes UTF-8 once)
+void init_sprite(Sprite* sprite);
+bool build_sprite(Sprite* sprite, const char* const* lines, int line_count, uintattr_t fg, uintattr_t bg);
+void free_sprite(Sprite* sprite);
+
+// Copies cells straight into the screen buffer, clipped to the screen
+void blit_sprite(const Sprite* sprite, int x, int y);
+void blit_sprite_with_attrs(const Sprite* sprite, int x, int y, uintattr_t fg, uintattr_t bg);
+
+// Draws an immutable string (literal or static table entry). The string is
+// decoded on first use and cached by address, so it must never change.
+void blit_static_text(int x, int y, uintattr_t fg, uintattr_t bg, const char* text);
+
+// Rebuilds the text only if key differs from the previous call
+const Sprite* update_cached_text(CachedText* cache, uint64_t key, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#endif
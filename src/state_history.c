@@ -0,0 +1,114 @@
+#include "state_history.h"
+#include <stdlib.h>
+
+// Keeps every block aligned for any game state struct
+static size_t align_block_size(size_t size) {
+    size_t alignment = sizeof(max_align_t);
+    if (size == 0) size = 1;
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+bool init_state_pool(StatePool* pool, size_t block_size) {
+    pool->block_size = align_block_size(block_size);
+    pool->free_count = 0;
+    pool->arena = (unsigned char*)malloc(pool->block_size * STATE_POOL_BLOCK_COUNT);
+    if (!pool->arena) {
+        pool->block_size = 0;
+        return false;
+    }
+
+    for (int i = STATE_POOL_BLOCK_COUNT - 1; i >= 0; i--) {
+        pool->free_blocks[pool->free_count++] = pool->arena + (size_t)i * pool->block_size;
+    }
+    return true;
+}
+
+void cleanup_state_pool(StatePool* pool) {
+    free(pool->arena);
+    pool->arena = NULL;
+    pool->block_size = 0;
+    pool->free_count = 0;
+}
+
+void* acquire_state_block(StatePool* pool) {
+    if (pool->free_count == 0) {
+        return NULL;
+    }
+    return pool->free_blocks[--pool->free_count];
+}
+
+void release_state_block(StatePool* pool, void* block) {
+    if (block && pool->free_count < STATE_POOL_BLOCK_COUNT) {
+        pool->free_blocks[pool->free_count++] = block;
+    }
+}
+
+static void** ring_slot(SnapshotRing* ring, int index) {
+    return &ring->slots[(ring->head + index) % STATE_HISTORY_CAPACITY];
+}
+
+void init_snapshot_ring(SnapshotRing* ring) {
+    ring->head = 0;
+    ring->count = 0;
+    ring->undo_count = 0;
+}
+
+void clear_snapshot_ring(SnapshotRing* ring, StatePool* pool) {
+    for (int i = 0; i < ring->count; i++) {
+        release_state_block(pool, *ring_slot(ring, i));
+    }
+    init_snapshot_ring(ring);
+}
+
+void push_snapshot(SnapshotRing* ring, StatePool* pool, void* snapshot) {
+    // A new move invalidates everything that was undone
+    for (int i = ring->undo_count; i < ring->count; i++) {
+        release_state_block(pool, *ring_slot(ring, i));
+    }
+    ring->count = ring->undo_count;
+
+    // Full ring: forget the oldest move
+    if (ring->count == STATE_HISTORY_CAPACITY) {
+        release_state_block(pool, *ring_slot(ring, 0));
+        ring->head = (ring->head + 1) % STATE_HISTORY_CAPACITY;
+        ring->count--;
+        ring->undo_count--;
+    }
+
+    *ring_slot(ring, ring->count) = snapshot;
+    ring->count++;
+    ring->undo_count++;
+}
+
+bool can_undo_snapshot(const SnapshotRing* ring) {
+    return ring->undo_count > 0;
+}
+
+bool can_redo_snapshot(const SnapshotRing* ring) {
+    return ring->undo_count < ring->count;
+}
+
+// Returns the state to make live; the old live state takes its slot
+void* swap_undo_snapshot(SnapshotRing* ring, void* live_state) {
+    if (!can_undo_snapshot(ring)) {
+        return live_state;
+    }
+
+    ring->undo_count--;
+    void** slot = ring_slot(ring, ring->undo_count);
+    void* previous = *slot;
+    *slot = live_state;
+    return previous;
+}
+
+void* swap_redo_snapshot(SnapshotRing* ring, void* live_state) {
+    if (!can_redo_snapshot(ring)) {
+        return live_state;
+    }
+
+    void** slot = ring_slot(ring, ring->undo_count);
+    void* next = *slot;
+    *slot = live_state;
+    ring->undo_count++;
+    return next;
+}
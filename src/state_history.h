@@ -0,0 +1,47 @@
+#ifndef STATE_HISTORY_H
+#define STATE_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Moves kept for undo; older ones are dropped
+#define STATE_HISTORY_CAPACITY 64
+
+// Live state, pending snapshot, plus the undo/redo ring
+#define STATE_POOL_BLOCK_COUNT (STATE_HISTORY_CAPACITY + 2)
+
+// Fixed-size block allocator for game states. One arena is allocated up
+// front; acquiring and releasing a block only touches the free list.
+typedef struct {
+    unsigned char* arena;
+    size_t block_size;
+    void* free_blocks[STATE_POOL_BLOCK_COUNT];
+    int free_count;
+} StatePool;
+
+// Ring of state snapshots. Slots [0, undo_count) hold earlier states
+// (oldest first) and slots [undo_count, count) hold undone states, the next
+// redo first. Undo and redo swap the live pointer with one slot.
+typedef struct {
+    void* slots[STATE_HISTORY_CAPACITY];
+    int head;         // Physical index of logical slot 0
+    int count;
+    int undo_count;
+} SnapshotRing;
+
+// Pool
+bool init_state_pool(StatePool* pool, size_t block_size);
+void cleanup_state_pool(StatePool* pool);
+void* acquire_state_block(StatePool* pool);
+void release_state_block(StatePool* pool, void* block);
+
+// History
+void init_snapshot_ring(SnapshotRing* ring);
+void clear_snapshot_ring(SnapshotRing* ring, StatePool* pool);
+void push_snapshot(SnapshotRing* ring, StatePool* pool, void* snapshot);
+bool can_undo_snapshot(const SnapshotRing* ring);
+bool can_redo_snapshot(const SnapshotRing* ring);
+void* swap_undo_snapshot(SnapshotRing* ring, void* live_state);
+void* swap_redo_snapshot(SnapshotRing* ring, void* live_state);
+
+#endif
@@ -0,0 +1,18 @@
+#include "timing.h"
+#include <time.h>
+
+static double virtual_time = -1.0;
+
+double get_system_monotonic_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+double get_monotonic_time(void) {
+    return (virtual_time >= 0.0) ? virtual_time : get_system_monotonic_time();
+}
+
+void set_virtual_time(double seconds) {
+    virtual_time = seconds;
+}
@@ -0,0 +1,15 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+// Monotonic clock in seconds (unaffected by wall-clock changes). During
+// replay playback this is the recorded time instead.
+double get_monotonic_time(void);
+
+// Always the real clock, for measuring replays themselves
+double get_system_monotonic_time(void);
+
+// Drives get_monotonic_time from a replay; a negative time restores the
+// real clock
+void set_virtual_time(double seconds);
+
+#endif
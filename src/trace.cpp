@@ -0,0 +1,210 @@
+#include "trace.h"
+
+#ifdef TICTACTOE_TRACE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} TraceEvent;
+
+// Single producer (the owning thread), single consumer (the flusher)
+typedef struct TraceRing {
+    TraceEvent events[TRACE_RING_EVENTS];
+    uint32_t head;              // Next write; owner only
+    uint32_t tail;              // Next read; flusher only
+    unsigned long dropped;
+    int thread_id;
+    const char* thread_name;
+    bool name_written;
+    struct TraceRing* next;
+} TraceRing;
+
+bool trace_enabled = false;
+
+static FILE* trace_file = NULL;
+static uint64_t trace_origin_ns = 0;
+static bool trace_wrote_event = false;
+
+static pthread_mutex_t ring_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceRing* ring_list = NULL;
+static int next_thread_id = 1;
+
+static pthread_t flusher_thread;
+static pthread_mutex_t flusher_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flusher_wake = PTHREAD_COND_INITIALIZER;
+static bool flusher_stopping = false;
+
+static thread_local TraceRing* local_ring = NULL;
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Registered once per thread; rings live until exit so the flusher never
+// sees one disappear
+static TraceRing* get_local_ring(void) {
+    if (local_ring) return local_ring;
+
+    TraceRing* ring = (TraceRing*)calloc(1, sizeof(TraceRing));
+    if (!ring) return NULL;
+
+    pthread_mutex_lock(&ring_list_lock);
+    ring->thread_id = next_thread_id++;
+    ring->next = ring_list;
+    ring_list = ring;
+    pthread_mutex_unlock(&ring_list_lock);
+
+    local_ring = ring;
+    return ring;
+}
+
+void trace_record_span(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    TraceRing* ring = get_local_ring();
+    if (!ring) return;
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= TRACE_RING_EVENTS) {
+        ring->dropped++;
+        return;
+    }
+
+    TraceEvent* event = &ring->events[head % TRACE_RING_EVENTS];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->end_ns = end_ns;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    // Busy thread: flush early rather than wait out the interval
+    if (head - tail == TRACE_RING_EVENTS / 2) {
+        pthread_cond_signal(&flusher_wake);
+    }
+}
+
+void trace_set_thread_name(const char* name) {
+    if (!__atomic_load_n(&trace_enabled, __ATOMIC_RELAXED)) return;
+
+    TraceRing* ring = get_local_ring();
+    if (ring) {
+        __atomic_store_n(&ring->thread_name, name, __ATOMIC_RELEASE);
+    }
+}
+
+static void write_separator(void) {
+    if (trace_wrote_event) fputs(",\n", trace_file);
+    trace_wrote_event = true;
+}
+
+static void drain_ring(TraceRing* ring) {
+    const char* thread_name = __atomic_load_n(&ring->thread_name, __ATOMIC_ACQUIRE);
+    if (thread_name && !ring->name_written) {
+        write_separator();
+        fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                ring->thread_id, thread_name);
+        ring->name_written = true;
+    }
+
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring->tail;
+
+    for (; tail != head; tail++) {
+        const TraceEvent* event = &ring->events[tail % TRACE_RING_EVENTS];
+        write_separator();
+        fprintf(trace_file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                event->name, ring->thread_id,
+                (double)(event->start_ns - trace_origin_ns) / 1e3,
+                (double)(event->end_ns - event->start_ns) / 1e3);
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+}
+
+static void drain_all_rings(void) {
+    pthread_mutex_lock(&ring_list_lock);
+    TraceRing* rings = ring_list;
+    pthread_mutex_unlock(&ring_list_lock);
+
+    // New rings are pushed at the front, so this list stays valid
+    for (TraceRing* ring = rings; ring; ring = ring->next) {
+        drain_ring(ring);
+    }
+    fflush(trace_file);
+}
+
+static void* trace_flusher_main(void* arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&flusher_lock);
+    while (!flusher_stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += TRACE_FLUSH_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&flusher_wake, &flusher_lock, &deadline);
+
+        pthread_mutex_unlock(&flusher_lock);
+        drain_all_rings();
+        pthread_mutex_lock(&flusher_lock);
+    }
+    pthread_mutex_unlock(&flusher_lock);
+    return NULL;
+}
+
+static void stop_tracing(void) {
+    if (!trace_file) return;
+
+    __atomic_store_n(&trace_enabled, false, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&flusher_lock);
+    flusher_stopping = true;
+    pthread_cond_signal(&flusher_wake);
+    pthread_mutex_unlock(&flusher_lock);
+    pthread_join(flusher_thread, NULL);
+
+    drain_all_rings();
+
+    unsigned long dropped = 0;
+    for (TraceRing* ring = ring_list; ring; ring = ring->next) {
+        dropped += ring->dropped;
+    }
+    fprintf(trace_file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":%lu}}\n", dropped);
+    fclose(trace_file);
+    trace_file = NULL;
+}
+
+void start_tracing_from_environment(void) {
+    const char* path = getenv(TRACE_OUTPUT_ENV);
+    if (!path || !*path || trace_file) return;
+
+    trace_file = fopen(path, "w");
+    if (!trace_file) {
+        fprintf(stderr, "Cannot write trace to %s\n", path);
+        return;
+    }
+
+    fputs("{\"traceEvents\":[\n", trace_file);
+    trace_origin_ns = trace_now_ns();
+
+    if (pthread_create(&flusher_thread, NULL, trace_flusher_main, NULL) != 0) {
+        fclose(trace_file);
+        trace_file = NULL;
+        return;
+    }
+
+    __atomic_store_n(&trace_enabled, true, __ATOMIC_RELAXED);
+    trace_set_thread_name("main");
+    atexit(stop_tracing);
+}
+
+#endif
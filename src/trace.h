@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Span tracing with Chrome/Perfetto JSON output (chrome://tracing,
+// ui.perfetto.dev). Built only with `make TRACE=1`; otherwise every macro
+// below expands to nothing. A traced build records only when
+// $TICTACTOE_TRACE names an output file.
+//
+// Each thread appends complete spans to its own lock-free ring; a
+// background thread drains the rings into the file, so the traced thread
+// makes no syscalls beyond an occasional wake-up when its ring is half
+// full. Spans are dropped (and counted) if a ring fills anyway.
+#define TRACE_OUTPUT_ENV "TICTACTOE_TRACE"
+#define TRACE_RING_EVENTS 65536
+#define TRACE_FLUSH_INTERVAL_MS 50
+
+#ifdef TICTACTOE_TRACE
+
+#include <stdint.h>
+
+extern bool trace_enabled;
+
+uint64_t trace_now_ns(void);
+void trace_record_span(const char* name, uint64_t start_ns, uint64_t end_ns);
+void trace_set_thread_name(const char* name);
+
+// Starts the flusher if $TICTACTOE_TRACE is set; the file is finished at exit
+void start_tracing_from_environment(void);
+
+// Names must be string literals: only the pointer is stored
+struct TraceScope {
+    const char* name;
+    uint64_t start_ns;
+
+    explicit TraceScope(const char* span_name)
+        : name(span_name), start_ns(__atomic_load_n(&trace_enabled, __ATOMIC_RELAXED) ? trace_now_ns() : 0) {}
+
+    ~TraceScope() {
+        if (start_ns) trace_record_span(name, start_ns, trace_now_ns());
+    }
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+#define TRACE_START() start_tracing_from_environment()
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_START() ((void)0)
+
+#endif
+
+#endif